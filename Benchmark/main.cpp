@@ -0,0 +1,231 @@
+//
+//  main.cpp
+//  Cellular Automaton
+//
+//	Throughput benchmarks of the simulation engine of ../Engine (see
+//	Engine/benchmark.h), without any window.  It measures the engine's own
+//	strategies, not the programs of Version1, Version2 and Version3.
+//
+// Whole matrix (boards of 64 x 64 to 16384 x 16384, 1 thread to all cores, every workload):
+//                                     ./bench [-o <json path, default benchmark.json>]
+// Part of it:                         ./bench [-v <strategies, as serial,banded,async>] [-z <sizes, as 64,1024>]
+//                                             [-t <thread counts, as 1,2,4>] [-w <workloads, as soup,rpentomino,stilllife>]
+//                                             [-d <soup densities, as 0.1,0.5>] [-S <soup seed>] ...
+// Runs of each case:                  ./bench [-u <warmup runs>] [-n <measured runs>] [-T <seconds per run>] ...
+// g++ -Wall -std=c++20 main.cpp ../Engine/libcellengine.a -o bench
+//
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+//
+#include "../Engine/benchmark.h"
+
+//==================================================================================
+//	Function prototypes
+//==================================================================================
+bool parseWordList(const char* text, std::vector<std::string>* words);
+bool parseCountList(const char* text, unsigned int min, unsigned int max, std::vector<unsigned int>* counts);
+bool parseCount(const char* text, unsigned int min, unsigned int max, unsigned int* count);
+
+const char* USAGE = "[-o <json path>] [-v <strategies>] [-z <sizes>] [-t <thread counts>] [-w <workloads>] "
+					"[-d <densities>] [-S <seed>] [-u <warmup runs>] [-n <measured runs>] [-T <seconds per run>]";
+
+
+//------------------------------------------------------------------------
+//	main function
+//------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	if (argc % 2 == 0)
+	{
+		std::cerr << "Usage: " << argv[0] << " " << USAGE << "\n";
+		return 1;
+	}
+
+	BenchmarkOptions options;
+	defaultBenchmarkOptions(&options);
+	const char* jsonPath = "benchmark.json";
+	std::vector<std::string> words;
+
+	for (int arg = 1; arg < argc; arg += 2)
+	{
+		const char* option = argv[arg];
+		const char* value = argv[arg + 1];
+		if (strcmp(option, "-o") == 0)
+			jsonPath = value;
+		else if (strcmp(option, "-v") == 0)
+		{
+			options.strategies.clear();
+			bool valid = parseWordList(value, &words);
+			for (const std::string& word : words)
+			{
+				ExecutionStrategy strategy = STRATEGY_SERIAL;
+				valid = valid && parseStrategy(word.c_str(), &strategy);
+				options.strategies.push_back(strategy);
+			}
+			if (!valid)
+			{
+				std::cerr << "Invalid arguments. The strategies must be a list of serial, banded, wavefront, or async.\n";
+				return 1;
+			}
+		}
+		else if (strcmp(option, "-z") == 0)
+		{
+			if (!parseCountList(value, 6, UINT_MAX, &options.sizes))
+			{
+				std::cerr << "Invalid arguments. The sizes must be a list of numbers larger than 5.\n";
+				return 1;
+			}
+		}
+		else if (strcmp(option, "-t") == 0)
+		{
+			if (!parseCountList(value, 1, MAX_NUM_THREADS, &options.threadCounts))
+			{
+				std::cerr << "Invalid arguments. The thread counts must be a list of numbers from 1 to "
+						  << MAX_NUM_THREADS << ".\n";
+				return 1;
+			}
+		}
+		else if (strcmp(option, "-w") == 0)
+		{
+			options.workloads.clear();
+			bool valid = parseWordList(value, &words);
+			for (const std::string& word : words)
+			{
+				BenchmarkWorkload workload = WORKLOAD_SOUP;
+				valid = valid && parseWorkload(word.c_str(), &workload);
+				options.workloads.push_back(workload);
+			}
+			if (!valid)
+			{
+				std::cerr << "Invalid arguments. The workloads must be a list of soup, rpentomino, or stilllife.\n";
+				return 1;
+			}
+		}
+		else if (strcmp(option, "-d") == 0)
+		{
+			options.densities.clear();
+			bool valid = parseWordList(value, &words);
+			for (const std::string& word : words)
+			{
+				char* end;
+				double density = strtod(word.c_str(), &end);
+				valid = valid && *end == '\0' && density >= 0. && density <= 1.;
+				options.densities.push_back(density);
+			}
+			if (!valid)
+			{
+				std::cerr << "Invalid arguments. The densities must be a list of numbers between 0 and 1.\n";
+				return 1;
+			}
+		}
+		else if (strcmp(option, "-S") == 0)
+		{
+			if (!parseCount(value, 0, UINT_MAX, &options.seed))
+			{
+				std::cerr << "Invalid arguments. The seed must be a number.\n";
+				return 1;
+			}
+		}
+		else if (strcmp(option, "-u") == 0)
+		{
+			if (!parseCount(value, 0, UINT_MAX, &options.warmups))
+			{
+				std::cerr << "Invalid arguments. The number of warmup runs must be a number.\n";
+				return 1;
+			}
+		}
+		else if (strcmp(option, "-n") == 0)
+		{
+			if (!parseCount(value, 1, UINT_MAX, &options.repetitions))
+			{
+				std::cerr << "Invalid arguments. The number of measured runs must be positive.\n";
+				return 1;
+			}
+		}
+		else if (strcmp(option, "-T") == 0)
+		{
+			options.runSeconds = std::atof(value);
+			if (options.runSeconds <= 0.)
+			{
+				std::cerr << "Invalid arguments. The duration of a run must be positive.\n";
+				return 1;
+			}
+		}
+		else
+		{
+			std::cerr << "Usage: " << argv[0] << " " << USAGE << "\n";
+			return 1;
+		}
+	}
+
+	//	Opened first, so that a bad path does not waste a whole run
+	FILE* json = fopen(jsonPath, "w");
+	if (json == NULL)
+	{
+		std::cerr << "Cannot write " << jsonPath << ": " << strerror(errno) << "\n";
+		return 1;
+	}
+
+	std::vector<BenchmarkResult> results;
+	runBenchmarks(options, &results, stdout);
+	writeBenchmarkJson(json, options, results);
+	if (fclose(json) != 0)
+	{
+		std::cerr << "Cannot write " << jsonPath << ": " << strerror(errno) << "\n";
+		return 1;
+	}
+	return 0;
+}
+
+
+//	Comma-separated list of words, none of them empty
+bool parseWordList(const char* text, std::vector<std::string>* words)
+{
+	words->clear();
+	while (true)
+	{
+		const char* end = strchr(text, ',');
+		size_t length = end != NULL ? end - text : strlen(text);
+		if (length == 0)
+			return false;
+		words->emplace_back(text, length);
+		if (end == NULL)
+			return true;
+		text = end + 1;
+	}
+}
+
+
+//	Comma-separated list of whole numbers from min to max
+bool parseCountList(const char* text, unsigned int min, unsigned int max, std::vector<unsigned int>* counts)
+{
+	std::vector<std::string> words;
+	counts->clear();
+	bool valid = parseWordList(text, &words);
+	for (const std::string& word : words)
+	{
+		unsigned int count = 0;
+		valid = valid && parseCount(word.c_str(), min, max, &count);
+		counts->push_back(count);
+	}
+	return valid;
+}
+
+
+bool parseCount(const char* text, unsigned int min, unsigned int max, unsigned int* count)
+{
+	char* end;
+	errno = 0;
+	unsigned long value = strtoul(text, &end, 10);
+	if (end == text || *end != '\0' || text[0] == '-' || errno != 0 || value < min || value > max)
+		return false;
+	*count = (unsigned int) value;
+	return true;
+}
@@ -0,0 +1,162 @@
+//
+//  backgroundSaver.cpp
+//  Cellular Automaton
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <sys/wait.h>
+#include <unistd.h>
+//
+#include "backgroundSaver.h"
+#include "checkpoint.h"
+
+
+BackgroundSaver::BackgroundSaver(void)
+	:	interval_(0),
+		requested_(false),
+		directory_("."),
+		child_(0),
+		stats_{}
+{
+}
+
+
+BackgroundSaver::~BackgroundSaver(void)
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	reapChild(true);
+}
+
+
+void BackgroundSaver::setSchedule(const char* directory, unsigned long interval)
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	directory_ = directory;
+	interval_ = interval;
+}
+
+
+unsigned long BackgroundSaver::interval(void) const
+{
+	return interval_;
+}
+
+
+std::string BackgroundSaver::directory(void) const
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	return directory_;
+}
+
+
+void BackgroundSaver::request(const char* path)
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	requestedPath_ = path;
+	requested_ = true;
+}
+
+
+bool BackgroundSaver::due(unsigned long generation) const
+{
+	unsigned long interval = interval_.load(std::memory_order_relaxed);
+	return requested_.load(std::memory_order_relaxed) || (interval != 0 && generation % interval == 0);
+}
+
+
+bool BackgroundSaver::save(const char* path, const CheckpointHeader& header, const uint8_t* cells,
+						   GridBuffer* notShared, std::chrono::steady_clock::time_point pauseStart)
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	reapChild(false);
+
+	bool requested = path == NULL && requested_;
+	if (child_ != 0)
+	{
+		//	(a request stays pending until the child is done)
+		if (path == NULL && !requested)
+			stats_.numSkipped++;
+		errno = EBUSY;
+		return false;
+	}
+
+	//	Everything the child needs is ready before the fork: it must not
+	//	allocate memory, whose lock another thread may hold as we fork
+	std::string target;
+	if (path != NULL)
+		target = path;
+	else if (requested)
+		target = requestedPath_;
+	else
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "/cell-%lu.ckpt", (unsigned long) header.generation);
+		target = directory_ + name;
+	}
+
+	if (notShared != NULL)
+		notShared->setInherited(false);
+	pid_t child = fork();
+	if (child == 0)
+		_exit(writeCheckpoint(target.c_str(), header, cells) ? 0 : (errno != 0 ? errno : EIO));
+	int error = errno;
+	if (notShared != NULL)
+		notShared->setInherited(true);
+	double pause = std::chrono::duration<double>(std::chrono::steady_clock::now() - pauseStart).count();
+
+	if (child < 0)
+	{
+		stats_.numFailed++;
+		stats_.lastError = error;
+		errno = error;
+		return false;
+	}
+
+	child_ = child;
+	if (requested)
+		requested_ = false;
+	stats_.numStarted++;
+	stats_.lastGeneration = header.generation;
+	stats_.lastPause = pause;
+	stats_.maxPause = std::max(stats_.maxPause, pause);
+	stats_.totalPause += pause;
+	return true;
+}
+
+
+void BackgroundSaver::stats(BackgroundSaverStats* stats)
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	reapChild(false);
+	*stats = stats_;
+	stats->writing = child_ != 0;
+}
+
+
+//	Collects the exit status of the child, if it is done (or once it is,
+//	if wait is set).  The child exits with 0, or the errno of its failure.
+//	Called with lock_ held.
+void BackgroundSaver::reapChild(bool wait)
+{
+	if (child_ == 0)
+		return;
+
+	int status;
+	pid_t done;
+	do
+		done = waitpid(child_, &status, wait ? 0 : WNOHANG);
+	while (done < 0 && errno == EINTR);
+	if (done == 0)
+		return;
+
+	if (done == child_ && WIFEXITED(status) && WEXITSTATUS(status) == 0)
+		stats_.numSaved++;
+	else
+	{
+		stats_.numFailed++;
+		stats_.lastError = done < 0 ? errno : (WIFEXITED(status) ? WEXITSTATUS(status) : EINTR);
+	}
+	child_ = 0;
+}
@@ -0,0 +1,100 @@
+//
+//  backgroundSaver.h
+//  Cellular Automaton
+//
+//	Background checkpoints.  Writing the checkpoint of a large board takes
+//	seconds, during which the engine would have to stay paused.  Instead, a
+//	child process is forked at a generation boundary: it gets a frozen copy
+//	of the board (the pages are shared copy-on-write with the parent), which
+//	it writes with writeCheckpoint() while the parent keeps computing.  The
+//	compute threads only wait for the fork itself, which copies the page
+//	tables of the process, not its memory.
+//
+//	The grid that receives the next generation is left out of the child
+//	(see GridBuffer::setInherited()), so that only the pages of the grid
+//	being saved get copied when the parent writes them, a generation later.
+//
+//	Checkpoints are either scheduled every so many generations, named
+//	cell-<generation>.ckpt in a directory, or asked for one at a time.
+//	A single child writes at a time: a checkpoint that falls due while the
+//	previous one is still being written is skipped.
+//
+
+#ifndef BACKGROUND_SAVER_H
+#define BACKGROUND_SAVER_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+//
+#include "gridBuffer.h"
+
+struct CheckpointHeader;
+
+typedef struct BackgroundSaverStats {
+	unsigned long numStarted;		//	children forked
+	unsigned long numSaved;			//	checkpoints written
+	unsigned long numFailed;		//	forks or writes that failed
+	unsigned long numSkipped;		//	scheduled while a child was still writing
+	bool writing;					//	a child is writing now
+	unsigned long lastGeneration;	//	of the last checkpoint started
+	int lastError;					//	errno of the last failure (0: none)
+	//	time the compute threads were held for the forks, in seconds
+	double lastPause, maxPause, totalPause;
+} BackgroundSaverStats;
+
+class BackgroundSaver
+{
+	public:
+
+		BackgroundSaver(void);
+
+		//	Waits for a checkpoint being written, so that it is complete
+		~BackgroundSaver(void);
+
+		BackgroundSaver(const BackgroundSaver&) = delete;
+		BackgroundSaver& operator =(const BackgroundSaver&) = delete;
+
+		//	A checkpoint every interval generations (0: none) in directory
+		void setSchedule(const char* directory, unsigned long interval);
+		unsigned long interval(void) const;
+		std::string directory(void) const;
+
+		//	Asks for a checkpoint to path, taken at the next call to save()
+		//	with no path
+		void request(const char* path);
+
+		//	True if a checkpoint is scheduled at generation, or was asked for.
+		//	Cheap enough to call at every generation.
+		bool due(unsigned long generation) const;
+
+		//	Forks a child that writes header and cells to path (NULL: the path
+		//	asked for with request(), or else the scheduled one).  notShared is
+		//	a buffer the child has no use for (or NULL).  The pause of the
+		//	compute threads, counted from pauseStart, ends when this returns.
+		//	Returns false, with errno set (EBUSY if a child is still writing),
+		//	if no child was started.
+		bool save(const char* path, const CheckpointHeader& header, const uint8_t* cells, GridBuffer* notShared,
+				  std::chrono::steady_clock::time_point pauseStart);
+
+		void stats(BackgroundSaverStats* stats);
+
+	private:
+
+		void reapChild(bool wait);
+
+		std::atomic<unsigned long> interval_;
+		std::atomic<bool> requested_;
+
+		//	guards everything below
+		mutable std::mutex lock_;
+		std::string directory_;
+		std::string requestedPath_;
+		//	child writing a checkpoint (0: none)
+		pid_t child_;
+		BackgroundSaverStats stats_;
+};
+
+#endif	//	BACKGROUND_SAVER_H
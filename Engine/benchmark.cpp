@@ -0,0 +1,262 @@
+//
+//  benchmark.cpp
+//  Cellular Automaton
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <thread>
+//
+#include "benchmark.h"
+#include "headless.h"
+
+static const char* WORKLOAD_NAMES[NUM_WORKLOADS] = {
+	"soup",			//	WORKLOAD_SOUP
+	"rpentomino",	//	WORKLOAD_R_PENTOMINO
+	"stilllife"		//	WORKLOAD_STILL_LIFE
+};
+
+//	Two-sided 95% quantiles of Student's t distribution, by degrees of
+//	freedom (from 1); the normal one beyond
+static const double T_QUANTILES_95[] = {
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+const double NORMAL_QUANTILE_95 = 1.960;
+
+//	Upper bound on the generations of a run, however fast they go
+const unsigned long MAX_RUN_GENERATIONS = 1ul << 30;
+
+static void makeBoard(BenchmarkWorkload workload, double density, unsigned int seed, unsigned int size,
+					  GridSnapshot* board);
+static void runCase(CellEngine* engine, const GridSnapshot& start, const BenchmarkOptions& options,
+					BenchmarkResult* result);
+static double timedRun(CellEngine* engine, const GridSnapshot& start, unsigned long generations);
+static void summarize(BenchmarkResult* result);
+
+
+void defaultBenchmarkOptions(BenchmarkOptions* options)
+{
+	unsigned int numCores = std::clamp(std::thread::hardware_concurrency(), 1u, MAX_NUM_THREADS);
+
+	options->strategies = {STRATEGY_SERIAL, STRATEGY_BANDED, STRATEGY_ASYNC};
+	options->sizes = {64, 256, 1024, 4096, 16384};
+	options->threadCounts.clear();
+	for (unsigned int count = 1; count < numCores; count *= 2)
+		options->threadCounts.push_back(count);
+	options->threadCounts.push_back(numCores);
+	options->workloads = {WORKLOAD_SOUP, WORKLOAD_R_PENTOMINO, WORKLOAD_STILL_LIFE};
+	options->densities = {0.1, 0.3, 0.5};
+	options->seed = 1;
+	options->warmups = 1;
+	options->repetitions = 5;
+	options->runSeconds = 1.;
+}
+
+
+const char* workloadName(BenchmarkWorkload workload)
+{
+	return workload < NUM_WORKLOADS ? WORKLOAD_NAMES[workload] : "unknown";
+}
+
+
+bool parseWorkload(const char* name, BenchmarkWorkload* workload)
+{
+	for (unsigned int k = 0; k < NUM_WORKLOADS; k++)
+		if (strcmp(name, WORKLOAD_NAMES[k]) == 0)
+		{
+			*workload = (BenchmarkWorkload) k;
+			return true;
+		}
+	return false;
+}
+
+
+void runBenchmarks(const BenchmarkOptions& options, std::vector<BenchmarkResult>* results, FILE* log)
+{
+	results->clear();
+	for (unsigned int size : options.sizes)
+	{
+		//	one engine per size, reused by all its cases
+		CellEngine engine(size, size);
+		engine.setRule(GAME_OF_LIFE_RULE);
+		engine.setFrameBehavior(FRAME_DEAD);
+		engine.setTileSkipping(false);
+
+		for (BenchmarkWorkload workload : options.workloads)
+		{
+			std::vector<double> densities = workload == WORKLOAD_SOUP ? options.densities : std::vector<double>{0.};
+			for (double density : densities)
+			{
+				GridSnapshot start;
+				makeBoard(workload, density, options.seed, size, &start);
+
+				for (ExecutionStrategy strategy : options.strategies)
+				{
+					//	thread counts that are clamped to the same one are only run once
+					std::vector<unsigned int> counts;
+					for (unsigned int count : options.threadCounts)
+					{
+						engine.setStrategy(strategy);
+						engine.setNumThreads(strategy == STRATEGY_SERIAL ? 1 : count);
+						unsigned int numThreads = engine.numThreads();
+						if (std::find(counts.begin(), counts.end(), numThreads) != counts.end())
+							continue;
+						counts.push_back(numThreads);
+
+						BenchmarkResult result = {strategy, workload, density, size, numThreads, 0, {}, 0., 0., 0., 0.};
+						runCase(&engine, start, options, &result);
+						summarize(&result);
+						if (log != NULL)
+						{
+							fprintf(log, "%-9s %-10s %-4g %5u x %-5u %3u threads: %.4g cell updates/s (95%%: %.4g - %.4g)\n",
+									strategyName(strategy), workloadName(workload), density, size, size, numThreads,
+									result.mean, result.lowerBound, result.upperBound);
+							fflush(log);
+						}
+						results->push_back(result);
+					}
+				}
+			}
+		}
+	}
+}
+
+
+void writeBenchmarkJson(FILE* out, const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results)
+{
+	fprintf(out, "{\n");
+	fprintf(out, "  \"machine\": {\"cores\": %u},\n", std::thread::hardware_concurrency());
+	fprintf(out, "  \"options\": {\"warmups\": %u, \"repetitions\": %u, \"run_seconds\": %g, \"seed\": %u},\n",
+			options.warmups, options.repetitions, options.runSeconds, options.seed);
+	fprintf(out, "  \"results\": [");
+	for (size_t k = 0; k < results.size(); k++)
+	{
+		const BenchmarkResult& result = results[k];
+		fprintf(out, "%s\n    {\"strategy\": \"%s\", \"workload\": \"%s\", \"density\": %g, "
+					 "\"size\": %u, \"threads\": %u, \"generations\": %lu,\n",
+				k > 0 ? "," : "", strategyName(result.strategy), workloadName(result.workload), result.density,
+				result.size, result.numThreads, result.generations);
+		fprintf(out, "     \"cell_updates_per_second\": {\"mean\": %.6g, \"stddev\": %.6g, \"ci95\": [%.6g, %.6g], "
+					 "\"runs\": [",
+				result.mean, result.stddev, result.lowerBound, result.upperBound);
+		for (size_t r = 0; r < result.rates.size(); r++)
+			fprintf(out, "%s%.6g", r > 0 ? ", " : "", result.rates[r]);
+		fprintf(out, "]}}");
+	}
+	fprintf(out, "\n  ]\n}\n");
+}
+
+
+//	Board of size x size cells at generation 0, with the cells of workload
+static void makeBoard(BenchmarkWorkload workload, double density, unsigned int seed, unsigned int size,
+					  GridSnapshot* board)
+{
+	board->generation = 0;
+	board->numRows = board->numCols = size;
+	board->cells.assign((size_t) size * size, 0);
+	uint8_t* cells = board->cells.data();
+
+	switch (workload)
+	{
+		case WORKLOAD_SOUP:
+		{
+			std::mt19937 generator(seed);
+			std::bernoulli_distribution alive(density);
+			for (size_t k = 0; k < board->cells.size(); k++)
+				cells[k] = alive(generator) ? 1 : 0;
+			break;
+		}
+
+		//	.oo
+		//	oo.
+		//	.o.
+		case WORKLOAD_R_PENTOMINO:
+		{
+			static const unsigned int R_PENTOMINO[5][2] = {{0, 1}, {0, 2}, {1, 0}, {1, 1}, {2, 1}};
+			size_t row = size / 2 - 1, col = size / 2 - 1;
+			for (const unsigned int* cell : R_PENTOMINO)
+				cells[(row + cell[0]) * size + col + cell[1]] = 1;
+			break;
+		}
+
+		//	2 x 2 blocks every 3 rows and columns, clear of the border (which
+		//	the dead border would eat into)
+		case WORKLOAD_STILL_LIFE:
+			for (size_t i = 1; i + 3 <= size; i += 3)
+				for (size_t j = 1; j + 3 <= size; j += 3)
+				{
+					cells[i * size + j] = cells[i * size + j + 1] = 1;
+					cells[(i + 1) * size + j] = cells[(i + 1) * size + j + 1] = 1;
+				}
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+//	Runs a case from start.  The generations of a run are doubled until one
+//	takes a tenth of runSeconds, then scaled up to runSeconds (these runs
+//	warm up the caches as well), and the same number is used by all the
+//	runs that follow.
+static void runCase(CellEngine* engine, const GridSnapshot& start, const BenchmarkOptions& options,
+					BenchmarkResult* result)
+{
+	unsigned long generations = 1;
+	double seconds = timedRun(engine, start, generations);
+	while (seconds < options.runSeconds / 10 && generations < MAX_RUN_GENERATIONS)
+	{
+		generations *= 2;
+		seconds = timedRun(engine, start, generations);
+	}
+	if (seconds > 0.)
+		generations = std::clamp<unsigned long>(std::lround(generations * options.runSeconds / seconds), 1,
+												MAX_RUN_GENERATIONS);
+
+	for (unsigned int k = 0; k < options.warmups; k++)
+		timedRun(engine, start, generations);
+
+	double cells = (double) start.numRows * start.numCols;
+	result->generations = generations;
+	for (unsigned int k = 0; k < options.repetitions; k++)
+		result->rates.push_back(cells * generations / std::max(timedRun(engine, start, generations), 1.e-9));
+}
+
+
+//	Wall-clock time of generations from start
+static double timedRun(CellEngine* engine, const GridSnapshot& start, unsigned long generations)
+{
+	engine->restoreSnapshot(start);
+	double startTime = headlessClock();
+	engine->step(generations);
+	return headlessClock() - startTime;
+}
+
+
+//	Mean and standard deviation of the rates, and the confidence interval of
+//	the mean (only the mean itself with a single run)
+static void summarize(BenchmarkResult* result)
+{
+	size_t n = result->rates.size();
+	if (n == 0)
+		return;
+
+	double sum = 0., squares = 0.;
+	for (double rate : result->rates)
+		sum += rate;
+	result->mean = sum / n;
+	for (double rate : result->rates)
+		squares += (rate - result->mean) * (rate - result->mean);
+	result->stddev = n > 1 ? std::sqrt(squares / (n - 1)) : 0.;
+
+	size_t numQuantiles = sizeof(T_QUANTILES_95) / sizeof(T_QUANTILES_95[0]);
+	double quantile = n < 2 ? 0. : n - 1 <= numQuantiles ? T_QUANTILES_95[n - 2] : NORMAL_QUANTILE_95;
+	double margin = quantile * result->stddev / std::sqrt((double) n);
+	result->lowerBound = result->mean - margin;
+	result->upperBound = result->mean + margin;
+}
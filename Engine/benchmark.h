@@ -0,0 +1,78 @@
+//
+//  benchmark.h
+//  Cellular Automaton
+//
+//	Throughput benchmarks: the execution strategies of the engine, run
+//	headless over a matrix of board sizes, thread counts and workloads.
+//	These are not the programs of Version1 to Version3, whose ideas they
+//	started from: the async strategy, for one, locks rows, not cells.
+//
+//	Each case (a strategy, a workload, a board size and a thread count) is
+//	run several times from the same board: first to find how many
+//	generations make a run of about runSeconds, then warmups runs that are
+//	not counted, then the runs measured.  Its throughput is reported in cell
+//	updates per second (numRows*numCols per generation), with the mean of
+//	the runs and a 95% confidence interval for it.  The engine computes
+//	every tile of the board for the benchmarks, dead or not (see
+//	CellEngine::setTileSkipping()), so that each update counted is done.
+//
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdio>
+#include <vector>
+//
+#include "cellEngine.h"
+
+//	Boards the runs start from.  All run the Game of Life rule.
+typedef enum BenchmarkWorkload {
+	WORKLOAD_SOUP = 0,		//	random cells, at each of the densities
+	WORKLOAD_R_PENTOMINO,	//	an R-pentomino in the middle of a dead board
+	WORKLOAD_STILL_LIFE,	//	blocks all over the board, a cell apart: nothing ever changes
+	//
+	NUM_WORKLOADS
+} BenchmarkWorkload;
+
+typedef struct BenchmarkOptions {
+	std::vector<ExecutionStrategy> strategies;
+	std::vector<unsigned int> sizes;			//	of square boards
+	std::vector<unsigned int> threadCounts;		//	(the serial strategy only runs with 1)
+	std::vector<BenchmarkWorkload> workloads;
+	std::vector<double> densities;				//	of the soups
+	unsigned int seed;							//	of the soups
+	unsigned int warmups, repetitions;			//	runs of each case: not counted, then measured
+	double runSeconds;							//	that a run should last
+} BenchmarkOptions;
+
+typedef struct BenchmarkResult {
+	ExecutionStrategy strategy;
+	BenchmarkWorkload workload;
+	double density;						//	of a soup (0 for the other workloads)
+	unsigned int size, numThreads;
+	unsigned long generations;			//	per run
+	std::vector<double> rates;			//	cell updates per second, of each run measured
+	double mean, stddev;				//	of the rates
+	double lowerBound, upperBound;		//	95% confidence interval of the mean
+} BenchmarkResult;
+
+//	The whole matrix: the serial, banded and async strategies, boards from
+//	64 x 64 to 16384 x 16384, 1 thread to all the cores, and every workload
+//	(soups at densities 0.1, 0.3 and 0.5)
+void defaultBenchmarkOptions(BenchmarkOptions* options);
+
+//	Name of a workload ("soup", "rpentomino", "stilllife")
+const char* workloadName(BenchmarkWorkload workload);
+
+//	Returns false if name is not the name of a workload
+bool parseWorkload(const char* name, BenchmarkWorkload* workload);
+
+//	Runs every case of the matrix, in order of size, workload, strategy and
+//	thread count, and prints a line for each one on log (if not NULL) as
+//	soon as it is done
+void runBenchmarks(const BenchmarkOptions& options, std::vector<BenchmarkResult>* results, FILE* log);
+
+//	The options, the machine, and one object per case
+void writeBenchmarkJson(FILE* out, const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results);
+
+#endif	//	BENCHMARK_H
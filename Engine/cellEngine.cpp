@@ -0,0 +1,1922 @@
+//
+//  cellEngine.cpp
+//  Cellular Automaton
+//
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <random>
+#include <unistd.h>
+//
+#include "cellEngine.h"
+#include "checkpoint.h"
+
+//	Wavefront synchronization.  A band computes its first and last rows
+//	(the halo rows of its neighbors) before its interior, and publishes
+//	them right away in edgeGeneration.  A band may compute generation g+1
+//	as soon as its two neighbors have published the edge rows of generation
+//	g, even if they are still busy with their interior.  generation is the
+//	last generation the band fully completed.
+struct alignas(64) CellEngine::BandSync {
+	std::atomic<unsigned int> generation;
+	std::atomic<unsigned int> edgeGeneration;
+	std::mutex lock;
+	std::condition_variable_any published;
+};
+
+//	Set in CellEngine::middleFrame_ when the latest frame published has not
+//	been taken by the display yet
+const unsigned int FRESH_FRAME = 4;
+
+//	Change count of a frame that does not show the board at any given change
+//	count (the async strategy never stops updating it)
+const unsigned long NO_CHANGE = ~0ul;
+
+//	Upper bound on the number of cell updates an async thread does between
+//	two looks at the shared update count
+const unsigned int ASYNC_BATCH = 1024;
+
+//	Cells a band computes before it encodes them for a recording: few
+//	enough that they are still in the caches
+const unsigned int RECORD_BLOCK_CELLS = 1 << 16;
+
+//	Flags of a tile in a tile table.  A tile without TILE_LIVE is all dead in
+//	its grid; one with it may not be.  TILE_LIVE_NEXT is set on the tiles
+//	found alive while the grid receives the next generation.
+const uint8_t TILE_LIVE = 1;
+const uint8_t TILE_LIVE_NEXT = 2;
+
+static void reduceBlocks(const uint8_t* src, size_t srcStride, unsigned int rows, unsigned int cols,
+						 unsigned int block, uint8_t* dst);
+static void mergeBlocks(const uint8_t* src, unsigned int cols, uint8_t* dst, bool shared);
+static bool sameView(const BoardView& a, const BoardView& b);
+static unsigned long nanosecondsSince(std::chrono::steady_clock::time_point start);
+static bool zeroBytes(const uint8_t* bytes, size_t size);
+static bool deadRect(const uint8_t* cells, size_t stride, unsigned int rows, unsigned int cols);
+static bool clearRect(uint8_t* cells, size_t stride, unsigned int rows, unsigned int cols);
+static unsigned int coveredEnd(int64_t start, uint64_t length, unsigned int limit);
+
+static const char* STRATEGY_NAMES[NUM_STRATEGIES] = {
+	"serial",		//	STRATEGY_SERIAL
+	"banded",		//	STRATEGY_BANDED
+	"wavefront",	//	STRATEGY_WAVEFRONT
+	"async"			//	STRATEGY_ASYNC
+};
+
+
+const char* strategyName(ExecutionStrategy strategy)
+{
+	return strategy < NUM_STRATEGIES ? STRATEGY_NAMES[strategy] : "unknown";
+}
+
+
+bool parseStrategy(const char* name, ExecutionStrategy* strategy)
+{
+	for (unsigned int k = 0; k < NUM_STRATEGIES; k++)
+		if (strcmp(name, STRATEGY_NAMES[k]) == 0)
+		{
+			*strategy = (ExecutionStrategy) k;
+			return true;
+		}
+	return false;
+}
+
+//	Birth (dead cell) and survival (live cell) conditions of each rule, as
+//	bit masks over the number of live neighbors
+typedef struct RuleMasks {
+	unsigned int birth;
+	unsigned int survival;
+} RuleMasks;
+
+static const char* RULE_STRINGS[] = {
+	"B3/S23",		//	GAME_OF_LIFE_RULE
+	"B3/S45678",	//	CORAL_GROWTH_RULE
+	"B1358/S1358",	//	AMOEBA_RULE
+	"B3/S12345"		//	MAZE_RULE
+};
+
+static bool ruleMasks(unsigned int rule, RuleMasks* masks)
+{
+	switch (rule)
+	{
+		//	Rule 1 (Conway's classical Game of Life: B3/S23)
+		case GAME_OF_LIFE_RULE:
+			masks->birth = 1u << 3;
+			masks->survival = (1u << 2) | (1u << 3);
+			return true;
+
+		//	Rule 2 (Coral Growth: B3/S45678)
+		case CORAL_GROWTH_RULE:
+			masks->birth = 1u << 3;
+			masks->survival = (1u << 4) | (1u << 5) | (1u << 6) | (1u << 7) | (1u << 8);
+			return true;
+
+		//	Rule 3 (Amoeba).  Same birth and survival counts as the original
+		//	versions of the program: 1, 3, 5, 8
+		case AMOEBA_RULE:
+			masks->birth = (1u << 1) | (1u << 3) | (1u << 5) | (1u << 8);
+			masks->survival = (1u << 1) | (1u << 3) | (1u << 5) | (1u << 8);
+			return true;
+
+		//	Rule 4 (Maze: B3/S12345)
+		case MAZE_RULE:
+			masks->birth = 1u << 3;
+			masks->survival = (1u << 1) | (1u << 2) | (1u << 3) | (1u << 4) | (1u << 5);
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+
+const char* ruleString(unsigned int rule)
+{
+	return rule >= GAME_OF_LIFE_RULE && rule <= MAZE_RULE ? RULE_STRINGS[rule - GAME_OF_LIFE_RULE] : NULL;
+}
+
+
+unsigned int parseRuleString(const char* text)
+{
+	//	"B<digits>/S<digits>", or "<survival digits>/<birth digits>"
+	RuleMasks parsed = {0, 0};
+	unsigned int* mask = &parsed.survival;
+	bool prefixed = false;
+	for (const char* c = text; *c != '\0' && *c != ':' && !isspace((unsigned char) *c); c++)
+	{
+		if (*c == 'B' || *c == 'b')
+		{
+			mask = &parsed.birth;
+			prefixed = true;
+		}
+		else if (*c == 'S' || *c == 's')
+		{
+			mask = &parsed.survival;
+			prefixed = true;
+		}
+		else if (*c == '/')
+		{
+			if (!prefixed)
+				mask = &parsed.birth;
+		}
+		else if (*c >= '0' && *c <= '8')
+			*mask |= 1u << (*c - '0');
+		else
+			return 0;
+	}
+
+	RuleMasks masks;
+	for (unsigned int rule = GAME_OF_LIFE_RULE; ruleMasks(rule, &masks); rule++)
+		if (masks.birth == parsed.birth && masks.survival == parsed.survival)
+			return rule;
+	return 0;
+}
+
+
+CellEngine::CellEngine(unsigned int numCols, unsigned int numRows, unsigned int numThreads)
+	:	numRows_(numRows),
+		numCols_(numCols),
+		current_(0),
+		memoryBudget_(0),
+		numTileRows_(numRows / TILE_SIZE + (numRows % TILE_SIZE != 0)),
+		numTileCols_(numCols / TILE_SIZE + (numCols % TILE_SIZE != 0)),
+		skipTiles_(true),
+		rule_(GAME_OF_LIFE_RULE),
+		colorMode_(false),
+		frame_(FRAME_DEAD),
+		activeFrame_(FRAME_DEAD),
+		strategy_(STRATEGY_BANDED),
+		numThreads_(1),
+		generation_(0),
+		edits_(0),
+		seed_(0),
+		bands_(new BandSync[MAX_NUM_THREADS]),
+		wfBase_(0),
+		wfStartGeneration_(0),
+		rowLocks_(new std::mutex[numRows]),
+		asyncUpdates_(0),
+		backFrame_(0),
+		frontFrame_(1),
+		middleFrame_(2),
+		writingFrame_(false),
+		view_({0, 0, numRows, numCols, 1}),
+		requestedView_(view_),
+		frameRequested_(false),
+		frameThisGeneration_(false),
+		wfFrameGeneration_(0),
+		wfFrameBands_(0),
+		publishedFrames_(0),
+		publishNanos_(0),
+		recordChunks_(new RecordChunk[MAX_NUM_THREADS]),
+		encoding_(false),
+		encodeKeyframe_(false),
+		encodedEdits_(0),
+		stopAtGeneration_(0),
+		paced_(false)
+{
+	grid_[0].allocate((size_t) numRows * numCols);
+	grid_[1].allocate((size_t) numRows * numCols);
+	for (unsigned int k = 0; k < 2; k++)
+	{
+		tiles_[k].reset(new std::atomic<uint8_t>[(size_t) numTileRows_ * numTileCols_]);
+		setTiles(k, 0);
+	}
+	for (ViewFrame& frame : frames_)
+	{
+		frame.view = view_;
+		frame.generation = frame.change = frame.sequence = 0;
+		frame.numRows = frame.numCols = 0;
+	}
+	setNumThreads(numThreads);
+	updateTransitionTable();
+}
+
+
+CellEngine::~CellEngine(void)
+{
+	pool_.stop();
+}
+
+
+unsigned int CellEngine::numRows(void) const
+{
+	return numRows_;
+}
+
+
+unsigned int CellEngine::numCols(void) const
+{
+	return numCols_;
+}
+
+
+bool CellEngine::setRule(unsigned int rule)
+{
+	RuleMasks masks;
+	if (!ruleMasks(rule, &masks))
+		return false;
+	rule_ = rule;
+	restartIfFreeRunning();
+	return true;
+}
+
+
+unsigned int CellEngine::rule(void) const
+{
+	return rule_;
+}
+
+
+void CellEngine::setColorMode(bool on)
+{
+	colorMode_ = on;
+	restartIfFreeRunning();
+}
+
+
+bool CellEngine::colorMode(void) const
+{
+	return colorMode_;
+}
+
+
+void CellEngine::setFrameBehavior(FrameBehavior frame)
+{
+	frame_ = frame;
+	restartIfFreeRunning();
+}
+
+
+FrameBehavior CellEngine::frameBehavior(void) const
+{
+	return frame_;
+}
+
+
+void CellEngine::setStrategy(ExecutionStrategy strategy)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	if (strategy >= NUM_STRATEGIES || strategy == strategy_)
+		return;
+
+	bool wasRunning = isRunning();
+	pause();
+
+	strategy_ = strategy;
+
+	if (wasRunning)
+		run();
+}
+
+
+ExecutionStrategy CellEngine::strategy(void) const
+{
+	return strategy_;
+}
+
+
+void CellEngine::setNumThreads(unsigned int numThreads)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	numThreads = std::max(numThreads, 1u);
+	numThreads = std::min(numThreads, std::min(numRows_, MAX_NUM_THREADS));
+	if (numThreads == numThreads_)
+		return;
+
+	numThreads_ = numThreads;
+	if (pool_.isRunning() && strategy_ == STRATEGY_BANDED)
+		pool_.resize(numThreads);
+	else
+		restartIfFreeRunning();
+}
+
+
+unsigned int CellEngine::numThreads(void) const
+{
+	return numThreads_;
+}
+
+
+unsigned int CellEngine::liveThreadCount(void) const
+{
+	return pool_.liveCount();
+}
+
+
+void CellEngine::setTileSkipping(bool on)
+{
+	skipTiles_ = on;
+}
+
+
+bool CellEngine::tileSkipping(void) const
+{
+	return skipTiles_;
+}
+
+
+void CellEngine::randomize(unsigned int seed, double density)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	bool wasRunning = isRunning();
+	pause();
+
+	seed_ = seed;
+	std::mt19937 generator(seed);
+	std::bernoulli_distribution alive(density);
+	GridBuffer& grid = grid_[current_];
+	size_t window = memoryBudget_ != 0 ? memoryBudget_ / 2 : grid.size();
+	for (size_t start = 0; start < grid.size(); start += window)
+	{
+		size_t end = std::min(grid.size(), start + window);
+		for (size_t k = start; k < end; k++)
+			grid[k] = alive(generator) ? 1 : 0;
+		grid.evict(start, end - start, true);
+	}
+	setTiles(current_, TILE_LIVE);
+	edits_++;
+
+	if (wasRunning)
+		run();
+}
+
+
+void CellEngine::clear(void)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	bool wasRunning = isRunning();
+	pause();
+
+	//	Only the tiles that may be alive, and of these, the rows that are
+	//	not dead already
+	GridBuffer& grid = grid_[current_];
+	const size_t nc = numCols_;
+	for (unsigned int tr = 0; tr < numTileRows_; tr++)
+	{
+		unsigned int startRow = tr * TILE_SIZE, rows = std::min(TILE_SIZE, numRows_ - startRow);
+		bool cleared = false;
+		for (unsigned int tc = 0; tc < numTileCols_; tc++)
+		{
+			unsigned int startCol = tc * TILE_SIZE;
+			if (tiles_[current_][(size_t) tr * numTileCols_ + tc].load(std::memory_order_relaxed) & TILE_LIVE)
+				cleared = clearRect(grid.data() + startRow * nc + startCol, nc, rows,
+									std::min(TILE_SIZE, numCols_ - startCol)) || cleared;
+		}
+		if (cleared)
+			grid.evict(startRow * nc, rows * nc, true);
+	}
+	setTiles(current_, 0);
+	edits_++;
+
+	if (wasRunning)
+		run();
+}
+
+
+void CellEngine::setCell(unsigned int row, unsigned int col, uint8_t state)
+{
+	if (row >= numRows_ || col >= numCols_)
+		return;
+
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	bool wasRunning = isRunning();
+	pause();
+
+	grid_[current_][(size_t) row * numCols_ + col] = std::min<uint8_t>(state, NUM_CELL_STATES - 1);
+	markTiles(current_, row, row + 1, col, col + 1);
+	edits_++;
+
+	if (wasRunning)
+		run();
+}
+
+
+uint8_t CellEngine::cell(unsigned int row, unsigned int col) const
+{
+	return grid_[current_][(size_t) row * numCols_ + col];
+}
+
+
+bool CellEngine::backWithFiles(const char* directory, size_t memoryBudget)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	bool wasRunning = isRunning();
+	pause();
+
+	size_t size = (size_t) numRows_ * numCols_;
+	GridBuffer grids[2];
+	bool backed = grids[0].createBackingFile(directory, size) && grids[1].createBackingFile(directory, size);
+	if (backed)
+	{
+		memoryBudget_ = std::max<size_t>(memoryBudget, 1);
+		fillGrid(&grids[0], grid_[current_].data(), true);
+		grid_[current_].swap(grids[0]);
+		grid_[1 - current_].swap(grids[1]);
+		setTiles(1 - current_, 0);
+	}
+
+	int error = errno;
+	if (wasRunning)
+		run();
+	errno = error;
+	return backed;
+}
+
+
+bool CellEngine::isFileBacked(void) const
+{
+	return memoryBudget_ != 0;
+}
+
+
+void CellEngine::step(unsigned long numGenerations)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	pause();
+	if (numGenerations == 0)
+		return;
+
+	startPool(generation_ + numGenerations, false);
+	pool_.wait();
+}
+
+
+void CellEngine::run(void)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	if (!isRunning())
+		startPool(0, true);
+}
+
+
+void CellEngine::pause(void)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	pool_.stop();
+}
+
+
+bool CellEngine::isRunning(void) const
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	return pool_.isRunning();
+}
+
+
+Pacer& CellEngine::pacer(void)
+{
+	return pacer_;
+}
+
+
+unsigned long CellEngine::generation(void) const
+{
+	return generation_;
+}
+
+
+unsigned long CellEngine::changeCount(void) const
+{
+	return generation_ + edits_;
+}
+
+
+const uint8_t* CellEngine::cells(void) const
+{
+	return grid_[current_].data();
+}
+
+
+void CellEngine::snapshot(GridSnapshot* snap) const
+{
+	snap->generation = generation_;
+	snap->numRows = numRows_;
+	snap->numCols = numCols_;
+	snap->cells.assign(grid_[current_].begin(), grid_[current_].end());
+}
+
+
+bool CellEngine::restoreSnapshot(const GridSnapshot& snap)
+{
+	if (snap.numRows != numRows_ || snap.numCols != numCols_ || snap.cells.size() != (size_t) numRows_ * numCols_)
+	{
+		errno = EINVAL;
+		return false;
+	}
+
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	bool wasRunning = isRunning();
+	pause();
+
+	fillGrid(&grid_[current_], snap.cells.data(), false);
+	setTiles(current_, TILE_LIVE);
+	generation_ = snap.generation;
+	edits_++;
+
+	if (wasRunning)
+		run();
+	return true;
+}
+
+
+bool CellEngine::saveCheckpoint(const char* path)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	bool wasRunning = isRunning();
+	pause();
+
+	CheckpointHeader header;
+	checkpointHeader(&header);
+	bool saved = writeCheckpoint(path, header, grid_[current_].data());
+
+	int error = errno;
+	if (wasRunning)
+		run();
+	errno = error;
+	return saved;
+}
+
+
+bool CellEngine::loadCheckpoint(const char* path)
+{
+	CheckpointHeader header;
+	int fd = openCheckpoint(path, &header);
+	if (fd < 0)
+		return false;
+
+	RuleMasks masks;
+	GridBuffer cells;
+	bool loaded = header.numRows == numRows_ && header.numCols == numCols_ && ruleMasks(header.rule, &masks);
+	if (!loaded)
+		errno = EINVAL;
+	else
+		loaded = cells.mapFile(fd, header.headerSize, header.cellsSize);
+	int error = errno;
+	close(fd);
+	if (loaded && !validCheckpointCells(cells.data(), cells.size()))
+	{
+		loaded = false;
+		error = EINVAL;
+	}
+	if (!loaded)
+	{
+		errno = error;
+		return false;
+	}
+
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	bool wasRunning = isRunning();
+	pause();
+
+	//	A board in a backing file stays there
+	if (memoryBudget_ != 0)
+		fillGrid(&grid_[current_], cells.data(), false);
+	else
+		grid_[current_].swap(cells);
+	setTiles(current_, TILE_LIVE);
+	rule_ = header.rule;
+	frame_ = (FrameBehavior) header.frame;
+	colorMode_ = header.colorMode != 0;
+	generation_ = header.generation;
+	seed_ = header.seed;
+	edits_++;
+
+	if (wasRunning)
+		run();
+	return true;
+}
+
+
+bool CellEngine::saveCheckpointInBackground(const char* path)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	if (memoryBudget_ != 0)
+	{
+		errno = ENOTSUP;
+		return false;
+	}
+	if (isRunning() && (strategy_ == STRATEGY_SERIAL || strategy_ == STRATEGY_BANDED))
+	{
+		saver_.request(path);
+		return true;
+	}
+
+	std::chrono::steady_clock::time_point pauseStart = std::chrono::steady_clock::now();
+	bool wasRunning = isRunning();
+	pause();
+
+	CheckpointHeader header;
+	checkpointHeader(&header);
+	bool started = saver_.save(path, header, grid_[current_].data(), &grid_[1 - current_], pauseStart);
+
+	int error = errno;
+	if (wasRunning)
+		run();
+	errno = error;
+	return started;
+}
+
+
+BackgroundSaver& CellEngine::backgroundSaver(void)
+{
+	return saver_;
+}
+
+
+void CellEngine::placePattern(const Pattern& pattern, int64_t row, int64_t col)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	bool wasRunning = isRunning();
+	pause();
+
+	pattern.place(grid_[current_].data(), numRows_, numCols_, row, col);
+	markTiles(current_, std::clamp<int64_t>(row, 0, numRows_), coveredEnd(row, pattern.numRows(), numRows_),
+			  std::clamp<int64_t>(col, 0, numCols_), coveredEnd(col, pattern.numCols(), numCols_));
+	if (pattern.rule() != 0)
+		rule_ = pattern.rule();
+	edits_++;
+
+	if (wasRunning)
+		run();
+}
+
+
+bool CellEngine::savePattern(const char* path, PatternFormat format)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	bool wasRunning = isRunning();
+	pause();
+
+	bool saved = writePattern(path, format, grid_[current_].data(), numRows_, numCols_, rule_);
+
+	int error = errno;
+	if (wasRunning)
+		run();
+	errno = error;
+	return saved;
+}
+
+
+bool CellEngine::startRecording(const char* path, unsigned long keyframeInterval)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	bool wasRunning = isRunning();
+	pause();
+
+	bool started = recorder_.start(path, grid_[current_].data(), numRows_, numCols_, generation_, keyframeInterval);
+	if (started)
+		encodedEdits_ = edits_;
+
+	int error = errno;
+	if (wasRunning)
+		run();
+	errno = error;
+	return started;
+}
+
+
+bool CellEngine::stopRecording(void)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	bool wasRunning = isRunning();
+	pause();
+
+	bool stopped = recorder_.stop();
+
+	int error = errno;
+	if (wasRunning)
+		run();
+	errno = error;
+	return stopped;
+}
+
+
+Recorder& CellEngine::recorder(void)
+{
+	return recorder_;
+}
+
+
+bool CellEngine::loadRecordedGeneration(const char* path, unsigned long generation)
+{
+	Player player;
+	if (!player.open(path))
+		return false;
+	if (player.numRows() != numRows_ || player.numCols() != numCols_)
+	{
+		errno = EINVAL;
+		return false;
+	}
+
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	bool wasRunning = isRunning();
+	pause();
+
+	//	decoded into the other grid, so that a failure leaves the board as it was
+	unsigned int next = 1 - current_;
+	setTiles(next, TILE_LIVE);
+	bool loaded = player.seek(generation, grid_[next].data());
+	//	(the 4-bit cells of a corrupt or foreign recording may hold any state)
+	if (loaded && !validCheckpointCells(grid_[next].data(), grid_[next].size()))
+	{
+		loaded = false;
+		errno = EINVAL;
+	}
+	if (loaded)
+	{
+		current_ = next;
+		generation_ = generation;
+		edits_++;
+	}
+
+	int error = errno;
+	if (wasRunning)
+		run();
+	errno = error;
+	return loaded;
+}
+
+
+void CellEngine::setRewindDepth(unsigned long numGenerations, size_t maxBytes)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	bool wasRunning = isRunning();
+	pause();
+
+	rewind_.configure(numGenerations, maxBytes);
+
+	if (wasRunning)
+		run();
+}
+
+
+bool CellEngine::rewindTo(unsigned long generation)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	pause();
+
+	//	decoded into the other grid, so that a failure leaves the board as it was
+	unsigned int next = 1 - current_;
+	setTiles(next, TILE_LIVE);
+	if (!rewind_.decode(generation, grid_[next].data(), numRows_, numCols_))
+		return false;
+	current_ = next;
+	generation_ = generation;
+	edits_++;
+	//	the board is the one held: the next generation can be a difference
+	encodedEdits_ = edits_;
+	return true;
+}
+
+
+bool CellEngine::stepBack(unsigned long numGenerations)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	unsigned long generation;
+	if (!rewind_.nearest(generation_ - std::min<unsigned long>(numGenerations, generation_), true, &generation))
+	{
+		errno = ERANGE;
+		return false;
+	}
+	return rewindTo(generation);
+}
+
+
+bool CellEngine::stepForward(unsigned long numGenerations)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	unsigned long generation;
+	if (!rewind_.nearest(generation_ + std::min(numGenerations, ~0ul - generation_), false, &generation))
+	{
+		errno = ERANGE;
+		return false;
+	}
+	return rewindTo(generation);
+}
+
+
+RewindBuffer& CellEngine::rewindBuffer(void)
+{
+	return rewind_;
+}
+
+
+void CellEngine::setView(const BoardView& view)
+{
+	view_.row = std::min(view.row, numRows_ - 1);
+	view_.col = std::min(view.col, numCols_ - 1);
+	view_.numRows = std::clamp(view.numRows, 1u, numRows_ - view_.row);
+	view_.numCols = std::clamp(view.numCols, 1u, numCols_ - view_.col);
+	view_.block = std::max(view.block, 1u);
+}
+
+
+const ViewFrame& CellEngine::acquireFrame(void)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	if (middleFrame_.load(std::memory_order_acquire) & FRESH_FRAME)
+		frontFrame_ = middleFrame_.exchange(frontFrame_) & ~FRESH_FRAME;
+
+	if (isRunning())
+	{
+		//	The compute threads copy requestedView_ before they clear the
+		//	request, so it is ours again once the request is cleared
+		if (!frameRequested_.load(std::memory_order_acquire))
+		{
+			requestedView_ = view_;
+			frameRequested_.store(true, std::memory_order_release);
+		}
+	}
+	else
+	{
+		if (frontFrameStale())
+		{
+			//	Nobody else writes frames while the engine is paused (a frame
+			//	left unfinished by the last run is simply dropped)
+			writingFrame_ = true;
+			prepareFrame(view_);
+			publishBandView(0, 1, grid_[current_].data());
+			publishFrame(generation_, changeCount());
+			frontFrame_ = middleFrame_.exchange(frontFrame_) & ~FRESH_FRAME;
+		}
+	}
+	return frames_[frontFrame_];
+}
+
+
+bool CellEngine::frameReady(void) const
+{
+	if (middleFrame_.load(std::memory_order_acquire) & FRESH_FRAME)
+		return true;
+
+	//	If another thread is busy controlling the engine, we will know at
+	//	the next call
+	std::unique_lock<std::recursive_mutex> control(controlLock_, std::try_to_lock);
+	return control.owns_lock() && !pool_.isRunning() && frontFrameStale();
+}
+
+
+void CellEngine::publicationCost(unsigned long* numFrames, double* seconds) const
+{
+	*numFrames = publishedFrames_;
+	*seconds = 1.e-9 * publishNanos_;
+}
+
+
+void CellEngine::beginHostedGeneration(void)
+{
+	stopAtGeneration_ = 0;
+	paced_ = false;
+	frameThisGeneration_ = false;
+	updateTransitionTable();
+	prepareEncoding();
+}
+
+
+void CellEngine::computeHostedBand(unsigned int index, unsigned int count, std::stop_token stop)
+{
+	computeBand(index, count, stop);
+}
+
+
+void CellEngine::endHostedGeneration(bool completed)
+{
+	endOfGeneration(completed);
+}
+
+
+void CellEngine::startPool(unsigned long stopAtGeneration, bool paced)
+{
+	stopAtGeneration_ = stopAtGeneration;
+	paced_ = paced;
+	updateTransitionTable();
+	prepareEncoding();
+
+	//	a frame left unfinished by the last run is dropped
+	writingFrame_ = false;
+	wfFrameGeneration_ = 0;
+	frameThisGeneration_ = strategy_ != STRATEGY_WAVEFRONT && strategy_ != STRATEGY_ASYNC && beginFrame();
+
+	//	The wavefront and async strategies go through whole rows, and do
+	//	not keep track of the tiles they bring to life
+	if (strategy_ == STRATEGY_WAVEFRONT || strategy_ == STRATEGY_ASYNC)
+	{
+		setTiles(0, TILE_LIVE);
+		setTiles(1, TILE_LIVE);
+	}
+
+	switch (strategy_)
+	{
+		case STRATEGY_SERIAL:
+		case STRATEGY_BANDED:
+			pool_.start(strategy_ == STRATEGY_SERIAL ? 1 : numThreads_.load(),
+						[this](unsigned int index, unsigned int count, std::stop_token stop) {
+							computeBand(index, count, stop);
+						},
+						[this](bool completed) {
+							return endOfGeneration(completed);
+						});
+			break;
+
+		//	The bands never return on their own before the end of the run, so
+		//	we only get to the end of the "phase" when the run is over
+		case STRATEGY_WAVEFRONT:
+			wfBase_ = current_;
+			wfStartGeneration_ = generation_;
+			for (unsigned int k = 0; k < MAX_NUM_THREADS; k++)
+			{
+				bands_[k].generation = 0;
+				bands_[k].edgeGeneration = 0;
+			}
+			pool_.start(numThreads_,
+						[this](unsigned int index, unsigned int count, std::stop_token stop) {
+							computeWavefrontBand(index, count, stop);
+						},
+						[this](bool completed) {
+							(void) completed;
+							realignBands(pool_.size());
+							return false;
+						});
+			break;
+
+		case STRATEGY_ASYNC:
+			asyncUpdates_ = 0;
+			pool_.start(numThreads_,
+						[this](unsigned int index, unsigned int count, std::stop_token stop) {
+							computeAsyncUpdates(index, count, stop);
+						},
+						[](bool completed) {
+							(void) completed;
+							return false;
+						});
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+//	The wavefront and async strategies cannot rebuild the transition table
+//	between two generations, since their threads never all stop at the same
+//	time.  A change of rule, color mode, or border behavior restarts them, as
+//	does a change of the number of threads (the wavefront bands must be
+//	realigned and cut again).
+void CellEngine::restartIfFreeRunning(void)
+{
+	std::lock_guard<std::recursive_mutex> control(controlLock_);
+	if (isRunning() && (strategy_ == STRATEGY_WAVEFRONT || strategy_ == STRATEGY_ASYNC))
+	{
+		pause();
+		run();
+	}
+}
+
+
+//	Rows [startRow, endRow) handled by thread index (out of count).
+//	The last band absorbs the remainder of the division.
+void CellEngine::bandRows(unsigned int index, unsigned int count,
+						  unsigned int* startRow, unsigned int* endRow) const
+{
+	unsigned int rowsPerThread = numRows_ / count;
+	*startRow = index * rowsPerThread;
+	*endRow = (index == count - 1) ? numRows_ : (index + 1) * rowsPerThread;
+}
+
+
+//	Bands whose edge rows the cells of band index read, or count if there
+//	is none.  With a wrapping border, the first and last bands are neighbors.
+void CellEngine::bandNeighbors(unsigned int index, unsigned int count,
+							   unsigned int* above, unsigned int* below) const
+{
+	bool ring = activeFrame_ == FRAME_WRAP;
+	*above = index > 0 ? index - 1 : (ring ? count - 1 : count);
+	*below = index < count - 1 ? index + 1 : (ring ? 0 : count);
+}
+
+
+void CellEngine::computeBand(unsigned int index, unsigned int count, std::stop_token stop)
+{
+	unsigned int startRow, endRow;
+	bandRows(index, count, &startRow, &endRow);
+
+	unsigned int next = 1 - current_;
+	const uint8_t* src = grid_[current_].data();
+	uint8_t* dst = grid_[next].data();
+	if (encoding_ || memoryBudget_ != 0)
+	{
+		//	By blocks of rows: each one is encoded right after it is computed,
+		//	while it is still in the caches.  For grids in backing files, the
+		//	next block is read ahead while one is computed, and the pages of
+		//	one are let go of once it is done.
+		unsigned int blockRows = endRow - startRow, end;
+		if (encoding_)
+			blockRows = std::max(1u, RECORD_BLOCK_CELLS / numCols_);
+		if (memoryBudget_ != 0)
+			blockRows = std::min(blockRows, windowRows(count));
+		for (unsigned int row = startRow; row < endRow; row = end)
+		{
+			end = row + std::min(blockRows, endRow - row);
+			if (memoryBudget_ != 0)
+				prefetchRows(end, std::min(endRow, end + blockRows));
+			if (!computeTiles(row, end, stop))
+				return;
+			if (encoding_)
+			{
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				encodeRecordRows(encodeKeyframe_ ? NULL : src, dst, row, end - row, numCols_,
+								 &recordChunks_[index].bytes);
+				recorder_.addEncodeTime(nanosecondsSince(start));
+			}
+			if (memoryBudget_ != 0)
+				evictRows(row, end, end == endRow);
+		}
+	}
+	else if (!computeTiles(startRow, endRow, stop))
+		return;
+
+	if (frameThisGeneration_)
+		publishBandView(index, count, grid_[next].data());
+}
+
+
+//	Rows of the windows of a band of grids in backing files: a window of
+//	the current grid and one of the next, and as much again read ahead, for
+//	each of count bands
+unsigned int CellEngine::windowRows(unsigned int count) const
+{
+	size_t rows = memoryBudget_ / (4 * (size_t) count * numCols_);
+	return (unsigned int) std::clamp<size_t>(rows, 1, numRows_);
+}
+
+
+//	Starts reading in the rows of a window of the next grid, and of the
+//	current one (with the row after them)
+void CellEngine::prefetchRows(unsigned int startRow, unsigned int endRow)
+{
+	if (startRow >= endRow)
+		return;
+	size_t nc = numCols_;
+	grid_[current_].prefetch(startRow * nc, (std::min(endRow + 1, numRows_) - startRow) * nc);
+	grid_[1 - current_].prefetch(startRow * nc, (endRow - startRow) * nc);
+}
+
+
+//	Lets go of the rows of a window that was just computed, and of the rows
+//	of the current grid it was the last to read (the last window of a band
+//	is also the last to read the row after it)
+void CellEngine::evictRows(unsigned int startRow, unsigned int endRow, bool bandEnd)
+{
+	size_t nc = numCols_;
+	size_t first = startRow > 0 ? startRow - 1 : 0;
+	size_t last = bandEnd ? std::min(endRow + 1, numRows_) : endRow - 1;
+	grid_[1 - current_].evict(startRow * nc, (endRow - startRow) * nc, true);
+	if (last > first)
+		grid_[current_].evict(first * nc, (last - first) * nc, false);
+}
+
+
+//	Copies a whole board into grid, by windows that are let go of once
+//	written if it is in a backing file.  Only the pages that change are
+//	written: if the grid is zeroed (a new backing file), its pages that stay
+//	zero are not even read, so that the file only gets blocks for the parts
+//	of the board that are alive.
+void CellEngine::fillGrid(GridBuffer* grid, const uint8_t* cells, bool zeroed)
+{
+	size_t page = (size_t) sysconf(_SC_PAGESIZE);
+	size_t window = std::max(page, memoryBudget_ / 2 / page * page);
+	for (size_t start = 0; start < grid->size(); start += window)
+	{
+		size_t end = std::min(grid->size(), start + window);
+		for (size_t k = start; k < end; k += page)
+		{
+			size_t size = std::min(page, end - k);
+			if (zeroed ? !zeroBytes(cells + k, size) : memcmp(grid->data() + k, cells + k, size) != 0)
+				memcpy(grid->data() + k, cells + k, size);
+		}
+		grid->evict(start, end - start, true);
+	}
+}
+
+
+//	Wavefront band.  It keeps going from one generation to the next, only
+//	waiting for its neighbors, until a stop is requested (or the last
+//	generation of a step() is reached).
+//	Waiting for the neighbors to have published the edges of generation g
+//	before computing g+1 also guarantees that they are done reading our
+//	edge rows of generation g-1, which is what we overwrite (their interior
+//	rows never read ours).
+void CellEngine::computeWavefrontBand(unsigned int index, unsigned int count, std::stop_token stop)
+{
+	unsigned int startRow, endRow, above, below;
+	bandRows(index, count, &startRow, &endRow);
+	bandNeighbors(index, count, &above, &below);
+	BandSync& self = bands_[index];
+
+	while (!stop.stop_requested())
+	{
+		unsigned int g = self.generation.load(std::memory_order_relaxed);
+
+		//	step(): every band stops at the same generation
+		if (stopAtGeneration_ != 0 && wfStartGeneration_ + g >= stopAtGeneration_)
+			return;
+
+		//	The display asked for a frame: it will show generation g+count.
+		//	No band can have completed it yet, since a band is never more than
+		//	one generation ahead of its neighbors.
+		if (index == 0 && wfFrameGeneration_ == 0 && beginFrame())
+		{
+			wfFrameBands_ = count;
+			wfFrameGeneration_.store(g + count, std::memory_order_release);
+		}
+
+		if ((above < count && !waitForBand(above, g, stop)) ||
+			(below < count && !waitForBand(below, g, stop)))
+			return;
+
+		const uint8_t* src = grid_[(wfBase_ + g) % 2].data();
+		uint8_t* dst = grid_[(wfBase_ + g + 1) % 2].data();
+
+		//	Edge rows first, so that the neighbors can move on to g+1 while
+		//	we compute our interior
+		if (!computeRows(src, dst, startRow, startRow + 1, 0, numCols_, stop) ||
+			(endRow - 1 > startRow && !computeRows(src, dst, endRow - 1, endRow, 0, numCols_, stop)))
+			return;
+		{
+			std::lock_guard<std::mutex> guard(self.lock);
+			self.edgeGeneration.store(g + 1, std::memory_order_release);
+		}
+		self.published.notify_all();
+
+		if (endRow - startRow > 2 && !computeRows(src, dst, startRow + 1, endRow - 1, 0, numCols_, stop))
+			return;
+		self.generation.store(g + 1, std::memory_order_relaxed);
+
+		//	Our rows of the frame, before we move on and overwrite them.  The
+		//	last band to add its rows publishes the frame.
+		if (g + 1 == wfFrameGeneration_.load(std::memory_order_acquire))
+		{
+			publishBandView(index, count, dst);
+			if (wfFrameBands_.fetch_sub(1) == 1)
+			{
+				wfFrameGeneration_ = 0;
+				publishFrame(wfStartGeneration_ + g + 1, wfStartGeneration_ + g + 1 + edits_);
+			}
+		}
+
+		//	The first band sets the pace (no other band can get more than a
+		//	few generations ahead of it) and decides what cells() shows
+		if (index == 0)
+		{
+			current_ = (wfBase_ + g + 1) % 2;
+			generation_++;
+			if (paced_)
+				pacer_.pace(1, stop);
+		}
+	}
+}
+
+
+//	Blocks until band has published its edge rows for generation gen.
+//	Returns false if a stop was requested in the meantime.
+bool CellEngine::waitForBand(unsigned int band, unsigned int gen, std::stop_token stop)
+{
+	BandSync& other = bands_[band];
+
+	//	fast path: no need to lock if the neighbor is already there
+	if (other.edgeGeneration.load(std::memory_order_acquire) >= gen)
+		return true;
+
+	std::unique_lock<std::mutex> lock(other.lock);
+	return other.published.wait(lock, stop, [&other, gen] {
+		return other.edgeGeneration.load(std::memory_order_acquire) >= gen;
+	});
+}
+
+
+//	Called with all the bands stopped.  Finishes the generations needed to
+//	bring every band to the most advanced one, then makes that generation
+//	the current grid, so that the engine can be restarted (possibly with a
+//	different number of threads or another strategy) from a consistent state.
+void CellEngine::realignBands(unsigned int count)
+{
+	unsigned int target = 0;
+	for (unsigned int k = 0; k < count; k++)
+		target = std::max(target, bands_[k].generation.load());
+	unsigned int lead = bands_[0].generation;
+
+	//	The least advanced band always has neighbors whose edges are at least
+	//	as far as itself, so each sweep makes progress.
+	bool lagging = true;
+	while (lagging)
+	{
+		lagging = false;
+		for (unsigned int k = 0; k < count; k++)
+		{
+			unsigned int g = bands_[k].generation;
+			if (g == target)
+				continue;
+			lagging = true;
+
+			unsigned int startRow, endRow, above, below;
+			bandRows(k, count, &startRow, &endRow);
+			bandNeighbors(k, count, &above, &below);
+			const uint8_t* src = grid_[(wfBase_ + g) % 2].data();
+			uint8_t* dst = grid_[(wfBase_ + g + 1) % 2].data();
+
+			//	Edges that were already published must not be recomputed: the
+			//	neighbors' halo rows they were computed from may be gone.
+			if (bands_[k].edgeGeneration == g)
+			{
+				if ((above < count && bands_[above].edgeGeneration < g) ||
+					(below < count && bands_[below].edgeGeneration < g))
+					continue;
+
+				computeRows(src, dst, startRow, startRow + 1, 0, numCols_, std::stop_token());
+				computeRows(src, dst, endRow - 1, endRow, 0, numCols_, std::stop_token());
+				bands_[k].edgeGeneration = g + 1;
+			}
+			if (endRow - startRow > 2)
+				computeRows(src, dst, startRow + 1, endRow - 1, 0, numCols_, std::stop_token());
+			bands_[k].generation = g + 1;
+		}
+	}
+
+	//	the generation counter follows the first band
+	generation_ += target - lead;
+	current_ = (wfBase_ + target) % 2;
+}
+
+
+//	Async strategy: random cells are updated in place, one at a time, as in
+//	the lock-based version of the program.  A cell is updated while holding
+//	the locks of its row and of the rows above and below (wrapping around,
+//	so that the same code works for every border behavior); std::scoped_lock
+//	acquires them without risk of deadlock.
+void CellEngine::computeAsyncUpdates(unsigned int index, unsigned int count, std::stop_token stop)
+{
+	(void) index;
+	static thread_local std::minstd_rand generator(std::random_device{}());
+
+	const unsigned int nr = numRows_, nc = numCols_;
+	const unsigned long cellsPerGeneration = (unsigned long) nr * nc;
+	//	small enough that a batch rarely spans more than one generation
+	const unsigned long batch = std::clamp(cellsPerGeneration / (4 * count), 1ul, (unsigned long) ASYNC_BATCH);
+	uint8_t* grid = grid_[current_].data();
+
+	while (!stop.stop_requested())
+	{
+		if (stopAtGeneration_ != 0 && generation_ >= stopAtGeneration_)
+			return;
+
+		for (unsigned long k = 0; k < batch; k++)
+		{
+			unsigned int i = generator() % nr, j = generator() % nc;
+			//	(on boards of 1 or 2 rows, the rows above and below are the
+			//	same, and std::scoped_lock must not be given a mutex twice)
+			if (nr >= 3)
+			{
+				std::scoped_lock lock(rowLocks_[(i + nr - 1) % nr], rowLocks_[i], rowLocks_[(i + 1) % nr]);
+				grid[(size_t) i * nc + j] = cellState(grid, i, j);
+			}
+			else if (nr == 2)
+			{
+				std::scoped_lock lock(rowLocks_[0], rowLocks_[1]);
+				grid[(size_t) i * nc + j] = cellState(grid, i, j);
+			}
+			else
+			{
+				std::lock_guard<std::mutex> guard(rowLocks_[0]);
+				grid[(size_t) i * nc + j] = cellState(grid, i, j);
+			}
+		}
+
+		unsigned long before = asyncUpdates_.fetch_add(batch);
+		unsigned long crossed = (before + batch) / cellsPerGeneration - before / cellsPerGeneration;
+		for (unsigned long k = 0; k < crossed; k++)
+		{
+			if (!claimGeneration())
+				return;
+			if (paced_)
+				pacer_.pace(1, stop);
+		}
+
+		//	(on large boards, generations are too far apart to wait for one)
+		if (beginFrame())
+		{
+			publishLockedView();
+			publishFrame(generation_, NO_CHANGE);
+		}
+	}
+}
+
+
+//	Counts one more async generation, unless that would go past the end of
+//	a step().  Returns false if the step is complete.
+bool CellEngine::claimGeneration(void)
+{
+	unsigned long g = generation_;
+	do
+	{
+		if (stopAtGeneration_ != 0 && g >= stopAtGeneration_)
+			return false;
+	}
+	while (!generation_.compare_exchange_weak(g, g + 1));
+	return true;
+}
+
+
+//	Computes rows [startRow, endRow) of the next generation, tile by tile.
+//	A tile is only computed if it or one of its neighbors may be alive in
+//	the current grid (none of our rules brings a cell to life without live
+//	neighbors, but a random border does): the others are dead in the next
+//	grid, and are only written if they were not already.  Tiles to compute
+//	that follow each other are computed together, so that a board alive all
+//	over goes through whole rows.  Returns false if interrupted.
+bool CellEngine::computeTiles(unsigned int startRow, unsigned int endRow, std::stop_token stop)
+{
+	const size_t nc = numCols_;
+	const unsigned int ntr = numTileRows_, ntc = numTileCols_;
+	const uint8_t* src = grid_[current_].data();
+	uint8_t* dst = grid_[1 - current_].data();
+	const std::atomic<uint8_t>* srcTiles = tiles_[current_].get();
+	std::atomic<uint8_t>* dstTiles = tiles_[1 - current_].get();
+	bool wrap = activeFrame_ == FRAME_WRAP, skip = skipTiles_, everywhere = nextState_[0][0] != 0 || !skip;
+
+	//	tiles of the tile row (and of the tile rows around it) that may be
+	//	alive, then those to compute
+	static thread_local std::vector<uint8_t> live, needed;
+	live.resize(ntc);
+	needed.resize(ntc);
+
+	unsigned int end;
+	for (unsigned int row = startRow; row < endRow; row = end)
+	{
+		unsigned int tr = row / TILE_SIZE;
+		end = row + std::min(endRow - row, TILE_SIZE - row % TILE_SIZE);
+
+		for (unsigned int tc = 0; tc < ntc; tc++)
+		{
+			uint8_t flags = srcTiles[(size_t) tr * ntc + tc].load(std::memory_order_relaxed);
+			if (tr > 0 || wrap)
+				flags |= srcTiles[(size_t) ((tr + ntr - 1) % ntr) * ntc + tc].load(std::memory_order_relaxed);
+			if (tr < ntr - 1 || wrap)
+				flags |= srcTiles[(size_t) ((tr + 1) % ntr) * ntc + tc].load(std::memory_order_relaxed);
+			live[tc] = flags & TILE_LIVE;
+		}
+		bool borderRow = activeFrame_ == FRAME_RANDOM && (tr == 0 || tr == ntr - 1);
+		for (unsigned int tc = 0; tc < ntc; tc++)
+			needed[tc] = everywhere || borderRow || live[tc] ||
+						 ((tc > 0 || wrap) && live[(tc + ntc - 1) % ntc]) ||
+						 ((tc < ntc - 1 || wrap) && live[(tc + 1) % ntc]) ||
+						 (activeFrame_ == FRAME_RANDOM && (tc == 0 || tc == ntc - 1));
+
+		std::atomic<uint8_t>* tiles = dstTiles + (size_t) tr * ntc;
+		for (unsigned int tc = 0, last; tc < ntc; tc = last)
+		{
+			last = tc + 1;
+			while (last < ntc && needed[last] == needed[tc])
+				last++;
+
+			if (!needed[tc])
+			{
+				for (unsigned int k = tc; k < last; k++)
+					if (tiles[k].load(std::memory_order_relaxed) & TILE_LIVE)
+						clearRect(dst + row * nc + k * TILE_SIZE, nc, end - row,
+								  std::min(TILE_SIZE, numCols_ - k * TILE_SIZE));
+				continue;
+			}
+
+			unsigned int endCol = last < ntc ? last * TILE_SIZE : numCols_;
+			bool done = computeRows(src, dst, row, end, tc * TILE_SIZE, endCol, stop);
+			for (unsigned int k = tc; k < last; k++)
+				if (!done || !skip || !deadRect(dst + row * nc + k * TILE_SIZE, nc, end - row,
+												std::min(TILE_SIZE, numCols_ - k * TILE_SIZE)))
+					tiles[k].fetch_or(TILE_LIVE_NEXT, std::memory_order_relaxed);
+			if (!done)
+				return false;
+		}
+	}
+	return true;
+}
+
+
+//	Computes the next state of the cells of rows [startRow, endRow) and
+//	columns [startCol, endCol) of src into dst.  The stop token is polled at
+//	each row.  Returns false if interrupted.
+bool CellEngine::computeRows(const uint8_t* src, uint8_t* dst, unsigned int startRow, unsigned int endRow,
+							 unsigned int startCol, unsigned int endCol, std::stop_token stop)
+{
+	const unsigned int nc = numCols_;
+	const unsigned int first = std::max(startCol, 1u), last = std::min(endCol, nc - 1);
+
+	for (unsigned int i = startRow; i < endRow; i++)
+	{
+		if (stop.stop_requested())
+			return false;
+
+		uint8_t* out = dst + (size_t) i * nc;
+
+		//	first and last rows: all border cells
+		if (i == 0 || i == numRows_ - 1)
+		{
+			for (unsigned int j = startCol; j < endCol; j++)
+				out[j] = borderState(src, i, j);
+			continue;
+		}
+
+		const uint8_t* up = src + (size_t) (i - 1) * nc;
+		const uint8_t* row = up + nc;
+		const uint8_t* down = row + nc;
+
+		if (startCol == 0)
+			out[0] = borderState(src, i, 0);
+		for (unsigned int j = first; j < last; j++)
+		{
+			unsigned int count = (up[j-1] != 0) + (up[j] != 0) + (up[j+1] != 0) +
+								 (row[j-1] != 0) + (row[j+1] != 0) +
+								 (down[j-1] != 0) + (down[j] != 0) + (down[j+1] != 0);
+			out[j] = nextState_[row[j]][count];
+		}
+		if (endCol == nc)
+			out[nc - 1] = borderState(src, i, nc - 1);
+	}
+	return true;
+}
+
+
+//	Next state of any single cell
+uint8_t CellEngine::cellState(const uint8_t* src, unsigned int i, unsigned int j) const
+{
+	const unsigned int nc = numCols_;
+	if (i == 0 || i == numRows_ - 1 || j == 0 || j == nc - 1)
+		return borderState(src, i, j);
+
+	const uint8_t* up = src + (size_t) (i - 1) * nc;
+	const uint8_t* row = up + nc;
+	const uint8_t* down = row + nc;
+	unsigned int count = (up[j-1] != 0) + (up[j] != 0) + (up[j+1] != 0) +
+						 (row[j-1] != 0) + (row[j+1] != 0) +
+						 (down[j-1] != 0) + (down[j] != 0) + (down[j+1] != 0);
+	return nextState_[row[j]][count];
+}
+
+
+//	Next state of a cell on the border of the board
+uint8_t CellEngine::borderState(const uint8_t* src, unsigned int i, unsigned int j) const
+{
+	const unsigned int nr = numRows_, nc = numCols_;
+	unsigned int count = 0;
+
+	switch (activeFrame_)
+	{
+		case FRAME_DEAD:
+			return 0;
+
+		case FRAME_RANDOM:
+		{
+			static thread_local std::minstd_rand generator(std::random_device{}());
+			count = generator() % 9;
+			break;
+		}
+
+		case FRAME_CLIPPED:
+			for (int di = -1; di <= 1; di++)
+				for (int dj = -1; dj <= 1; dj++)
+				{
+					long ii = (long) i + di, jj = (long) j + dj;
+					if ((di != 0 || dj != 0) && ii >= 0 && ii < (long) nr && jj >= 0 && jj < (long) nc)
+						count += src[(size_t) ii * nc + jj] != 0;
+				}
+			break;
+
+		case FRAME_WRAP:
+			for (int di = -1; di <= 1; di++)
+				for (int dj = -1; dj <= 1; dj++)
+				{
+					unsigned int ii = (i + nr + di) % nr, jj = (j + nc + dj) % nc;
+					if (di != 0 || dj != 0)
+						count += src[(size_t) ii * nc + jj] != 0;
+				}
+			break;
+	}
+
+	return nextState_[src[(size_t) i * nc + j]][count];
+}
+
+
+//	Called by the last thread to reach the barrier, while all the others
+//	are blocked.  A generation interrupted by a stop is simply dropped:
+//	the current grid is still intact and will be recomputed from.
+bool CellEngine::endOfGeneration(bool completed)
+{
+	if (!completed)
+	{
+		//	The generation will be recomputed, maybe with other bands: the
+		//	frame starts over
+		if (frameThisGeneration_)
+			prepareFrame(frames_[backFrame_].view);
+		prepareEncoding();
+		settleTiles(false);
+		return false;
+	}
+
+	settleTiles(true);
+	current_ = 1 - current_;
+	generation_++;
+	if (encoding_)
+	{
+		if (recorder_.isRecording())
+			recorder_.addRecord(generation_, encodeKeyframe_, recordChunks_.get(), MAX_NUM_THREADS);
+		rewind_.add(generation_, encodeKeyframe_, recordChunks_.get(), MAX_NUM_THREADS);
+		encodedEdits_ = edits_;
+	}
+	updateTransitionTable();
+	prepareEncoding();
+
+	//	The other threads wait at the barrier while we fork: the child gets
+	//	the board of this generation, and nothing else of it is shared (which
+	//	grids in backing files would be)
+	if (memoryBudget_ == 0 && saver_.due(generation_))
+	{
+		CheckpointHeader header;
+		checkpointHeader(&header);
+		saver_.save(NULL, header, grid_[current_].data(), &grid_[1 - current_], std::chrono::steady_clock::now());
+	}
+
+	if (frameThisGeneration_)
+		publishFrame(generation_, changeCount());
+	frameThisGeneration_ = beginFrame();
+
+	if (paced_)
+		pacer_.pace(1, pool_.stopToken());
+
+	return stopAtGeneration_ == 0 || generation_ < stopAtGeneration_;
+}
+
+
+//	Tile table of the grid that received the next generation: the tiles
+//	found alive are alive.  If the generation was interrupted, so are those
+//	that were before (the grid has rows of both generations).
+void CellEngine::settleTiles(bool completed)
+{
+	std::atomic<uint8_t>* tiles = tiles_[1 - current_].get();
+	size_t numTiles = (size_t) numTileRows_ * numTileCols_;
+	for (size_t k = 0; k < numTiles; k++)
+	{
+		uint8_t flags = tiles[k].load(std::memory_order_relaxed);
+		bool live = (flags & TILE_LIVE_NEXT) || (!completed && (flags & TILE_LIVE));
+		tiles[k].store(live ? TILE_LIVE : 0, std::memory_order_relaxed);
+	}
+}
+
+
+//	Sets the flags of every tile of grid_[grid]: TILE_LIVE when it was
+//	written all over, 0 when it is all dead
+void CellEngine::setTiles(unsigned int grid, uint8_t flags)
+{
+	size_t numTiles = (size_t) numTileRows_ * numTileCols_;
+	for (size_t k = 0; k < numTiles; k++)
+		tiles_[grid][k].store(flags, std::memory_order_relaxed);
+}
+
+
+//	Marks the tiles of grid_[grid] that cover rows [startRow, endRow) and
+//	columns [startCol, endCol) as alive
+void CellEngine::markTiles(unsigned int grid, unsigned int startRow, unsigned int endRow, unsigned int startCol,
+						   unsigned int endCol)
+{
+	if (startRow >= endRow || startCol >= endCol)
+		return;
+	for (unsigned int tr = startRow / TILE_SIZE; tr <= (endRow - 1) / TILE_SIZE; tr++)
+		for (unsigned int tc = startCol / TILE_SIZE; tc <= (endCol - 1) / TILE_SIZE; tc++)
+			tiles_[grid][(size_t) tr * numTileCols_ + tc].fetch_or(TILE_LIVE, std::memory_order_relaxed);
+}
+
+
+//	Settings of the encoding for the generation about to be computed (an
+//	interrupted one starts over).  It is a keyframe if the board was edited
+//	since the last generation encoded, or if the recording or the rewind
+//	buffer needs one (the generation before is not theirs, or at their
+//	keyframe interval).
+void CellEngine::prepareEncoding(void)
+{
+	unsigned long generation = generation_ + 1;
+	encoding_ = recorder_.isRecording() || rewind_.isEnabled();
+	encodeKeyframe_ = encoding_ && (encodedEdits_ != edits_ || recorder_.wantsKeyframe(generation) ||
+									rewind_.wantsKeyframe(generation));
+	for (unsigned int k = 0; k < MAX_NUM_THREADS; k++)
+		recordChunks_[k].bytes.clear();
+}
+
+
+void CellEngine::checkpointHeader(CheckpointHeader* header) const
+{
+	*header = {};
+	header->numRows = numRows_;
+	header->numCols = numCols_;
+	header->rule = rule_;
+	header->frame = frame_;
+	header->colorMode = colorMode_;
+	header->generation = generation_;
+	header->seed = seed_;
+}
+
+
+//	True if the display's frame does not show the current board as seen
+//	through the current view
+bool CellEngine::frontFrameStale(void) const
+{
+	const ViewFrame& front = frames_[frontFrame_];
+	return front.sequence == 0 || front.change != changeCount() || !sameView(front.view, view_);
+}
+
+
+//	Takes the back frame for the view the display asked for, if it did and
+//	no other frame is being written.  Returns true if the caller now has to
+//	fill it and publish it.
+bool CellEngine::beginFrame(void)
+{
+	if (!frameRequested_.load(std::memory_order_acquire) || writingFrame_.exchange(true, std::memory_order_acquire))
+		return false;
+
+	prepareFrame(requestedView_);
+	frameRequested_.store(false, std::memory_order_release);
+	return true;
+}
+
+
+//	Sizes the back frame for view, with all its cells dead
+void CellEngine::prepareFrame(const BoardView& view)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	ViewFrame& frame = frames_[backFrame_];
+	frame.view = view;
+	frame.numRows = (view.numRows + view.block - 1) / view.block;
+	frame.numCols = (view.numCols + view.block - 1) / view.block;
+	frame.cells.assign((size_t) frame.numRows * frame.numCols, 0);
+
+	publishNanos_ += nanosecondsSince(start);
+}
+
+
+//	Adds the rows of band index (out of count) of grid src to the back
+//	frame.  A row of blocks that lies within the band is written directly;
+//	one that straddles two bands is merged with what the other band writes.
+void CellEngine::publishBandView(unsigned int index, unsigned int count, const uint8_t* src)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	ViewFrame& frame = frames_[backFrame_];
+	const BoardView& view = frame.view;
+	const unsigned int block = view.block;
+	unsigned int startRow, endRow;
+	bandRows(index, count, &startRow, &endRow);
+	startRow = std::max(startRow, view.row);
+	endRow = std::min(endRow, view.row + view.numRows);
+
+	static thread_local std::vector<uint8_t> blocks;
+	blocks.resize(frame.numCols);
+
+	for (unsigned int r = startRow >= endRow ? frame.numRows : (startRow - view.row) / block;
+		 r < frame.numRows && view.row + r * block < endRow; r++)
+	{
+		unsigned int top = view.row + r * block;
+		unsigned int bottom = std::min(top + block, view.row + view.numRows);
+		unsigned int first = std::max(top, startRow), last = std::min(bottom, endRow);
+		const uint8_t* rows = src + (size_t) first * numCols_ + view.col;
+		uint8_t* out = frame.cells.data() + (size_t) r * frame.numCols;
+
+		if (first == top && last == bottom)
+			reduceBlocks(rows, numCols_, last - first, view.numCols, block, out);
+		else
+		{
+			reduceBlocks(rows, numCols_, last - first, view.numCols, block, blocks.data());
+			mergeBlocks(blocks.data(), frame.numCols, out, true);
+		}
+	}
+
+	publishNanos_ += nanosecondsSince(start);
+}
+
+
+//	Async strategy: fills the back frame from the grid being updated, one
+//	row at a time, each row read under its lock.  Each row is consistent,
+//	but rows are read at slightly different times (there are no
+//	generations to speak of anyway).
+void CellEngine::publishLockedView(void)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	ViewFrame& frame = frames_[backFrame_];
+	const BoardView& view = frame.view;
+	const uint8_t* grid = grid_[current_].data();
+
+	static thread_local std::vector<uint8_t> row, blocks;
+	row.resize(view.numCols);
+	blocks.resize(frame.numCols);
+
+	for (unsigned int i = view.row; i < view.row + view.numRows; i++)
+	{
+		{
+			std::lock_guard<std::mutex> guard(rowLocks_[i]);
+			memcpy(row.data(), grid + (size_t) i * numCols_ + view.col, view.numCols);
+		}
+		reduceBlocks(row.data(), view.numCols, 1, view.numCols, view.block, blocks.data());
+		mergeBlocks(blocks.data(), frame.numCols,
+					frame.cells.data() + (size_t) ((i - view.row) / view.block) * frame.numCols, false);
+	}
+
+	publishNanos_ += nanosecondsSince(start);
+}
+
+
+//	Publishes the back frame, which shows the board at the given generation
+//	and change count, and takes the previous latest frame (that the display
+//	did not pick) as the new back frame
+void CellEngine::publishFrame(unsigned long generation, unsigned long change)
+{
+	ViewFrame& frame = frames_[backFrame_];
+	frame.generation = generation;
+	frame.change = change;
+	frame.sequence = ++publishedFrames_;
+
+	backFrame_ = middleFrame_.exchange(backFrame_ | FRESH_FRAME) & ~FRESH_FRAME;
+	writingFrame_.store(false, std::memory_order_release);
+}
+
+
+//	Reduces the rows x cols cells at src (stored with rows of srcStride
+//	cells) by blocks of block x block cells into dst (ceil(rows/block) rows
+//	of ceil(cols/block) cells).  Each block gets its highest state.
+static void reduceBlocks(const uint8_t* src, size_t srcStride, unsigned int rows, unsigned int cols,
+						 unsigned int block, uint8_t* dst)
+{
+	unsigned int dstRows = (rows + block - 1) / block, dstCols = (cols + block - 1) / block;
+
+	for (unsigned int r = 0; r < dstRows; r++)
+	{
+		uint8_t* out = dst + (size_t) r * dstCols;
+		std::fill(out, out + dstCols, 0);
+
+		unsigned int lastRow = std::min((r + 1) * block, rows);
+		for (unsigned int i = r * block; i < lastRow; i++)
+		{
+			const uint8_t* row = src + (size_t) i * srcStride;
+			for (unsigned int c = 0, j = 0; c < dstCols; c++)
+			{
+				unsigned int lastCol = std::min(j + block, cols);
+				uint8_t state = out[c];
+				for (; j < lastCol; j++)
+					state = std::max(state, row[j]);
+				out[c] = state;
+			}
+		}
+	}
+}
+
+
+//	Raises each of the cols cells of dst to the state of the cell of src.
+//	Shared cells may be merged by another thread at the same time.
+static void mergeBlocks(const uint8_t* src, unsigned int cols, uint8_t* dst, bool shared)
+{
+	for (unsigned int c = 0; c < cols; c++)
+	{
+		if (!shared)
+			dst[c] = std::max(dst[c], src[c]);
+		else
+		{
+			std::atomic_ref<uint8_t> cell(dst[c]);
+			uint8_t state = cell.load(std::memory_order_relaxed);
+			while (state < src[c] && !cell.compare_exchange_weak(state, src[c], std::memory_order_relaxed))
+				;
+		}
+	}
+}
+
+
+static bool sameView(const BoardView& a, const BoardView& b)
+{
+	return a.row == b.row && a.col == b.col && a.numRows == b.numRows && a.numCols == b.numCols &&
+		   a.block == b.block;
+}
+
+
+static unsigned long nanosecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+static bool zeroBytes(const uint8_t* bytes, size_t size)
+{
+	return size == 0 || (bytes[0] == 0 && memcmp(bytes, bytes + 1, size - 1) == 0);
+}
+
+
+//	True if the rows x cols cells at cells (in rows of stride cells) are all
+//	dead.  Stops at the first live one.
+static bool deadRect(const uint8_t* cells, size_t stride, unsigned int rows, unsigned int cols)
+{
+	for (unsigned int i = 0; i < rows; i++)
+		if (!zeroBytes(cells + i * stride, cols))
+			return false;
+	return true;
+}
+
+
+//	Kills the rows x cols cells at cells (in rows of stride cells), only
+//	writing the rows that have live cells, so that the pages of those that
+//	are dead are not touched.  Returns true if any row was written.
+static bool clearRect(uint8_t* cells, size_t stride, unsigned int rows, unsigned int cols)
+{
+	bool written = false;
+	for (unsigned int i = 0; i < rows; i++)
+		if (!zeroBytes(cells + i * stride, cols))
+		{
+			memset(cells + i * stride, 0, cols);
+			written = true;
+		}
+	return written;
+}
+
+
+//	End of the range [start, start+length) clipped to [0, limit), for any
+//	start and length (the sum is not computed when it could overflow)
+static unsigned int coveredEnd(int64_t start, uint64_t length, unsigned int limit)
+{
+	if (start >= (int64_t) limit || length >= (uint64_t) limit - (uint64_t) start)
+		return limit;
+	return (unsigned int) std::max<int64_t>(start + (int64_t) length, 0);
+}
+
+
+//	Rebuilds nextState_ from the current rule and color mode.  In black and
+//	white mode, only alive/dead matters.  In color mode, the state of a live
+//	cell reflects its age: it gets one generation older until it reaches
+//	the "very old cell" stage.
+void CellEngine::updateTransitionTable(void)
+{
+	RuleMasks masks = {0, 0};
+	ruleMasks(rule_, &masks);
+	bool color = colorMode_;
+
+	for (unsigned int state = 0; state < NUM_CELL_STATES; state++)
+	{
+		unsigned int mask = state == 0 ? masks.birth : masks.survival;
+		for (unsigned int count = 0; count <= 8; count++)
+		{
+			uint8_t next = 0;
+			if (mask & (1u << count))
+				next = color ? std::min(state + 1, NUM_CELL_STATES - 1) : 1;
+			nextState_[state][count] = next;
+		}
+	}
+	activeFrame_ = frame_;
+}
+
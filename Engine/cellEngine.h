@@ -0,0 +1,464 @@
+//
+//  cellEngine.h
+//  Cellular Automaton
+//
+//	The simulation core, independent of any front end.  A CellEngine owns a
+//	board of numRows x numCols cells, stored row by row with one byte per
+//	cell: 0 for a dead cell, otherwise the "age" of a live cell (1 to
+//	NUM_CELL_STATES-1 in color mode, always 1 otherwise).  Generations are
+//	computed by a WorkerPool, following one of several execution strategies
+//	(see ExecutionStrategy), which can be switched while the engine runs.
+//
+//	The board is also cut into tiles of TILE_SIZE x TILE_SIZE cells, each
+//	grid with a table of the tiles that may hold live cells.  The serial and
+//	banded strategies, and hosted generations, skip the tiles that are dead
+//	along with their neighbors, without touching their memory.  The grids
+//	only get memory for the pages that are written (see GridBuffer), but
+//	the tiles do not map to pages: the rows are stored whole, so a row of a
+//	tile is TILE_SIZE bytes and a page holds a row of 16 tiles side by side
+//	(with 4 KB pages).  A live tile thus costs memory, and time to read in,
+//	for its row of 16 tiles, live or not, and a board with a few live cells
+//	scattered in each such row gets memory for all of it.  Memory follows
+//	the live parts of a large board only in that coarser sense.
+//
+//	The engine can either be stepped synchronously (step() computes a number
+//	of generations as fast as possible and returns), or run in the background
+//	(run() / pause()), paced by its Pacer.  Simulation parameters (rule,
+//	color mode, border behavior, number of threads) can be changed at any
+//	time and are picked up at the next generation.
+//
+//	The engine can be controlled from several threads (say, the GUI and a
+//	command server): the methods that start or stop the compute threads
+//	take turns on a lock, which the compute threads themselves never take.
+//	A long step() holds it until it returns.
+//
+
+#ifndef CELL_ENGINE_H
+#define CELL_ENGINE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <vector>
+//
+#include "backgroundSaver.h"
+#include "gridBuffer.h"
+#include "pacer.h"
+#include "patternFile.h"
+#include "recording.h"
+#include "rewindBuffer.h"
+#include "workerPool.h"
+
+//	Rules of the automaton
+#define GAME_OF_LIFE_RULE	1	//	B3/S23
+#define CORAL_GROWTH_RULE	2	//	B3/S45678
+#define AMOEBA_RULE			3	//	B357/S1358
+#define MAZE_RULE			4	//	B3/S12345
+
+//	Number of cell states: dead, plus the ages of a live cell in color mode
+const unsigned int NUM_CELL_STATES = 6;
+
+//	Upper bound on the number of compute threads
+const unsigned int MAX_NUM_THREADS = 256;
+
+//	Rows and columns of cells of a tile of the board
+const unsigned int TILE_SIZE = 256;
+
+//	Memory the windows of a board in backing files take unless told
+//	otherwise (see CellEngine::backWithFiles())
+const size_t DEFAULT_MEMORY_BUDGET = (size_t) 1 << 30;
+
+//	How things are handled at the border of the board
+typedef enum FrameBehavior {
+	FRAME_DEAD = 0,		//	cell borders are kept dead
+	FRAME_RANDOM,		//	new random values are generated at each generation
+	FRAME_CLIPPED,		//	same rule as elsewhere, with clipping to stay within bounds
+	FRAME_WRAP			//	same rule as elsewhere, with wrapping around at edges
+} FrameBehavior;
+
+//	How the compute threads share the work
+typedef enum ExecutionStrategy {
+	STRATEGY_SERIAL = 0,	//	a single thread computes whole generations
+	STRATEGY_BANDED,		//	one band of rows per thread, all threads meet at a barrier
+	STRATEGY_WAVEFRONT,		//	one band of rows per thread, a band only waits for its neighbors
+	STRATEGY_ASYNC,			//	threads update random cells in place, under row locks
+	//
+	NUM_STRATEGIES
+} ExecutionStrategy;
+
+//	Name of a strategy ("serial", "banded", "wavefront", "async")
+const char* strategyName(ExecutionStrategy strategy);
+
+//	Returns false if name is not the name of a strategy
+bool parseStrategy(const char* name, ExecutionStrategy* strategy);
+
+//	Rule in the notation of pattern files, as "B3/S23" (NULL for an unknown
+//	rule number)
+const char* ruleString(unsigned int rule);
+
+//	Rule number of a rule written as "B3/S23" or "23/3" (survival/birth),
+//	in any case, or 0 if it is none of ours
+unsigned int parseRuleString(const char* text);
+
+//	A copy of the board at a given generation
+typedef struct GridSnapshot {
+	unsigned long generation;
+	unsigned int numRows, numCols;
+	std::vector<uint8_t> cells;
+} GridSnapshot;
+
+
+//	A rectangle of the board: rows [row, row+numRows) and columns [col,
+//	col+numCols), reduced by blocks of block x block cells (1: no reduction).
+//	Each block holds the highest state of its cells, so that a block with
+//	any live cell is alive.
+typedef struct BoardView {
+	unsigned int row, col;
+	unsigned int numRows, numCols;
+	unsigned int block;
+} BoardView;
+
+//	The view of one complete generation, as published for display
+typedef struct ViewFrame {
+	BoardView view;
+	unsigned long generation;
+	unsigned long change;			//	changeCount() of the board it shows (~0: none)
+	unsigned long sequence;			//	1 for the first frame published, and so on (0: none)
+	unsigned int numRows, numCols;	//	ceil(view.numRows / view.block) x ceil(view.numCols / view.block)
+	std::vector<uint8_t> cells;
+} ViewFrame;
+
+class CellEngine
+{
+	public:
+
+		//	Creates an empty (all dead) board
+		CellEngine(unsigned int numCols, unsigned int numRows, unsigned int numThreads = 1);
+		~CellEngine(void);
+
+		CellEngine(const CellEngine&) = delete;
+		CellEngine& operator =(const CellEngine&) = delete;
+
+		unsigned int numRows(void) const;
+		unsigned int numCols(void) const;
+
+		//	Returns false (and changes nothing) for an unknown rule number
+		bool setRule(unsigned int rule);
+		unsigned int rule(void) const;
+
+		void setColorMode(bool on);
+		bool colorMode(void) const;
+
+		void setFrameBehavior(FrameBehavior frame);
+		FrameBehavior frameBehavior(void) const;
+
+		//	If the engine is running, it is paused (the wavefront strategy first
+		//	brings all its bands to the same generation) and resumed with the
+		//	new strategy, on the same board.
+		void setStrategy(ExecutionStrategy strategy);
+		ExecutionStrategy strategy(void) const;
+
+		//	The count is clamped to [1, min(numRows, MAX_NUM_THREADS)].  If the
+		//	engine is running, the banded strategy splits the generations that
+		//	follow the one in flight between the new number of threads, and
+		//	the wavefront and async strategies restart with it.  The serial
+		//	strategy always uses one thread.
+		void setNumThreads(unsigned int numThreads);
+		unsigned int numThreads(void) const;
+		unsigned int liveThreadCount(void) const;
+
+		//	On by default.  Off, the serial and banded strategies, and hosted
+		//	generations, compute every tile of the board, so that the time of
+		//	a generation does not depend on how much of it is dead (for the
+		//	benchmarks).  Can be changed while the engine runs.
+		void setTileSkipping(bool on);
+		bool tileSkipping(void) const;
+
+		//	Board contents.  These pause the engine while they write, and
+		//	resume it afterwards if it was running.
+		void randomize(unsigned int seed, double density = 0.5);
+		void clear(void);
+		void setCell(unsigned int row, unsigned int col, uint8_t state);
+		uint8_t cell(unsigned int row, unsigned int col) const;
+
+		//	Out-of-core boards: moves both grids, with the current board, to
+		//	backing files created in directory (see GridBuffer), so that the
+		//	board can be larger than the memory.  The serial and banded
+		//	strategies, and hosted generations, then go through each band by
+		//	windows of rows: the next window is read ahead while one is
+		//	computed, and the pages of the last one are let go of, so that the
+		//	windows of all bands take about memoryBudget bytes.  The wavefront
+		//	and async strategies still work, but page at random.  Background
+		//	checkpoints are refused (errno ENOTSUP): the child would share the
+		//	grids rather than get a copy of them.  Pauses the engine while it
+		//	works, and resumes it afterwards if it was running.  Returns false,
+		//	with errno set, on failure (the grids are then left as they were).
+		bool backWithFiles(const char* directory, size_t memoryBudget = DEFAULT_MEMORY_BUDGET);
+		bool isFileBacked(void) const;
+
+		//	Computes numGenerations generations, unthrottled, and returns when
+		//	they are done.  A background run is paused first.
+		void step(unsigned long numGenerations = 1);
+
+		//	Runs generations in the background, paced by pacer(), until pause()
+		void run(void);
+		void pause(void);
+		bool isRunning(void) const;
+
+		Pacer& pacer(void);
+
+		//	Number of generations computed since the engine was created.  With
+		//	the async strategy, numRows*numCols cell updates count as one
+		//	generation.
+		unsigned long generation(void) const;
+
+		//	Changes whenever the board does (each generation and each edit).
+		//	Cheap enough to poll at every frame, to skip work on a board that
+		//	did not change.
+		unsigned long changeCount(void) const;
+
+		//	Current board, row by row.  While the engine runs, nothing
+		//	guarantees that all rows read belong to the same generation (the
+		//	frames of acquireFrame() do).
+		const uint8_t* cells(void) const;
+
+		//	Copies the current board (same caveat as cells())
+		void snapshot(GridSnapshot* snap) const;
+
+		//	Makes a copy taken by snapshot() the current board, at its
+		//	generation.  Pauses the engine while it writes, and resumes it
+		//	afterwards if it was running.  Returns false, with errno set to
+		//	EINVAL, if the copy is of a board of another size.
+		bool restoreSnapshot(const GridSnapshot& snap);
+
+		//	Checkpoints (see checkpoint.h): the board, its rule, color mode,
+		//	border behavior, generation count and seed.  Saving pauses the
+		//	engine while it writes.  Loading maps the file rather than reading
+		//	it, and fails with errno set to EINVAL if the checkpoint is for a
+		//	board of another size.  Both return false, with errno set, on
+		//	failure, and resume the engine afterwards if it was running.
+		bool saveCheckpoint(const char* path);
+		bool loadCheckpoint(const char* path);
+
+		//	Background checkpoints (see backgroundSaver.h): a child process
+		//	writes the board while the engine keeps going.  Scheduled ones
+		//	(see BackgroundSaver::setSchedule()) are taken at the generation
+		//	boundaries of the serial and banded strategies, and of hosted
+		//	generations.  saveCheckpointInBackground() forks at the next such
+		//	boundary if the engine is running one of these strategies;
+		//	otherwise (a paused engine, or the wavefront and async strategies,
+		//	whose threads never all stop between two generations) it pauses
+		//	the engine for the fork and resumes it.  Returns false, with errno
+		//	set, if a child could not be started right away.
+		bool saveCheckpointInBackground(const char* path);
+		BackgroundSaver& backgroundSaver(void);
+
+		//	Pattern files (see patternFile.h).  placePattern() overwrites the
+		//	rectangle of the board covered by pattern, its top left corner at
+		//	(row, col), drops whatever falls off the board, and switches to the
+		//	rule of the pattern if it names one of ours.  savePattern() writes
+		//	the bounding box of the live cells, and returns false, with errno
+		//	set, on failure.  Both pause the engine while they work, and
+		//	resume it afterwards if it was running.
+		void placePattern(const Pattern& pattern, int64_t row, int64_t col);
+		bool savePattern(const char* path, PatternFormat format);
+
+		//	Recordings (see recording.h) of the generations computed by the
+		//	serial and banded strategies, and of hosted generations, until
+		//	stopRecording().  The wavefront and async strategies are not
+		//	recorded: the recording goes on with a keyframe when the engine
+		//	leaves them.  startRecording() records the current board as the
+		//	first keyframe.  Both pause the engine while they work, resume it
+		//	afterwards if it was running, and return false, with errno set,
+		//	on failure.
+		bool startRecording(const char* path, unsigned long keyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
+		bool stopRecording(void);
+		Recorder& recorder(void);
+
+		//	Makes the board of a generation of a recording the current one,
+		//	at that generation count (the rule and other settings are left as
+		//	they are).  Fails with errno set to EINVAL if the recording is of
+		//	a board of another size or has cells of no known state, and to
+		//	ERANGE if it does not have that generation.  Pauses the engine as loadCheckpoint() does.
+		bool loadRecordedGeneration(const char* path, unsigned long generation);
+
+		//	Rewinding (see rewindBuffer.h): the last generations computed by
+		//	the serial and banded strategies, and hosted generations, are
+		//	kept in memory, once setRewindDepth() asks for some.  rewindTo()
+		//	takes the board back to one of them, or forward again, and leaves
+		//	the engine paused there: running resumes from it, and drops the
+		//	generations that came after.  stepBack() and stepForward() go to
+		//	the generation held closest to numGenerations away.  These return
+		//	false, with errno set to ERANGE, if no such generation is held.
+		void setRewindDepth(unsigned long numGenerations, size_t maxBytes = DEFAULT_REWIND_BYTES);
+		bool rewindTo(unsigned long generation);
+		bool stepBack(unsigned long numGenerations = 1);
+		bool stepForward(unsigned long numGenerations = 1);
+		RewindBuffer& rewindBuffer(void);
+
+		//	Display.  Frames are triple buffered: the compute threads write the
+		//	view of a generation they just completed into one frame and publish
+		//	it, while the display holds another one, and the third one is the
+		//	latest published.  Neither side ever waits for the other, and a
+		//	frame is never written while the display holds it.  Only one thread
+		//	(the display) should call these.
+
+		//	View to publish from now on (clipped to the board).  The whole
+		//	board, unreduced, until this is called.
+		void setView(const BoardView& view);
+
+		//	The latest frame published, which stays intact until the next call.
+		//	While the engine runs, each call asks the compute threads for the
+		//	view of one of their next generations, which they make in parallel
+		//	(its cost is proportional to the area of the view).  Otherwise, the
+		//	frame is made here if the board or the view has changed.
+		const ViewFrame& acquireFrame(void);
+
+		//	True if acquireFrame() would now return a different frame (one was
+		//	published since its last call, or the paused board or the view
+		//	changed).  Cheap enough to poll, to only draw new frames.
+		bool frameReady(void) const;
+
+		//	Number of frames published so far, and the time all threads spent
+		//	making them, in seconds
+		void publicationCost(unsigned long* numFrames, double* seconds) const;
+
+		//	Hosting: the generations of a paused engine can be computed by
+		//	threads it does not own (see Supervisor).  The host calls
+		//	beginHostedGeneration(), then computeHostedBand() for bands 0 to
+		//	count-1, in any threads, then endHostedGeneration() once they are
+		//	all done.  Meanwhile, nothing else may touch the board, and no
+		//	frames are published.  A generation that is not completed is
+		//	dropped.
+		void beginHostedGeneration(void);
+		void computeHostedBand(unsigned int index, unsigned int count, std::stop_token stop);
+		void endHostedGeneration(bool completed);
+
+	private:
+
+		struct BandSync;
+
+		void startPool(unsigned long stopAtGeneration, bool paced);
+		void restartIfFreeRunning(void);
+		void bandRows(unsigned int index, unsigned int count, unsigned int* startRow, unsigned int* endRow) const;
+		void bandNeighbors(unsigned int index, unsigned int count, unsigned int* above, unsigned int* below) const;
+		void computeBand(unsigned int index, unsigned int count, std::stop_token stop);
+		unsigned int windowRows(unsigned int count) const;
+		void prefetchRows(unsigned int startRow, unsigned int endRow);
+		void evictRows(unsigned int startRow, unsigned int endRow, bool bandEnd);
+		void fillGrid(GridBuffer* grid, const uint8_t* cells, bool zeroed);
+		void computeWavefrontBand(unsigned int index, unsigned int count, std::stop_token stop);
+		void computeAsyncUpdates(unsigned int index, unsigned int count, std::stop_token stop);
+		bool computeTiles(unsigned int startRow, unsigned int endRow, std::stop_token stop);
+		bool computeRows(const uint8_t* src, uint8_t* dst, unsigned int startRow, unsigned int endRow,
+						 unsigned int startCol, unsigned int endCol, std::stop_token stop);
+		uint8_t cellState(const uint8_t* src, unsigned int i, unsigned int j) const;
+		uint8_t borderState(const uint8_t* src, unsigned int i, unsigned int j) const;
+		bool waitForBand(unsigned int band, unsigned int gen, std::stop_token stop);
+		bool claimGeneration(void);
+		bool endOfGeneration(bool completed);
+		void settleTiles(bool completed);
+		void setTiles(unsigned int grid, uint8_t flags);
+		void markTiles(unsigned int grid, unsigned int startRow, unsigned int endRow, unsigned int startCol,
+					   unsigned int endCol);
+		void realignBands(unsigned int count);
+		void prepareEncoding(void);
+		void checkpointHeader(CheckpointHeader* header) const;
+		void updateTransitionTable(void);
+		bool beginFrame(void);
+		void prepareFrame(const BoardView& view);
+		void publishBandView(unsigned int index, unsigned int count, const uint8_t* src);
+		void publishLockedView(void);
+		void publishFrame(unsigned long generation, unsigned long change);
+		bool frontFrameStale(void) const;
+
+		unsigned int numRows_, numCols_;
+
+		//	The two grids: grid_[current_] is the current generation, the
+		//	other one receives the next generation
+		GridBuffer grid_[2];
+		std::atomic<unsigned int> current_;
+		//	for grids in backing files (0: in memory)
+		size_t memoryBudget_;
+
+		//	Tile tables: tiles_[k] has the flags (see TILE_LIVE) of the tiles
+		//	of grid_[k], row by row
+		unsigned int numTileRows_, numTileCols_;
+		std::unique_ptr<std::atomic<uint8_t>[]> tiles_[2];
+		std::atomic<bool> skipTiles_;
+
+		std::atomic<unsigned int> rule_;
+		std::atomic<bool> colorMode_;
+		std::atomic<FrameBehavior> frame_;
+
+		//	nextState_[state][count]: new state of a cell given its current
+		//	state and its number of live neighbors.  Only rebuilt between two
+		//	generations, from rule_ and colorMode_.
+		uint8_t nextState_[NUM_CELL_STATES][9];
+		FrameBehavior activeFrame_;
+
+		std::atomic<ExecutionStrategy> strategy_;
+		std::atomic<unsigned int> numThreads_;
+		std::atomic<unsigned long> generation_;
+		std::atomic<unsigned long> edits_;
+		//	last seed passed to randomize()
+		uint64_t seed_;
+
+		//	Wavefront strategy: per-band progress.  Generation g of the run
+		//	(counted from the start of the pool) lives in grid_[(wfBase_+g)%2].
+		std::unique_ptr<BandSync[]> bands_;
+		unsigned int wfBase_;
+		unsigned long wfStartGeneration_;
+
+		//	Async strategy: one lock per row (updating a cell locks its row and
+		//	the two rows around it), and the count of updates of the run
+		std::unique_ptr<std::mutex[]> rowLocks_;
+		std::atomic<unsigned long> asyncUpdates_;
+
+		//	Published frames.  frames_[backFrame_] is the one being written,
+		//	frames_[frontFrame_] is held by the display, and middleFrame_ is the
+		//	latest published (with FRESH_FRAME set until the display takes it).
+		//	Whoever sets writingFrame_ owns the back frame until it publishes.
+		ViewFrame frames_[3];
+		unsigned int backFrame_, frontFrame_;
+		std::atomic<unsigned int> middleFrame_;
+		std::atomic<bool> writingFrame_;
+		//	view set by the display, and the one it asked the compute threads for
+		BoardView view_, requestedView_;
+		std::atomic<bool> frameRequested_;
+		//	serial and banded strategies: the generation in flight gets published
+		bool frameThisGeneration_;
+		//	wavefront strategy: generation of the run to publish (0: none), and
+		//	number of bands that have yet to add their rows to it
+		std::atomic<unsigned int> wfFrameGeneration_;
+		std::atomic<unsigned int> wfFrameBands_;
+		std::atomic<unsigned long> publishedFrames_, publishNanos_;
+
+		//	Recording and rewinding: each band encodes the rows it computes
+		//	into its own chunk, which become a record at the end of the
+		//	generation, for both.  The settings of the generation in flight,
+		//	then the edit count when the last generation was encoded (an
+		//	edit since makes the next record a keyframe).
+		std::unique_ptr<RecordChunk[]> recordChunks_;
+		bool encoding_, encodeKeyframe_;
+		unsigned long encodedEdits_;
+
+		//	taken by the methods that start or stop the pool
+		mutable std::recursive_mutex controlLock_;
+
+		//	settings of the current run of the pool (0: no generation limit)
+		unsigned long stopAtGeneration_;
+		bool paced_;
+
+		Pacer pacer_;
+		BackgroundSaver saver_;
+		Recorder recorder_;
+		RewindBuffer rewind_;
+
+		//	declared last, so that it is stopped before anything else goes away
+		WorkerPool pool_;
+};
+
+#endif	//	CELL_ENGINE_H
@@ -0,0 +1,141 @@
+//
+//  checkpoint.cpp
+//  Cellular Automaton
+//
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+//
+#include "checkpoint.h"
+
+static const char CHECKPOINT_MAGIC[8] = {'C', 'E', 'L', 'L', 'C', 'K', 'P', 'T'};
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+static bool writeAll(int fd, struct iovec* parts, int numParts);
+
+
+bool writeCheckpoint(const char* path, CheckpointHeader header, const uint8_t* cells)
+{
+	memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+	header.byteOrder = BYTE_ORDER_MARK;
+	header.version = CHECKPOINT_VERSION;
+	header.headerSize = CHECKPOINT_HEADER_SIZE;
+	header.cellsSize = (uint64_t) header.numRows * header.numCols;
+
+	static uint8_t page[CHECKPOINT_HEADER_SIZE];
+	char tmpPath[PATH_MAX];
+	if (snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path) >= (int) sizeof(tmpPath))
+	{
+		errno = ENAMETOOLONG;
+		return false;
+	}
+	int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return false;
+
+	//	header, padding and cells in one go
+	struct iovec parts[3] = {
+		{&header, sizeof(header)},
+		{page, CHECKPOINT_HEADER_SIZE - sizeof(header)},
+		{(void*) cells, header.cellsSize}
+	};
+	bool written = writeAll(fd, parts, 3) && fsync(fd) == 0;
+
+	int error = errno;
+	if (close(fd) != 0 && written)
+	{
+		error = errno;
+		written = false;
+	}
+	if (written && rename(tmpPath, path) != 0)
+	{
+		error = errno;
+		written = false;
+	}
+	if (!written)
+	{
+		unlink(tmpPath);
+		errno = error;
+	}
+	return written;
+}
+
+
+int openCheckpoint(const char* path, CheckpointHeader* header)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	off_t fileSize = lseek(fd, 0, SEEK_END);
+	bool valid = pread(fd, header, sizeof(*header), 0) == (ssize_t) sizeof(*header) &&
+				 memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) == 0 &&
+				 header->byteOrder == BYTE_ORDER_MARK &&
+				 header->version == CHECKPOINT_VERSION &&
+				 header->headerSize == CHECKPOINT_HEADER_SIZE &&
+				 header->frame <= FRAME_WRAP &&
+				 header->cellsSize == (uint64_t) header->numRows * header->numCols &&
+				 fileSize >= (off_t) (header->headerSize + header->cellsSize);
+	if (!valid)
+	{
+		close(fd);
+		errno = EINVAL;
+		return -1;
+	}
+	return fd;
+}
+
+
+//	8 cells at a time: a state is below NUM_CELL_STATES (6) iff its 5 high
+//	bits are clear, and its bits 1 and 2 are not both set
+bool validCheckpointCells(const uint8_t* cells, uint64_t size)
+{
+	const uint64_t HIGH_BITS = 0xf8f8f8f8f8f8f8f8ull, LOW_BITS = 0x0101010101010101ull;
+	static_assert(NUM_CELL_STATES == 6, "validCheckpointCells() expects states 0 to 5");
+
+	uint64_t invalid = 0, k = 0;
+	for (; k + 8 <= size; k += 8)
+	{
+		uint64_t word;
+		memcpy(&word, cells + k, 8);
+		invalid |= (word & HIGH_BITS) | (word >> 1 & word >> 2 & LOW_BITS);
+	}
+	for (; k < size; k++)
+		invalid |= cells[k] >= NUM_CELL_STATES;
+	return invalid == 0;
+}
+
+
+//	writev() until everything is written (a single call may stop short,
+//	at 2 GB on Linux)
+static bool writeAll(int fd, struct iovec* parts, int numParts)
+{
+	while (numParts > 0)
+	{
+		ssize_t written = writev(fd, parts, numParts);
+		if (written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+
+		while (numParts > 0 && (size_t) written >= parts->iov_len)
+		{
+			written -= parts->iov_len;
+			parts++;
+			numParts--;
+		}
+		if (numParts > 0)
+		{
+			parts->iov_base = (uint8_t*) parts->iov_base + written;
+			parts->iov_len -= written;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,67 @@
+//
+//  checkpoint.h
+//  Cellular Automaton
+//
+//	Checkpoint files: the complete state of a board, to stop a simulation
+//	and pick it up later.  A checkpoint is a header of CHECKPOINT_HEADER_SIZE
+//	bytes (a CheckpointHeader, then zeros), followed by the cells, row by row,
+//	one byte per cell (which holds the age of a live cell in color mode).
+//	Numbers are stored in the byte order of the machine that wrote the file.
+//
+//	Since the cells start on a page boundary, a board is loaded by mapping
+//	them straight into the engine's grid (see GridBuffer::mapFile()), with
+//	no parsing and no copy into a buffer of our own.  The cells are still
+//	read once, in full, before the board is used: the engine indexes its
+//	tables with them, so a file that holds an invalid state is refused (see
+//	validCheckpointCells()).  Loading thus takes time in proportion to the
+//	size of the board (a sequential pass at memory or disk speed, which
+//	pages the whole file in), and an engine with a memory budget copies the
+//	cells into its backing file as well.  A checkpoint is written with a
+//	single sequential write.
+//
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+//
+#include "cellEngine.h"
+
+//	Version of the format written, and the only one read
+const uint32_t CHECKPOINT_VERSION = 1;
+
+//	Offset of the cells in the file (a multiple of any page size in use)
+const uint32_t CHECKPOINT_HEADER_SIZE = 65536;
+
+typedef struct CheckpointHeader {
+	char magic[8];					//	"CELLCKPT"
+	uint32_t byteOrder;				//	0x01020304, as written
+	uint32_t version;				//	CHECKPOINT_VERSION
+	uint32_t headerSize;			//	CHECKPOINT_HEADER_SIZE
+	uint32_t numRows, numCols;
+	uint32_t rule;
+	uint32_t frame;					//	a FrameBehavior
+	uint32_t colorMode;				//	0 or 1
+	uint64_t generation;
+	uint64_t seed;					//	last seed passed to randomize()
+	uint64_t cellsSize;				//	numRows * numCols
+} CheckpointHeader;
+
+//	Writes header (whose magic, byteOrder, version, headerSize and cellsSize
+//	fields are filled in here) and cells to a temporary file next to path,
+//	renamed to path once complete, so that path always holds a complete
+//	checkpoint.  Returns false, with errno set, on failure.  Allocates no
+//	memory, so that a child forked by a multithreaded process can call it
+//	(see BackgroundSaver).
+bool writeCheckpoint(const char* path, CheckpointHeader header, const uint8_t* cells);
+
+//	Opens a checkpoint and reads its header.  Returns an open file
+//	descriptor, positioned nowhere in particular, or -1 with errno set
+//	(EINVAL if the file is not a checkpoint this version can read).
+int openCheckpoint(const char* path, CheckpointHeader* header);
+
+//	True if all the cells hold a valid state (below NUM_CELL_STATES): the
+//	engine indexes its tables with them
+bool validCheckpointCells(const uint8_t* cells, uint64_t size);
+
+#endif	//	CHECKPOINT_H
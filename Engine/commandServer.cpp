@@ -0,0 +1,306 @@
+//
+//  commandServer.cpp
+//  Cellular Automaton
+//
+
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+//
+#include "commandServer.h"
+
+//	Number of connections the kernel queues before we accept them
+const int LISTEN_BACKLOG = 16;
+
+//	Longest command line, and most replies a client may leave unread, in
+//	bytes, before it gets disconnected
+const size_t MAX_LINE_LENGTH = 64 * 1024;
+const size_t MAX_UNSENT_BYTES = 1 << 20;
+
+//	A connected client: what it sent that is not a full line yet, the
+//	replies not sent yet, and the number of its commands still to reply to.
+//	A client that closed its end is only dropped once it has all its
+//	replies.
+typedef struct Client {
+	int fd;
+	std::string input, output;
+	unsigned long numPending;
+	bool closing;
+} Client;
+
+static bool sendOutput(Client* client);
+
+
+CommandServer::~CommandServer(void)
+{
+	stop();
+}
+
+
+bool CommandServer::start(const char* path, Handler handler)
+{
+	stop();
+
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(address.sun_path))
+	{
+		errno = ENAMETOOLONG;
+		return false;
+	}
+	strcpy(address.sun_path, path);
+
+	//	Only a socket (left by an earlier run) is replaced: anything else at
+	//	path is more likely a mistyped path than ours to delete
+	struct stat status;
+	if (lstat(path, &status) == 0)
+	{
+		if (!S_ISSOCK(status.st_mode))
+		{
+			errno = EEXIST;
+			return false;
+		}
+		unlink(path);
+	}
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return false;
+
+	if (bind(fd, (struct sockaddr*) &address, sizeof(address)) < 0 || listen(fd, LISTEN_BACKLOG) < 0 ||
+		pipe2(wakeFds_, O_CLOEXEC | O_NONBLOCK) < 0)
+	{
+		int error = errno;
+		close(fd);
+		errno = error;
+		return false;
+	}
+
+	listenFd_ = fd;
+	path_ = path;
+	handler_ = std::move(handler);
+	thread_ = std::jthread([this](std::stop_token stop) {
+		serve(stop);
+	});
+	runner_ = std::jthread([this](std::stop_token stop) {
+		runCommands(stop);
+	});
+	return true;
+}
+
+
+void CommandServer::stop(void)
+{
+	if (!thread_.joinable())
+		return;
+
+	//	The command in progress gets to finish, and its reply to be sent
+	runner_.request_stop();
+	runner_.join();
+	thread_.request_stop();
+	wake();
+	thread_.join();
+
+	commands_.clear();
+	replies_.clear();
+	close(listenFd_);
+	close(wakeFds_[0]);
+	close(wakeFds_[1]);
+	listenFd_ = wakeFds_[0] = wakeFds_[1] = -1;
+	unlink(path_.c_str());
+}
+
+
+bool CommandServer::isRunning(void) const
+{
+	return thread_.joinable();
+}
+
+
+void CommandServer::serve(std::stop_token stop)
+{
+	std::map<unsigned long, Client> clients;
+	unsigned long nextClient = 1;
+	std::vector<struct pollfd> polled;
+	std::vector<unsigned long> polledClients;
+
+	while (true)
+	{
+		//	Replies to the clients still there
+		{
+			std::lock_guard<std::mutex> lock(queueLock_);
+			for (const Message& reply : replies_)
+			{
+				auto found = clients.find(reply.client);
+				if (found == clients.end())
+					continue;
+				found->second.output += reply.line;
+				found->second.output += '\n';
+				found->second.numPending--;
+			}
+			replies_.clear();
+		}
+
+		//	Sends what the clients can take, and drops those that are gone,
+		//	done, or not reading their replies
+		for (auto k = clients.begin(); k != clients.end(); )
+		{
+			Client& client = k->second;
+			bool keep = sendOutput(&client) && !(client.closing && client.numPending == 0 && client.output.empty());
+			if (keep)
+				k++;
+			else
+			{
+				close(client.fd);
+				k = clients.erase(k);
+			}
+		}
+		if (stop.stop_requested())
+			break;
+
+		//	the wake-up pipe, the listening socket, then one entry per client
+		//	(not polled once it closed its end, unless replies remain)
+		polled.clear();
+		polledClients.clear();
+		polled.push_back({wakeFds_[0], POLLIN, 0});
+		polled.push_back({listenFd_, POLLIN, 0});
+		for (const auto& [id, client] : clients)
+		{
+			short events = (client.closing ? 0 : POLLIN) | (client.output.empty() ? 0 : POLLOUT);
+			polled.push_back({events != 0 ? client.fd : -1, events, 0});
+			polledClients.push_back(id);
+		}
+
+		if (poll(polled.data(), polled.size(), -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		if (polled[0].revents != 0)
+		{
+			char buffer[256];
+			while (read(wakeFds_[0], buffer, sizeof(buffer)) > 0)
+				;
+		}
+
+		//	Commands of the clients that sent something (new clients only get
+		//	polled from the next round)
+		for (size_t k = 0; k < polledClients.size(); k++)
+		{
+			if ((polled[k + 2].revents & (POLLIN | POLLHUP | POLLERR)) == 0)
+				continue;
+
+			Client& client = clients[polledClients[k]];
+			char buffer[4096];
+			ssize_t numRead = read(client.fd, buffer, sizeof(buffer));
+			if (numRead == 0)
+				client.closing = true;
+			else if (numRead < 0)
+			{
+				if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+					client.closing = true;
+				continue;
+			}
+			client.input.append(buffer, numRead);
+
+			std::lock_guard<std::mutex> lock(queueLock_);
+			size_t end;
+			while ((end = client.input.find('\n')) != std::string::npos)
+			{
+				std::string command = client.input.substr(0, end);
+				client.input.erase(0, end + 1);
+				if (!command.empty() && command.back() == '\r')
+					command.pop_back();
+				if (command.empty())
+					continue;
+				commands_.push_back({polledClients[k], std::move(command)});
+				client.numPending++;
+				queued_.notify_one();
+			}
+
+			//	(dropped at the next round, once its replies are sent)
+			if (client.input.size() > MAX_LINE_LENGTH)
+			{
+				client.input.clear();
+				client.output += "error line too long\n";
+				client.closing = true;
+			}
+		}
+
+		if (polled[1].revents & POLLIN)
+		{
+			int fd = accept4(listenFd_, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+			if (fd >= 0)
+				clients[nextClient++] = {fd, std::string(), std::string(), 0, false};
+		}
+	}
+
+	for (const auto& [id, client] : clients)
+		close(client.fd);
+}
+
+
+//	Runs the commands, one at a time, and hands their replies to serve()
+void CommandServer::runCommands(std::stop_token stop)
+{
+	while (true)
+	{
+		Message command;
+		{
+			std::unique_lock<std::mutex> lock(queueLock_);
+			if (!queued_.wait(lock, stop, [this] { return !commands_.empty(); }))
+				return;
+			command = std::move(commands_.front());
+			commands_.pop_front();
+		}
+
+		std::string reply = handler_(command.line);
+		{
+			std::lock_guard<std::mutex> lock(queueLock_);
+			replies_.push_back({command.client, std::move(reply)});
+		}
+		wake();
+	}
+}
+
+
+//	Wakes serve() up from poll().  The pipe does not block: if it is full,
+//	serve() has plenty to wake up for already.
+void CommandServer::wake(void)
+{
+	char wake = 0;
+	ssize_t written = write(wakeFds_[1], &wake, 1);
+	(void) written;
+}
+
+
+//	Sends as much of the replies of client as its socket takes without
+//	blocking.  Returns false if the client is gone, or lets its replies
+//	pile up.
+static bool sendOutput(Client* client)
+{
+	size_t sent = 0;
+	while (sent < client->output.size())
+	{
+		ssize_t n = send(client->fd, client->output.data() + sent, client->output.size() - sent,
+						 MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (n <= 0)
+			return false;
+		sent += n;
+	}
+	client->output.erase(0, sent);
+	return client->output.size() <= MAX_UNSENT_BYTES;
+}
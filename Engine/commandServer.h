@@ -0,0 +1,89 @@
+//
+//  commandServer.h
+//  Cellular Automaton
+//
+//	Remote control of a running program.  A CommandServer listens on a Unix
+//	domain socket and, in its own thread, hands each line a client sends
+//	to a handler, and sends the handler's reply back as one line.  The
+//	protocol is plain text, one command per line, so that a shell script
+//	can drive the program:
+//
+//		$ echo "rule 2" | nc -U /tmp/cell.sock
+//		ok
+//
+//	Any number of clients can be connected at the same time.  Commands are
+//	run one at a time, in the order they arrive, by a thread of their own,
+//	while another one reads the commands and sends the replies (it sleeps
+//	in poll() the rest of the time).  A long command (a step of many
+//	generations, the load of a large board) thus delays the commands that
+//	came after it, but never the connections, and no client can hold the
+//	server up: the replies are sent without blocking, and a client that
+//	lets too many of them pile up, or sends too long a line, is
+//	disconnected.
+//
+
+#ifndef COMMAND_SERVER_H
+#define COMMAND_SERVER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+
+class CommandServer
+{
+	public:
+
+		//	Runs one command (a line, without its end of line) and returns
+		//	the reply (one line, without its end of line)
+		using Handler = std::function<std::string(const std::string& command)>;
+
+		CommandServer(void) = default;
+		~CommandServer(void);
+
+		CommandServer(const CommandServer&) = delete;
+		CommandServer& operator =(const CommandServer&) = delete;
+
+		//	Listens on a socket created at path (replacing a socket already
+		//	there).  Returns false, with errno set (EEXIST if something other
+		//	than a socket is at path), if the socket cannot be created.
+		bool start(const char* path, Handler handler);
+
+		//	Disconnects the clients, closes the socket and removes its file.
+		//	Must not be called from the handler.
+		void stop(void);
+
+		bool isRunning(void) const;
+
+	private:
+
+		//	A command, or its reply, and the client it is from
+		typedef struct Message {
+			unsigned long client;
+			std::string line;
+		} Message;
+
+		void serve(std::stop_token stop);
+		void runCommands(std::stop_token stop);
+		void wake(void);
+
+		Handler handler_;
+		std::string path_;
+		int listenFd_ = -1;
+		//	written to by stop() and for each reply, to wake up the thread
+		//	from poll()
+		int wakeFds_[2] = {-1, -1};
+
+		//	guards the queues
+		std::mutex queueLock_;
+		std::condition_variable_any queued_;
+		std::deque<Message> commands_, replies_;
+
+		std::jthread thread_;
+		std::jthread runner_;
+};
+
+#endif	//	COMMAND_SERVER_H
@@ -0,0 +1,298 @@
+//
+//  engineCommands.cpp
+//  Cellular Automaton
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+//
+#include "engineCommands.h"
+
+static const char* COMMAND_NAMES[] = {
+	"rule", "color", "border", "faster", "slower", "rate", "unthrottled", "threads",
+	"strategy", "reset", "clear", "run", "pause", "step", "save", "load", "place", "export",
+	"bgsave", "autosave", "checkpoints", "record", "replay", "recording", "rewind", "back", "forward",
+	"history", "query"
+};
+
+static const char* BORDER_NAMES[] = {
+	"dead",			//	FRAME_DEAD
+	"random",		//	FRAME_RANDOM
+	"clipped",		//	FRAME_CLIPPED
+	"wrap"			//	FRAME_WRAP
+};
+
+static bool fail(std::string* reply, const char* reason);
+static bool parseCount(const char* text, unsigned long* count);
+static bool parseRate(const char* text, double* rate);
+static bool parseOffset(const char* text, long* offset);
+
+
+bool runEngineCommand(CellEngine* engine, const char* command, std::string* reply)
+{
+	char name[32], arg[256], arg2[256], arg3[32], extra;
+	int numWords = sscanf(command, "%31s %255s %255s %31s %c", name, arg, arg2, arg3, &extra);
+	if (numWords < 1)
+		return false;
+
+	bool known = false;
+	for (const char* commandName : COMMAND_NAMES)
+		known = known || strcmp(name, commandName) == 0;
+	if (!known)
+		return false;
+	int maxWords = strcmp(name, "place") == 0 ? 4 :
+				   strcmp(name, "autosave") == 0 || strcmp(name, "record") == 0 || strcmp(name, "replay") == 0 ||
+				   strcmp(name, "rewind") == 0 ? 3 : 2;
+	if (numWords > maxWords)
+		return fail(reply, "too many arguments");
+	bool hasArg = numWords >= 2;
+
+	Pacer& pacer = engine->pacer();
+	unsigned long count;
+	double rate;
+
+	if (strcmp(name, "rule") == 0)
+	{
+		if (!hasArg || !parseCount(arg, &count) || count > MAZE_RULE || !engine->setRule(count))
+			return fail(reply, "the rule must be 1, 2, 3, or 4");
+	}
+	else if (strcmp(name, "color") == 0)
+	{
+		if (!hasArg || (strcmp(arg, "on") != 0 && strcmp(arg, "off") != 0))
+			return fail(reply, "color takes on or off");
+		engine->setColorMode(strcmp(arg, "on") == 0);
+	}
+	else if (strcmp(name, "border") == 0)
+	{
+		unsigned int k = 0;
+		while (k < 4 && !(hasArg && strcmp(arg, BORDER_NAMES[k]) == 0))
+			k++;
+		if (k == 4)
+			return fail(reply, "the border must be dead, random, clipped, or wrap");
+		engine->setFrameBehavior((FrameBehavior) k);
+	}
+	//	Same steps as the keyboard (no effect while unthrottled)
+	else if (strcmp(name, "faster") == 0 || strcmp(name, "slower") == 0)
+	{
+		if (!pacer.isUnthrottled())
+			pacer.setRate((strcmp(name, "faster") == 0 ? 11 : 9) * pacer.rate() / 10);
+	}
+	else if (strcmp(name, "rate") == 0)
+	{
+		if (!hasArg || !parseRate(arg, &rate))
+			return fail(reply, "the rate must be a number of generations per second (0: unthrottled)");
+		pacer.setRate(rate);
+	}
+	else if (strcmp(name, "unthrottled") == 0)
+	{
+		pacer.toggleUnthrottled();
+	}
+	else if (strcmp(name, "threads") == 0)
+	{
+		unsigned int numThreads = engine->numThreads();
+		if (hasArg && strcmp(arg, "+") == 0)
+			engine->setNumThreads(numThreads + 1);
+		else if (hasArg && strcmp(arg, "-") == 0)
+			engine->setNumThreads(numThreads > 1 ? numThreads - 1 : 1);
+		else if (hasArg && parseCount(arg, &count) && count > 0 && count <= MAX_NUM_THREADS)
+			engine->setNumThreads(count);
+		else
+			return fail(reply, "threads takes a number of threads, + or -");
+	}
+	else if (strcmp(name, "strategy") == 0)
+	{
+		ExecutionStrategy strategy;
+		if (hasArg && strcmp(arg, "next") == 0)
+			strategy = (ExecutionStrategy) ((engine->strategy() + 1) % NUM_STRATEGIES);
+		else if (!hasArg || !parseStrategy(arg, &strategy))
+			return fail(reply, "the strategy must be serial, banded, wavefront, async, or next");
+		engine->setStrategy(strategy);
+	}
+	else if (strcmp(name, "reset") == 0)
+	{
+		if (hasArg && !parseCount(arg, &count))
+			return fail(reply, "the seed must be a number");
+		engine->randomize(hasArg ? (unsigned int) count
+								 : (unsigned int) time(NULL) + (unsigned int) engine->generation());
+	}
+	else if (strcmp(name, "clear") == 0)
+	{
+		engine->clear();
+	}
+	else if (strcmp(name, "run") == 0)
+	{
+		engine->run();
+	}
+	else if (strcmp(name, "pause") == 0)
+	{
+		engine->pause();
+	}
+	else if (strcmp(name, "step") == 0)
+	{
+		if (hasArg && (!parseCount(arg, &count) || count == 0))
+			return fail(reply, "the number of generations must be positive");
+		engine->step(hasArg ? count : 1);
+	}
+	else if (strcmp(name, "save") == 0 || strcmp(name, "load") == 0)
+	{
+		if (!hasArg)
+			return fail(reply, "missing checkpoint path");
+		bool done = strcmp(name, "save") == 0 ? engine->saveCheckpoint(arg) : engine->loadCheckpoint(arg);
+		if (!done)
+			return fail(reply, strerror(errno));
+	}
+	else if (strcmp(name, "place") == 0)
+	{
+		Pattern pattern;
+		long row, col;
+		if (numWords == 3 || (numWords == 4 && (!parseOffset(arg2, &row) || !parseOffset(arg3, &col))))
+			return fail(reply, "place takes a pattern file, and an optional row and column");
+		if (!hasArg || !pattern.read(arg))
+			return fail(reply, hasArg ? strerror(errno) : "missing pattern path");
+		if (numWords == 2)
+		{
+			row = ((long) engine->numRows() - (long) std::min<uint64_t>(pattern.numRows(), LONG_MAX / 2)) / 2;
+			col = ((long) engine->numCols() - (long) std::min<uint64_t>(pattern.numCols(), LONG_MAX / 2)) / 2;
+		}
+		engine->placePattern(pattern, row, col);
+	}
+	else if (strcmp(name, "export") == 0)
+	{
+		if (!hasArg)
+			return fail(reply, "missing pattern path");
+		if (!engine->savePattern(arg, patternFormat(arg)))
+			return fail(reply, strerror(errno));
+	}
+	else if (strcmp(name, "bgsave") == 0)
+	{
+		if (!hasArg)
+			return fail(reply, "missing checkpoint path");
+		if (!engine->saveCheckpointInBackground(arg))
+			return fail(reply, strerror(errno));
+	}
+	else if (strcmp(name, "autosave") == 0)
+	{
+		if (!hasArg || !parseCount(arg, &count))
+			return fail(reply, "autosave takes a number of generations, and an optional directory");
+		BackgroundSaver& saver = engine->backgroundSaver();
+		saver.setSchedule(numWords == 3 ? arg2 : saver.directory().c_str(), count);
+	}
+	else if (strcmp(name, "record") == 0)
+	{
+		if (!hasArg || (numWords == 3 && (!parseCount(arg2, &count) || count == 0)))
+			return fail(reply, "record takes a recording path (or off), and an optional keyframe interval");
+		bool done = strcmp(arg, "off") == 0 ? engine->stopRecording()
+											: engine->startRecording(arg, numWords == 3 ? count : DEFAULT_KEYFRAME_INTERVAL);
+		if (!done)
+			return fail(reply, strerror(errno));
+	}
+	else if (strcmp(name, "replay") == 0)
+	{
+		if (numWords != 3 || !parseCount(arg2, &count))
+			return fail(reply, "replay takes a recording path and a generation");
+		if (!engine->loadRecordedGeneration(arg, count))
+			return fail(reply, strerror(errno));
+	}
+	else if (strcmp(name, "rewind") == 0)
+	{
+		unsigned long megabytes = DEFAULT_REWIND_BYTES >> 20;
+		if (!hasArg || !parseCount(arg, &count) || (numWords == 3 && (!parseCount(arg2, &megabytes) ||
+																	  megabytes == 0 || megabytes > SIZE_MAX >> 20)))
+			return fail(reply, "rewind takes a number of generations, and an optional number of MB");
+		engine->setRewindDepth(count, (size_t) megabytes << 20);
+	}
+	else if (strcmp(name, "back") == 0 || strcmp(name, "forward") == 0)
+	{
+		if (hasArg && (!parseCount(arg, &count) || count == 0))
+			return fail(reply, "the number of generations must be positive");
+		bool done = strcmp(name, "back") == 0 ? engine->stepBack(hasArg ? count : 1)
+											  : engine->stepForward(hasArg ? count : 1);
+		if (!done)
+			return fail(reply, "no generation kept to go to");
+	}
+
+	//	query, and the generation reached by the other commands
+	char values[256];
+	if (strcmp(name, "query") == 0)
+		snprintf(values, sizeof(values),
+				 "ok generation %lu running %d strategy %s threads %u rule %u color %s border %s rate %.1f board %ux%u",
+				 engine->generation(), engine->isRunning() ? 1 : 0, strategyName(engine->strategy()),
+				 engine->numThreads(), engine->rule(), engine->colorMode() ? "on" : "off",
+				 BORDER_NAMES[engine->frameBehavior()], pacer.rate(), engine->numCols(), engine->numRows());
+	else if (strcmp(name, "checkpoints") == 0)
+	{
+		BackgroundSaverStats stats;
+		engine->backgroundSaver().stats(&stats);
+		snprintf(values, sizeof(values),
+				 "ok saved %lu failed %lu skipped %lu writing %d generation %lu pause %.3f max %.3f mean %.3f",
+				 stats.numSaved, stats.numFailed, stats.numSkipped, stats.writing ? 1 : 0, stats.lastGeneration,
+				 1000. * stats.lastPause, 1000. * stats.maxPause,
+				 stats.numStarted > 0 ? 1000. * stats.totalPause / stats.numStarted : 0.);
+	}
+	else if (strcmp(name, "recording") == 0)
+	{
+		RecorderStats stats;
+		engine->recorder().stats(&stats);
+		snprintf(values, sizeof(values),
+				 "ok recording %d generations %lu keyframes %lu last %lu bytes %llu raw %llu encode %.3f stall %.3f error %d",
+				 stats.recording ? 1 : 0, stats.numRecords, stats.numKeyframes, stats.lastGeneration,
+				 (unsigned long long) stats.fileBytes, (unsigned long long) stats.rawBytes, stats.encodeTime,
+				 stats.stallTime, stats.lastError);
+	}
+	else if (strcmp(name, "history") == 0)
+	{
+		RewindStats stats;
+		engine->rewindBuffer().stats(&stats);
+		snprintf(values, sizeof(values),
+				 "ok generations %lu first %lu last %lu keyframes %lu bytes %zu max %lu maxbytes %zu",
+				 stats.numGenerations, stats.firstGeneration, stats.lastGeneration, stats.numKeyframes,
+				 stats.bytes, stats.maxGenerations, stats.maxBytes);
+	}
+	else if (strcmp(name, "step") == 0 || strcmp(name, "load") == 0 || strcmp(name, "replay") == 0 ||
+			 strcmp(name, "back") == 0 || strcmp(name, "forward") == 0)
+		snprintf(values, sizeof(values), "ok generation %lu", engine->generation());
+	else
+		snprintf(values, sizeof(values), "ok");
+	*reply = values;
+	return true;
+}
+
+
+//	Sets reply to an error.  Returns true: the command was ours.
+static bool fail(std::string* reply, const char* reason)
+{
+	*reply = std::string("error ") + reason;
+	return true;
+}
+
+
+static bool parseCount(const char* text, unsigned long* count)
+{
+	char* end;
+	errno = 0;
+	*count = strtoul(text, &end, 10);
+	return end != text && *end == '\0' && text[0] != '-' && errno == 0;
+}
+
+
+static bool parseRate(const char* text, double* rate)
+{
+	char* end;
+	*rate = strtod(text, &end);
+	return end != text && *end == '\0' && *rate >= 0.;
+}
+
+
+static bool parseOffset(const char* text, long* offset)
+{
+	char* end;
+	errno = 0;
+	*offset = strtol(text, &end, 10);
+	return end != text && *end == '\0' && errno == 0;
+}
@@ -0,0 +1,60 @@
+//
+//  engineCommands.h
+//  Cellular Automaton
+//
+//	Text commands that control a CellEngine, as sent by scripts through a
+//	CommandServer.  Each command gets a one-line reply: "ok", followed by
+//	values for a query, or "error <reason>".
+//
+//		rule <1-4>					rule of the automaton
+//		color on|off				color mode
+//		border dead|random|clipped|wrap
+//		faster / slower				target rate +/- 10%
+//		rate <generations/s>		target rate (0: unthrottled)
+//		unthrottled					toggles unthrottled on/off
+//		threads <n> | + | -			number of compute threads
+//		strategy <name> | next		execution strategy
+//		reset [<seed>]				random board
+//		clear						empty board
+//		run / pause
+//		step [<generations>]		pauses, then computes that many (1)
+//		save <path>					writes a checkpoint of the board
+//		load <path>					loads a checkpoint of a board of the same size
+//		place <path> [<row> <col>]	places an RLE or Macrocell pattern, its top
+//									left corner at that cell (default: centered)
+//		export <path>				writes the live part of the board as a
+//									pattern (Macrocell for .mc, RLE otherwise)
+//		bgsave <path>				writes a checkpoint from a child process
+//		autosave <generations> [<directory>]
+//									a background checkpoint every that many
+//									generations (0: none)
+//		checkpoints					ok saved <n> failed <n> skipped <n> ...
+//									(background checkpoints, and the pauses
+//									of the compute threads, in ms)
+//		record <path> [<keyframes>]	records every generation, with a keyframe
+//									every that many (default 256)
+//		record off					closes the recording
+//		replay <path> <generation>	loads a generation of a recording
+//		recording					ok recording <0|1> generations <n> ...
+//		rewind <generations> [<MB>]	keeps that many of the last generations in
+//									memory (0: none), in at most that many MB
+//									(default 256)
+//		back [<generations>]		pauses, and takes the board that many
+//									generations back (1) among those kept
+//		forward [<generations>]		same, forward again (run resumes from there)
+//		history						ok generations <n> first <g> last <g> ...
+//		query						ok generation <g> running <0|1> ...
+//
+
+#ifndef ENGINE_COMMANDS_H
+#define ENGINE_COMMANDS_H
+
+#include <string>
+//
+#include "cellEngine.h"
+
+//	Returns false (and leaves reply alone) if command is not an engine
+//	command, so that the caller can try its own commands.
+bool runEngineCommand(CellEngine* engine, const char* command, std::string* reply);
+
+#endif	//	ENGINE_COMMANDS_H
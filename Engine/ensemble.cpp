@@ -0,0 +1,176 @@
+//
+//  ensemble.cpp
+//  Cellular Automaton
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+//
+#include "ensemble.h"
+#include "headless.h"
+#include "workerPool.h"
+
+static const char* ENDING_NAMES[] = {
+	"extinct",		//	ENDING_EXTINCT
+	"cycle",		//	ENDING_CYCLE
+	"limit"			//	ENDING_LIMIT
+};
+
+static void runBoard(CellEngine* engine, unsigned long maxGenerations, BoardStats* stats, std::stop_token stop);
+static uint64_t boardDigest(const uint8_t* cells, size_t numCells, unsigned long* population);
+
+
+double runEnsemble(const EnsembleOptions& options, unsigned int numThreads, std::vector<BoardStats>* stats)
+{
+	size_t numBoards = options.rules.size() * options.densities.size() * options.numSeeds;
+	stats->assign(numBoards, BoardStats{});
+	for (size_t k = 0; k < numBoards; k++)
+	{
+		BoardStats& board = (*stats)[k];
+		board.seed = options.firstSeed + (unsigned int) (k % options.numSeeds);
+		board.density = options.densities[(k / options.numSeeds) % options.densities.size()];
+		board.rule = options.rules[k / options.numSeeds / options.densities.size()];
+	}
+	if (numBoards == 0)
+		return 0.;
+
+	double startTime = headlessClock();
+
+	//	Each thread sets up its engine once, then takes boards until there
+	//	are none left
+	std::atomic<size_t> nextBoard(0);
+	WorkerPool pool;
+	pool.start((unsigned int) std::clamp<size_t>(numThreads, 1, std::min<size_t>(numBoards, MAX_NUM_THREADS)),
+			   [&](unsigned int index, unsigned int count, std::stop_token stop) {
+				   (void) index;
+				   (void) count;
+				   CellEngine engine(options.numCols, options.numRows);
+				   engine.setFrameBehavior(options.frame);
+				   engine.setColorMode(options.colorMode);
+				   for (size_t k = nextBoard++; k < numBoards && !stop.stop_requested(); k = nextBoard++)
+					   runBoard(&engine, options.maxGenerations, &(*stats)[k], stop);
+			   },
+			   [](bool completed) {
+				   (void) completed;
+				   return false;
+			   });
+	pool.wait();
+
+	return headlessClock() - startTime;
+}
+
+
+void writeEnsembleCsv(FILE* out, const std::vector<BoardStats>& stats)
+{
+	fprintf(out, "rule,density,seed,generations,ending,period,"
+				 "initial_population,final_population,min_population,max_population\n");
+	for (const BoardStats& board : stats)
+		fprintf(out, "%u,%g,%u,%lu,%s,%u,%lu,%lu,%lu,%lu\n",
+				board.rule, board.density, board.seed, board.generations, ENDING_NAMES[board.ending],
+				board.period, board.initialPopulation, board.finalPopulation,
+				board.minPopulation, board.maxPopulation);
+}
+
+
+void printEnsembleReport(const EnsembleOptions& options, unsigned int numThreads,
+						 const std::vector<BoardStats>& stats, double wallSeconds)
+{
+	unsigned long generations = 0, numEndings[3] = {0, 0, 0};
+	for (const BoardStats& board : stats)
+	{
+		generations += board.generations;
+		numEndings[board.ending]++;
+	}
+	double cells = (double) options.numCols * options.numRows;
+
+	printf("boards:         %zu of %u x %u\n", stats.size(), options.numCols, options.numRows);
+	printf("endings:        %lu extinct, %lu cycle, %lu limit\n", numEndings[ENDING_EXTINCT],
+		   numEndings[ENDING_CYCLE], numEndings[ENDING_LIMIT]);
+	printf("threads:        %u\n", numThreads);
+	printf("generations:    %lu\n", generations);
+	printf("wall time:      %.3f s\n", wallSeconds);
+	printf("generations/s:  %.4g (boards x generations)\n", generations / wallSeconds);
+	printf("cells/s:        %.4g\n", generations * cells / wallSeconds);
+}
+
+
+//	Runs the board of stats until it dies out, repeats itself, or reaches
+//	maxGenerations.  Each generation is compared with the previous
+//	MAX_DETECTED_PERIOD ones through a digest of the board.
+static void runBoard(CellEngine* engine, unsigned long maxGenerations, BoardStats* stats, std::stop_token stop)
+{
+	size_t numCells = (size_t) engine->numRows() * engine->numCols();
+	engine->setRule(stats->rule);
+	engine->randomize(stats->seed, stats->density);
+
+	//	digest of generation g in history[g % MAX_DETECTED_PERIOD]
+	uint64_t history[MAX_DETECTED_PERIOD];
+	unsigned long population;
+	history[0] = boardDigest(engine->cells(), numCells, &population);
+	stats->initialPopulation = stats->minPopulation = stats->maxPopulation = population;
+	stats->ending = ENDING_LIMIT;
+	stats->period = 0;
+
+	unsigned long g = 0;
+	while (population != 0 && stats->period == 0 && g < maxGenerations)
+	{
+		//	The whole board as a single band, in this thread
+		engine->beginHostedGeneration();
+		engine->computeHostedBand(0, 1, stop);
+		engine->endHostedGeneration(!stop.stop_requested());
+		if (stop.stop_requested())
+			break;
+		g++;
+
+		uint64_t digest = boardDigest(engine->cells(), numCells, &population);
+		stats->minPopulation = std::min(stats->minPopulation, population);
+		stats->maxPopulation = std::max(stats->maxPopulation, population);
+		for (unsigned int p = 1; p <= std::min<unsigned long>(g, MAX_DETECTED_PERIOD); p++)
+			if (history[(g - p) % MAX_DETECTED_PERIOD] == digest)
+			{
+				stats->period = p;
+				break;
+			}
+		history[g % MAX_DETECTED_PERIOD] = digest;
+	}
+
+	stats->generations = g;
+	stats->finalPopulation = population;
+	if (population == 0)
+	{
+		stats->ending = ENDING_EXTINCT;
+		stats->period = 0;
+	}
+	else if (stats->period != 0)
+		stats->ending = ENDING_CYCLE;
+}
+
+
+//	64-bit digest of the board, and its number of live cells, in one pass
+//	over 8 cells at a time.  Cell states are below 8, so a byte is non-zero
+//	iff one of its 3 low bits is set.
+static uint64_t boardDigest(const uint8_t* cells, size_t numCells, unsigned long* population)
+{
+	const uint64_t LOW_BITS = 0x0101010101010101ull;
+	uint64_t digest = 0xcbf29ce484222325ull;
+	unsigned long count = 0;
+
+	size_t k = 0;
+	for (; k + 8 <= numCells; k += 8)
+	{
+		uint64_t word;
+		memcpy(&word, cells + k, 8);
+		count += __builtin_popcountll((word | word >> 1 | word >> 2) & LOW_BITS);
+		digest = (digest ^ word) * 0x100000001b3ull;
+		digest ^= digest >> 29;
+	}
+	for (; k < numCells; k++)
+	{
+		count += cells[k] != 0;
+		digest = (digest ^ cells[k]) * 0x100000001b3ull;
+	}
+
+	*population = count;
+	return digest;
+}
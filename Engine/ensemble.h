@@ -0,0 +1,68 @@
+//
+//  ensemble.h
+//  Cellular Automaton
+//
+//	Parameter sweeps: many small boards, one for each combination of a
+//	rule, an initial density and a seed, all run in one process until they
+//	die out, settle into a cycle, or reach a number of generations.
+//
+//	The boards are independent, so rather than cutting each one into bands
+//	(and meeting at a barrier at each generation), each thread of a
+//	WorkerPool takes whole boards in turn and runs them to the end, on an
+//	engine of its own that is reused from one board to the next.  A small
+//	board then stays in the cache of its thread for its whole run.
+//
+
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <cstdio>
+#include <vector>
+//
+#include "cellEngine.h"
+
+//	Longest cycle that ends a run (1: still life)
+const unsigned int MAX_DETECTED_PERIOD = 16;
+
+typedef struct EnsembleOptions {
+	unsigned int numCols, numRows;
+	FrameBehavior frame;
+	bool colorMode;
+	//	one board per rule x density x seed, seeds firstSeed to firstSeed+numSeeds-1
+	std::vector<unsigned int> rules;
+	std::vector<double> densities;
+	unsigned int firstSeed, numSeeds;
+	unsigned long maxGenerations;
+} EnsembleOptions;
+
+//	How the run of a board ended
+typedef enum EnsembleEnding {
+	ENDING_EXTINCT = 0,		//	no live cell left
+	ENDING_CYCLE,			//	the board repeats itself (period 1: still life)
+	ENDING_LIMIT			//	maxGenerations reached
+} EnsembleEnding;
+
+typedef struct BoardStats {
+	unsigned int rule;
+	double density;
+	unsigned int seed;
+	unsigned long generations;		//	computed before the run ended
+	EnsembleEnding ending;
+	unsigned int period;			//	for ENDING_CYCLE
+	unsigned long initialPopulation, finalPopulation;
+	unsigned long minPopulation, maxPopulation;
+} BoardStats;
+
+//	Runs all the boards of the sweep on numThreads threads.  stats receives
+//	one entry per board, ordered by rule, then density, then seed.  Returns
+//	the wall-clock time of the run, in seconds.
+double runEnsemble(const EnsembleOptions& options, unsigned int numThreads, std::vector<BoardStats>* stats);
+
+//	One line per board, after a header line
+void writeEnsembleCsv(FILE* out, const std::vector<BoardStats>& stats);
+
+//	Prints the throughput of a run on stdout
+void printEnsembleReport(const EnsembleOptions& options, unsigned int numThreads,
+						 const std::vector<BoardStats>& stats, double wallSeconds);
+
+#endif	//	ENSEMBLE_H
@@ -0,0 +1,151 @@
+//
+//  gridBuffer.cpp
+//  Cellular Automaton
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <new>
+#include <string>
+#include <utility>
+#include <sys/mman.h>
+#include <unistd.h>
+//
+#include "gridBuffer.h"
+
+
+GridBuffer::~GridBuffer(void)
+{
+	release();
+}
+
+
+void GridBuffer::allocate(size_t size)
+{
+	//	(no swap is set aside for pages that may never be written)
+	void* data = size == 0 ? nullptr : mmap(nullptr, size, PROT_READ | PROT_WRITE,
+											MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (data == MAP_FAILED)
+		throw std::bad_alloc();
+
+	release();
+	data_ = (uint8_t*) data;
+	size_ = size;
+}
+
+
+bool GridBuffer::mapFile(int fd, off_t offset, size_t size)
+{
+	void* data = size == 0 ? nullptr : mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, offset);
+	if (data == MAP_FAILED)
+		return false;
+
+	//	Start reading the file in now, rather than a page at a time at the
+	//	first generation
+	if (size != 0)
+		madvise(data, size, MADV_WILLNEED);
+
+	release();
+	data_ = (uint8_t*) data;
+	size_ = size;
+	return true;
+}
+
+
+bool GridBuffer::createBackingFile(const char* directory, size_t size)
+{
+	std::string path = std::string(directory) + "/cellgrid-XXXXXX";
+	int fd = mkstemp(path.data());
+	if (fd < 0)
+		return false;
+	unlink(path.c_str());
+
+	void* data = MAP_FAILED;
+	if (ftruncate(fd, (off_t) size) == 0)
+		data = size == 0 ? nullptr : mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED)
+	{
+		int error = errno;
+		close(fd);
+		errno = error;
+		return false;
+	}
+
+	release();
+	data_ = (uint8_t*) data;
+	size_ = size;
+	fd_ = fd;
+	return true;
+}
+
+
+void GridBuffer::prefetch(size_t offset, size_t size) const
+{
+	if (fd_ < 0 || offset >= size_)
+		return;
+
+	//	whole pages around the bytes
+	size_t page = (size_t) sysconf(_SC_PAGESIZE);
+	size_t first = offset / page * page;
+	size_t end = offset + std::min(size, size_ - offset);
+	madvise(data_ + first, end - first, MADV_WILLNEED);
+}
+
+
+void GridBuffer::evict(size_t offset, size_t size, bool written) const
+{
+	if (fd_ < 0 || offset >= size_)
+		return;
+
+	//	whole pages within the bytes: the pages they share with their
+	//	neighbors may still be in use (the end of the buffer is its own)
+	size_t page = (size_t) sysconf(_SC_PAGESIZE);
+	size_t first = (offset + page - 1) / page * page;
+	size_t end = offset + std::min(size, size_ - offset);
+	size_t last = end == size_ ? end : end / page * page;
+	if (last <= first)
+		return;
+
+	//	The pages leave our mappings at once.  Those that were written stay
+	//	in the page cache until they are written out (which starts now); the
+	//	others leave it too.
+#if defined(__linux__)
+	if (written)
+		sync_file_range(fd_, (off_t) first, (off_t) (last - first), SYNC_FILE_RANGE_WRITE);
+	madvise(data_ + first, last - first, MADV_DONTNEED);
+	posix_fadvise(fd_, (off_t) first, (off_t) (last - first), POSIX_FADV_DONTNEED);
+#else
+	if (written)
+		msync(data_ + first, last - first, MS_ASYNC);
+	madvise(data_ + first, last - first, MADV_DONTNEED);
+#endif
+}
+
+
+void GridBuffer::swap(GridBuffer& other)
+{
+	std::swap(data_, other.data_);
+	std::swap(size_, other.size_);
+	std::swap(fd_, other.fd_);
+}
+
+
+void GridBuffer::setInherited(bool inherited)
+{
+	if (data_ != nullptr)
+		madvise(data_, size_, inherited ? MADV_DOFORK : MADV_DONTFORK);
+}
+
+
+void GridBuffer::release(void)
+{
+	if (data_ != nullptr)
+		munmap(data_, size_);
+	if (fd_ >= 0)
+		close(fd_);
+	data_ = nullptr;
+	size_ = 0;
+	fd_ = -1;
+}
@@ -0,0 +1,90 @@
+//
+//  gridBuffer.h
+//  Cellular Automaton
+//
+//	Storage of one grid of a CellEngine: a block of bytes, either
+//	anonymous memory or the mapping of part of a file.  Both come from
+//	mmap(), so that a board can be loaded from a checkpoint by mapping the
+//	file rather than reading it.  A file mapping is copy-on-write: the
+//	cells can be written like any others, but the file never changes.
+//
+//	A grid can also live in a file of its own (a backing file), for boards
+//	larger than the memory: the pages in memory are then only a cache of
+//	the file, which the kernel can write out and drop at any time.  The
+//	engine goes through such a grid in order, and tells it which bytes it
+//	is about to use (prefetch()) and which ones it is done with (evict()),
+//	so that only a window of the board is in memory at any time.
+//
+
+#ifndef GRID_BUFFER_H
+#define GRID_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+class GridBuffer
+{
+	public:
+
+		GridBuffer(void) = default;
+		~GridBuffer(void);
+
+		GridBuffer(const GridBuffer&) = delete;
+		GridBuffer& operator =(const GridBuffer&) = delete;
+
+		//	size bytes of zeros (pages are only committed when first
+		//	written).  Throws std::bad_alloc if there is no memory left.
+		void allocate(size_t size);
+
+		//	size bytes of the open file fd, from offset (a multiple of the
+		//	page size).  Returns false, with errno set, if the file cannot
+		//	be mapped (the buffer is then left alone).  The file can be
+		//	closed afterwards.
+		bool mapFile(int fd, off_t offset, size_t size);
+
+		//	size bytes of zeros in a backing file, created in directory and
+		//	removed at once, so that it goes away with the buffer (its blocks
+		//	are only allocated when first written).  Returns false, with
+		//	errno set, on failure (the buffer is then left alone).
+		bool createBackingFile(const char* directory, size_t size);
+		bool isFileBacked(void) const { return fd_ >= 0; }
+
+		//	Hints on the bytes [offset, offset+size) of a buffer in a backing
+		//	file (they do nothing for the others).  prefetch() starts reading
+		//	them in.  evict() lets go of their pages, after starting to write
+		//	them out if they were written: their contents are kept in the
+		//	file, and read back in if they are used again.
+		void prefetch(size_t offset, size_t size) const;
+		void evict(size_t offset, size_t size, bool written) const;
+
+		void swap(GridBuffer& other);
+
+		//	Whether a child created by fork() gets a copy of the buffer (it
+		//	does unless told otherwise).  Leaving out a buffer the child has
+		//	no use for spares the parent copy-on-write faults when it writes.
+		void setInherited(bool inherited);
+
+		uint8_t* data(void) { return data_; }
+		const uint8_t* data(void) const { return data_; }
+		size_t size(void) const { return size_; }
+
+		uint8_t* begin(void) { return data_; }
+		uint8_t* end(void) { return data_ + size_; }
+		const uint8_t* begin(void) const { return data_; }
+		const uint8_t* end(void) const { return data_ + size_; }
+
+		uint8_t& operator [](size_t k) { return data_[k]; }
+		uint8_t operator [](size_t k) const { return data_[k]; }
+
+	private:
+
+		void release(void);
+
+		uint8_t* data_ = nullptr;
+		size_t size_ = 0;
+		//	backing file (-1: none)
+		int fd_ = -1;
+};
+
+#endif	//	GRID_BUFFER_H
@@ -0,0 +1,82 @@
+//
+//  headless.cpp
+//  Cellular Automaton
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <time.h>
+//
+#include "headless.h"
+
+const char* HEADLESS_USAGE = "[-g <generations> | -t <seconds>]";
+
+
+bool parseHeadlessOptions(int argc, char** argv, int first, HeadlessOptions* options)
+{
+	options->enabled = false;
+	options->generations = 0;
+	options->seconds = 0.;
+
+	if (argc == first)
+		return true;
+
+	if (argc != first + 2)
+	{
+		std::cerr << "Invalid arguments. Optional headless arguments are " << HEADLESS_USAGE << ".\n";
+		return false;
+	}
+
+	if (strcmp(argv[first], "-g") == 0)
+	{
+		long generations = std::atol(argv[first + 1]);
+		if (generations <= 0)
+		{
+			std::cerr << "Invalid arguments. The number of generations must be positive.\n";
+			return false;
+		}
+		options->generations = (unsigned long) generations;
+	}
+	else if (strcmp(argv[first], "-t") == 0)
+	{
+		double seconds = std::atof(argv[first + 1]);
+		if (seconds <= 0.)
+		{
+			std::cerr << "Invalid arguments. The run time must be positive.\n";
+			return false;
+		}
+		options->seconds = seconds;
+	}
+	else
+	{
+		std::cerr << "Invalid arguments. Optional headless arguments are " << HEADLESS_USAGE << ".\n";
+		return false;
+	}
+
+	options->enabled = true;
+	return true;
+}
+
+
+double headlessClock(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1.e-9 * ts.tv_nsec;
+}
+
+
+void printHeadlessReport(unsigned int numCols, unsigned int numRows, unsigned int numThreads,
+						 double generations, double wallSeconds)
+{
+	double cells = (double) numCols * numRows;
+
+	printf("board:          %u x %u\n", numCols, numRows);
+	printf("threads:        %u\n", numThreads);
+	printf("generations:    %.2f\n", generations);
+	printf("wall time:      %.3f s\n", wallSeconds);
+	printf("generations/s:  %.2f\n", generations / wallSeconds);
+	printf("cells/s:        %.4g\n", generations * cells / wallSeconds);
+}
@@ -0,0 +1,39 @@
+//
+//  headless.h
+//  Cellular Automaton
+//
+//	Support for running a simulation without any window (on machines that
+//	have no X server), unthrottled, and reporting its throughput.  Headless
+//	mode is selected by one optional argument after the usual three:
+//
+//		-g <generations>	run that many generations
+//		-t <seconds>		run for that many seconds
+//
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+typedef struct HeadlessOptions {
+	bool enabled;
+	//	exactly one of the two limits is non-zero
+	unsigned long generations;
+	double seconds;
+} HeadlessOptions;
+
+//	Parses the optional arguments argv[first] to argv[argc-1].  Returns false
+//	(after printing an error message) if they are invalid.
+bool parseHeadlessOptions(int argc, char** argv, int first, HeadlessOptions* options);
+
+//	Usage string for the optional arguments
+extern const char* HEADLESS_USAGE;
+
+//	Monotonic wall-clock time, in seconds
+double headlessClock(void);
+
+//	Prints the throughput of a run on stdout.  generations may be fractional
+//	for versions that have no notion of generation (numRows*numCols cell
+//	updates then count as one generation).
+void printHeadlessReport(unsigned int numCols, unsigned int numRows, unsigned int numThreads,
+						 double generations, double wallSeconds);
+
+#endif	//	HEADLESS_H
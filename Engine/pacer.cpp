@@ -0,0 +1,223 @@
+//
+//  pacer.cpp
+//  Cellular Automaton
+//
+
+#include <time.h>
+//
+#include "pacer.h"
+
+//	Sleeping for less than that costs more than it is worth
+const int64_t MIN_SLEEP_NS = 200000;
+
+//	Longest single sleep, so that a stop request is noticed promptly even
+//	at very low rates
+const int64_t MAX_SLEEP_SLICE_NS = 5000000;
+
+//	If we fall behind schedule by more than that (the target rate is more
+//	than the machine can do), the schedule restarts from now rather than
+//	trying to catch up with a burst
+const int64_t MAX_LAG_NS = 50000000;
+
+//	Measurement window for measuredRate()
+const int64_t MEASURE_WINDOW_NS = 500000000;
+
+//	The ticket: epoch in the top 16 bits, events claimed in the others.  A
+//	schedule restarts before its count gets anywhere near its epoch.
+const unsigned int EPOCH_SHIFT = 48;
+const uint64_t COUNT_MASK = ((uint64_t) 1 << EPOCH_SHIFT) - 1;
+const uint64_t MAX_COUNT = (uint64_t) 1 << (EPOCH_SHIFT - 1);
+const uint64_t INVALID_EPOCH = ~(uint64_t) 0;
+
+static int64_t nowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+Pacer::Pacer(double rate)
+	:	rate_(rate),
+		lastRate_(rate),
+		ticket_(0),
+		events_(0),
+		measureStartNs_(nowNs()),
+		measureStartEvents_(0),
+		measuredRate_(0.)
+{
+	for (Schedule& schedule : schedules_)
+	{
+		schedule.epoch = INVALID_EPOCH;
+		schedule.startNs = 0;
+		schedule.periodNs = 0;
+	}
+	restartSchedule(INVALID_EPOCH);
+}
+
+
+void Pacer::setRate(double rate)
+{
+	if (rate < 0.)
+		rate = 0.;
+	rate_ = rate;
+	if (rate > 0.)
+		lastRate_ = rate;
+	restartSchedule(INVALID_EPOCH);
+}
+
+
+double Pacer::rate(void) const
+{
+	return rate_;
+}
+
+
+void Pacer::toggleUnthrottled(void)
+{
+	setRate(isUnthrottled() ? lastRate_.load() : 0.);
+}
+
+
+bool Pacer::isUnthrottled(void) const
+{
+	return rate_ <= 0.;
+}
+
+
+//	Starts a new schedule from now at the current rate, unless fromEpoch is
+//	given (not INVALID_EPOCH) and the schedule is no longer of that epoch
+void Pacer::restartSchedule(uint64_t fromEpoch)
+{
+	std::lock_guard<std::mutex> lock(restartLock_);
+	uint64_t epoch = ticket_.load(std::memory_order_relaxed) >> EPOCH_SHIFT;
+	if (fromEpoch != INVALID_EPOCH && fromEpoch != epoch)
+		return;
+	epoch = (epoch + 1) & (INVALID_EPOCH >> EPOCH_SHIFT);
+
+	double rate = rate_;
+	Schedule& schedule = schedules_[epoch % NUM_SCHEDULES];
+	schedule.epoch.store(INVALID_EPOCH, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	schedule.startNs.store(nowNs(), std::memory_order_relaxed);
+	schedule.periodNs.store(rate > 0. ? (int64_t) (1.e9 / rate) : 0, std::memory_order_relaxed);
+	schedule.epoch.store(epoch, std::memory_order_release);
+
+	ticket_.store(epoch << EPOCH_SHIFT, std::memory_order_release);
+}
+
+
+//	Returns false if the schedule of epoch was replaced since (it is then
+//	no longer the current one anyway)
+bool Pacer::readSchedule(uint64_t epoch, int64_t* startNs, int64_t* periodNs) const
+{
+	const Schedule& schedule = schedules_[epoch % NUM_SCHEDULES];
+	uint64_t before = schedule.epoch.load(std::memory_order_acquire);
+	*startNs = schedule.startNs.load(std::memory_order_relaxed);
+	*periodNs = schedule.periodNs.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return before == epoch && schedule.epoch.load(std::memory_order_relaxed) == epoch;
+}
+
+
+void Pacer::pace(unsigned int numEvents, std::stop_token stop)
+{
+	events_.fetch_add(numEvents, std::memory_order_relaxed);
+
+	//	(unthrottled: nothing to claim)
+	int64_t start, period;
+	uint64_t epoch = ticket_.load(std::memory_order_acquire) >> EPOCH_SHIFT;
+	if (readSchedule(epoch, &start, &period) && period == 0)
+		return;
+
+	uint64_t ticket = ticket_.fetch_add(numEvents, std::memory_order_acq_rel);
+	epoch = ticket >> EPOCH_SHIFT;
+	uint64_t last = (ticket & COUNT_MASK) + numEvents;
+	if (!readSchedule(epoch, &start, &period) || period == 0)
+		return;
+	int64_t deadline = start + (int64_t) last * period;
+	int64_t now = nowNs();
+
+	if (now - deadline > MAX_LAG_NS || last >= MAX_COUNT)
+	{
+		restartSchedule(epoch);
+		return;
+	}
+
+	//	Ahead of schedule, but not by enough to be worth a sleep
+	if (deadline - now < MIN_SLEEP_NS)
+		return;
+
+	//	The deadline only holds as long as its schedule does
+	while (now < deadline && !stop.stop_requested())
+	{
+		int64_t wake = deadline - now > MAX_SLEEP_SLICE_NS ? now + MAX_SLEEP_SLICE_NS : deadline;
+		struct timespec ts;
+		ts.tv_sec = wake / 1000000000;
+		ts.tv_nsec = wake % 1000000000;
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+		now = nowNs();
+
+		if (ticket_.load(std::memory_order_acquire) >> EPOCH_SHIFT != epoch ||
+			!readSchedule(epoch, &start, &period))
+			return;
+		deadline = start + (int64_t) last * period;
+	}
+}
+
+
+int64_t Pacer::tryPace(unsigned int numEvents)
+{
+	uint64_t ticket = ticket_.load(std::memory_order_acquire);
+	while (true)
+	{
+		int64_t start, period;
+		uint64_t epoch = ticket >> EPOCH_SHIFT;
+		if (!readSchedule(epoch, &start, &period))
+		{
+			ticket = ticket_.load(std::memory_order_acquire);
+			continue;
+		}
+		if (period == 0)
+			break;
+
+		uint64_t last = (ticket & COUNT_MASK) + numEvents;
+		int64_t deadline = start + (int64_t) last * period;
+		int64_t now = nowNs();
+		if (now - deadline > MAX_LAG_NS || last >= MAX_COUNT)
+		{
+			restartSchedule(epoch);
+			ticket_.fetch_add(numEvents, std::memory_order_relaxed);
+			break;
+		}
+		if (deadline - now >= MIN_SLEEP_NS)
+			return deadline - now;
+
+		//	claimed only if nobody claimed or restarted in between
+		if (ticket_.compare_exchange_weak(ticket, ticket + numEvents, std::memory_order_acq_rel))
+			break;
+	}
+
+	events_.fetch_add(numEvents, std::memory_order_relaxed);
+	return 0;
+}
+
+
+double Pacer::measuredRate(void)
+{
+	int64_t now = nowNs();
+	if (now - measureStartNs_ >= MEASURE_WINDOW_NS)
+	{
+		uint64_t events = events_.load(std::memory_order_relaxed);
+		measuredRate_ = (double) (events - measureStartEvents_) * 1.e9 / (double) (now - measureStartNs_);
+		measureStartNs_ = now;
+		measureStartEvents_ = events;
+	}
+	return measuredRate_;
+}
+
+
+uint64_t Pacer::eventCount(void) const
+{
+	return events_.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,101 @@
+//
+//  pacer.h
+//  Cellular Automaton
+//
+//	Paces the simulation at a target rate of "events" per second (generations
+//	in the banded versions, cell updates in the asynchronous one).  Event n
+//	is due at an absolute deadline start + n/rate, and threads that get ahead
+//	of the schedule sleep until that deadline with clock_nanosleep, so the
+//	time spent computing does not add up to the time spent sleeping.
+//	Several threads may share the same pacer: each call claims its events
+//	on the common schedule.
+//
+//	Sleeps shorter than MIN_SLEEP_NS are skipped (the debt is carried over),
+//	so that pacing a high rate does not turn into one syscall per event.
+//	A rate of 0 means unthrottled: events are only counted.
+//
+//	A schedule (its start, period, and the events claimed on it) changes as
+//	a whole: the ticket that counts the claims carries the epoch of its
+//	schedule in its high bits, so that a restart resets it together with the
+//	start and period it goes with, and a claim always knows which schedule
+//	it was made on.  A thread asleep on a schedule that was replaced (a new
+//	rate) wakes up at its next slice, since its deadline no longer means
+//	anything.
+//
+
+#ifndef PACER_H
+#define PACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+
+class Pacer
+{
+	public:
+
+		explicit Pacer(double rate = 0.);
+
+		//	Changes the target rate (events per second, 0 for unthrottled).
+		//	The schedule restarts from now.
+		void setRate(double rate);
+		double rate(void) const;
+
+		//	Switches between unthrottled and the last target rate
+		void toggleUnthrottled(void);
+		bool isUnthrottled(void) const;
+
+		//	Accounts for numEvents events and, if the caller is ahead of the
+		//	schedule, sleeps until they are due.  The sleep is cut short when
+		//	a stop is requested.
+		void pace(unsigned int numEvents = 1, std::stop_token stop = std::stop_token());
+
+		//	Non-blocking pace(), for a thread that has other work to do.  If
+		//	numEvents more events are due, accounts for them and returns 0,
+		//	otherwise accounts for nothing and returns the number of
+		//	nanoseconds until they are due.
+		int64_t tryPace(unsigned int numEvents = 1);
+
+		//	Rate actually achieved, averaged over the last half second or so.
+		//	Meant to be polled by a single (display) thread.
+		double measuredRate(void);
+
+		//	Total number of events accounted for
+		uint64_t eventCount(void) const;
+
+	private:
+
+		//	start and period of the schedule of epoch, written as a seqlock:
+		//	epoch is INVALID_EPOCH while they change
+		typedef struct Schedule {
+			std::atomic<uint64_t> epoch;
+			std::atomic<int64_t> startNs;
+			std::atomic<int64_t> periodNs;
+		} Schedule;
+
+		static const unsigned int NUM_SCHEDULES = 4;
+
+		void restartSchedule(uint64_t fromEpoch);
+		bool readSchedule(uint64_t epoch, int64_t* startNs, int64_t* periodNs) const;
+
+		std::atomic<double> rate_;
+		std::atomic<double> lastRate_;
+
+		//	epoch of the current schedule (high bits) and number of events
+		//	claimed on it: event n of it is due at startNs + n * periodNs
+		std::atomic<uint64_t> ticket_;
+		//	of the last epochs, by epoch modulo NUM_SCHEDULES
+		Schedule schedules_[NUM_SCHEDULES];
+		//	serializes restarts (the fast paths never take it)
+		std::mutex restartLock_;
+
+		std::atomic<uint64_t> events_;
+
+		//	rate measurement (display thread only)
+		int64_t measureStartNs_;
+		uint64_t measureStartEvents_;
+		double measuredRate_;
+};
+
+#endif	//	PACER_H
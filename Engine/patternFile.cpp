@@ -0,0 +1,747 @@
+//
+//  patternFile.cpp
+//  Cellular Automaton
+//
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+//
+#include "cellEngine.h"
+#include "patternFile.h"
+
+//	Longest line of the RLE files we write, as other programs do
+const size_t RLE_LINE_LENGTH = 70;
+
+//	Patterns and offsets are kept within 2^62 cells, so that coordinates
+//	never overflow an int64_t (the deepest Macrocell node read is that size)
+const int64_t MAX_PATTERN_SIZE = (int64_t) 1 << 62;
+const unsigned int MAX_MACROCELL_LEVEL = 62;
+
+//	Size of the chunks in which the files are written
+const size_t WRITE_CHUNK = 1 << 20;
+
+//	Board a pattern is placed on
+struct Pattern::Placement {
+	uint8_t* cells;
+	int64_t numRows, numCols;
+};
+
+//	Bounding box of live cells: rows [top, bottom) and columns [left, right)
+typedef struct LiveBox {
+	int64_t top, left, bottom, right;
+} LiveBox;
+
+//	Macrocell nodes written, by their children
+typedef struct NodeKey {
+	uint32_t child[4];
+	bool operator ==(const NodeKey& other) const { return memcmp(child, other.child, sizeof(child)) == 0; }
+} NodeKey;
+
+typedef struct NodeKeyHash {
+	size_t operator ()(const NodeKey& key) const
+	{
+		uint64_t hash = ((uint64_t) key.child[0] << 32 | key.child[1]) * 0x9e3779b97f4a7c15ull;
+		hash ^= ((uint64_t) key.child[2] << 32 | key.child[3]) + (hash >> 29);
+		return hash * 0xbf58476d1ce4e5b9ull;
+	}
+} NodeKeyHash;
+
+static bool readFile(const char* path, std::string* text);
+static bool parseRleHeader(const char* line, size_t length, uint64_t* numCols, uint64_t* numRows, unsigned int* rule);
+static const char* parseNumber(const char* p, const char* end, uint64_t* number);
+static void fillRun(const uint8_t state, uint8_t* cells, int64_t numRows, int64_t numCols, int64_t row,
+					int64_t col, int64_t count);
+static size_t findCell(const uint8_t* cells, size_t k, size_t end, bool live);
+static size_t lastLiveCell(const uint8_t* cells, size_t begin, size_t end);
+static LiveBox liveBox(const uint8_t* cells, unsigned int numRows, unsigned int numCols);
+static void writeRle(FILE* out, const uint8_t* cells, unsigned int numCols, const LiveBox& box, unsigned int rule);
+static void writeMacrocell(FILE* out, const uint8_t* cells, unsigned int numCols, const LiveBox& box,
+						   unsigned int rule);
+static uint64_t leafBits(const uint8_t* cells, unsigned int numCols, const LiveBox& box, int64_t row, int64_t col);
+static void appendRun(std::string* text, size_t* lineLength, FILE* out, uint64_t count, char tag);
+static void flushText(std::string* text, FILE* out, size_t atLeast);
+
+
+PatternFormat patternFormat(const char* path)
+{
+	const char* extension = strrchr(path, '.');
+	return extension != NULL && strcasecmp(extension, ".mc") == 0 ? PATTERN_MACROCELL : PATTERN_RLE;
+}
+
+
+Pattern::Pattern(void)
+	:	format_(PATTERN_RLE),
+		numRows_(0),
+		numCols_(0),
+		rule_(0),
+		body_(0),
+		top_(0),
+		left_(0)
+{
+}
+
+
+bool Pattern::read(const char* path)
+{
+	if (!readFile(path, &text_))
+		return false;
+
+	//	Recognized by their contents, whatever their name
+	format_ = text_.compare(0, 4, "[M2]") == 0 ? PATTERN_MACROCELL : PATTERN_RLE;
+	numRows_ = numCols_ = 0;
+	rule_ = 0;
+	nodes_.clear();
+	bool valid = format_ == PATTERN_MACROCELL ? parseMacrocell() : parseRle();
+
+	//	(the nodes are all a Macrocell pattern needs)
+	if (format_ == PATTERN_MACROCELL || !valid)
+		std::string().swap(text_);
+	if (!valid)
+	{
+		nodes_.clear();
+		numRows_ = numCols_ = 0;
+		errno = EINVAL;
+	}
+	return valid;
+}
+
+
+uint64_t Pattern::numRows(void) const
+{
+	return numRows_;
+}
+
+
+uint64_t Pattern::numCols(void) const
+{
+	return numCols_;
+}
+
+
+unsigned int Pattern::rule(void) const
+{
+	return rule_;
+}
+
+
+void Pattern::place(uint8_t* cells, unsigned int numRows, unsigned int numCols, int64_t row, int64_t col) const
+{
+	//	(a pattern that far off the board has no cell on it anyway)
+	row = std::clamp<int64_t>(row, -MAX_PATTERN_SIZE, numRows);
+	col = std::clamp<int64_t>(col, -MAX_PATTERN_SIZE, numCols);
+	Placement board = {cells, numRows, numCols};
+
+	//	The rectangle of the pattern starts out dead
+	int64_t top = std::max<int64_t>(row, 0), bottom = std::min<int64_t>(row + numRows_, numRows);
+	for (int64_t r = top; r < bottom; r++)
+		fillRun(0, cells, numRows, numCols, r, col, numCols_);
+
+	if (format_ == PATTERN_RLE)
+		placeRle(board, row, col);
+	else if (nodes_.size() > 1)
+		placeNode(board, nodes_.size() - 1, row - top_, col - left_);
+}
+
+
+//	Comment lines, then the header line.  The runs start on the next line.
+bool Pattern::parseRle(void)
+{
+	const char* text = text_.c_str();
+	size_t k = 0;
+	while (k < text_.size())
+	{
+		size_t start = k, end = k + strcspn(text + k, "\r\n");
+		k = end + strspn(text + end, "\r\n");
+		while (start < end && isspace((unsigned char) text[start]))
+			start++;
+
+		if (start == end || text[start] == '#')
+			continue;
+		body_ = k;
+		return text[start] == 'x' && parseRleHeader(text + start, end - start, &numCols_, &numRows_, &rule_);
+	}
+	return false;
+}
+
+
+//	Nodes refer to earlier ones only, so they come children first
+bool Pattern::parseMacrocell(void)
+{
+	nodes_.assign(1, Node{0, false, {0, 0, 0, 0}, 0});
+
+	const char* text = text_.c_str();
+	size_t k = strcspn(text, "\r\n");
+	while (k < text_.size())
+	{
+		k += strspn(text + k, "\r\n");
+		const char* line = text + k;
+		size_t length = strcspn(line, "\r\n");
+		k += length;
+		if (length == 0)
+			continue;
+
+		Node node = {3, true, {0, 0, 0, 0}, 0};
+		if (line[0] == '#')
+		{
+			if (length > 2 && line[1] == 'R')
+			{
+				std::string rule(line + 2, length - 2);
+				rule_ = parseRuleString(rule.c_str() + strspn(rule.c_str(), " \t"));
+			}
+			continue;
+		}
+		else if (line[0] == '.' || line[0] == '*' || line[0] == '$')
+		{
+			unsigned int r = 0, c = 0;
+			for (size_t i = 0; i < length; i++)
+			{
+				if (line[i] == '$')
+				{
+					r++;
+					c = 0;
+					continue;
+				}
+				if (r >= 8 || c >= 8 || (line[i] != '*' && line[i] != '.'))
+					return false;
+				node.leaf |= (uint64_t) (line[i] == '*') << (8 * r + c);
+				c++;
+			}
+			if (r > 8)
+				return false;
+		}
+		else
+		{
+			//	"<level> <nw> <ne> <sw> <se>" (at level 1, four cell states)
+			const char* p = line;
+			const char* end = line + length;
+			uint64_t level, child;
+			p = parseNumber(p, end, &level);
+			if (p == NULL || level < 1 || level > MAX_MACROCELL_LEVEL)
+				return false;
+			node.level = (unsigned int) level;
+			node.isLeaf = false;
+			for (unsigned int q = 0; q < 4; q++)
+			{
+				p = parseNumber(p, end, &child);
+				if (p == NULL || (level > 1 && child != 0 && (child >= nodes_.size() || nodes_[child].level != level - 1)))
+					return false;
+				node.child[q] = (uint32_t) std::min<uint64_t>(child, UINT32_MAX);
+			}
+			while (p < end && (*p == ' ' || *p == '\t'))
+				p++;
+			if (p != end)
+				return false;
+		}
+		if (nodes_.size() == UINT32_MAX)
+			return false;
+		nodes_.push_back(node);
+	}
+	if (nodes_.size() < 2)
+		return false;
+
+	//	Bounding box of each node, relative to its top left corner
+	std::vector<LiveBox> boxes(nodes_.size(), LiveBox{0, 0, 0, 0});
+	for (size_t n = 1; n < nodes_.size(); n++)
+	{
+		const Node& node = nodes_[n];
+		LiveBox& box = boxes[n];
+		box = {MAX_PATTERN_SIZE, MAX_PATTERN_SIZE, 0, 0};
+		if (node.isLeaf && node.leaf != 0)
+		{
+			//	the columns of all the rows, folded into the low byte
+			uint64_t columns = node.leaf | node.leaf >> 32;
+			columns = (columns | columns >> 16) & 0xffff;
+			columns = (columns | columns >> 8) & 0xff;
+			box = {__builtin_ctzll(node.leaf) / 8, __builtin_ctzll(columns),
+				   (63 - __builtin_clzll(node.leaf)) / 8 + 1, 64 - __builtin_clzll(columns)};
+		}
+		for (unsigned int q = 0; q < 4 && !node.isLeaf; q++)
+		{
+			int64_t half = (int64_t) 1 << (node.level - 1);
+			int64_t r = (q / 2) * half, c = (q % 2) * half;
+			if (node.level == 1 && node.child[q] != 0)
+				box = {std::min(box.top, r), std::min(box.left, c), std::max(box.bottom, r + 1),
+					   std::max(box.right, c + 1)};
+			else if (node.level > 1 && node.child[q] != 0 && boxes[node.child[q]].bottom != 0)
+			{
+				const LiveBox& child = boxes[node.child[q]];
+				box = {std::min(box.top, r + child.top), std::min(box.left, c + child.left),
+					   std::max(box.bottom, r + child.bottom), std::max(box.right, c + child.right)};
+			}
+		}
+		if (box.bottom == 0)
+			box = {0, 0, 0, 0};
+	}
+
+	const LiveBox& root = boxes.back();
+	top_ = root.top;
+	left_ = root.left;
+	numRows_ = root.bottom - root.top;
+	numCols_ = root.right - root.left;
+	return true;
+}
+
+
+//	Runs from text_[body_] to '!' (or the end of the file).  Counts that
+//	span a line break are allowed; anything else we do not know is skipped.
+//	Most runs are a cell or two long, so those of a row within the board
+//	are written straight into it.
+void Pattern::placeRle(const Placement& board, int64_t row, int64_t col) const
+{
+	const char* end = text_.c_str() + text_.size();
+	int64_t r = row, c = col;
+	uint8_t* cells = r >= 0 && r < board.numRows ? board.cells + r * board.numCols : NULL;
+	int64_t count = 0;
+
+	//	(r, c and n stay within MAX_PATTERN_SIZE of 0, but the sum of two of
+	//	them may not fit: sums are only taken once they are known to fit)
+	for (const char* p = text_.c_str() + body_; p < end; p++)
+	{
+		unsigned char tag = *p;
+		if ((unsigned char) (tag - '0') < 10)
+		{
+			//	(capped before multiplying, which would overflow)
+			count = count > (MAX_PATTERN_SIZE - 9) / 10 ? MAX_PATTERN_SIZE
+					: std::min<int64_t>(10 * count + (tag - '0'), MAX_PATTERN_SIZE);
+			continue;
+		}
+
+		int64_t n = count > 0 ? count : 1;
+		switch (tag)
+		{
+			case ' ':
+			case '\t':
+			case '\r':
+			case '\n':
+				continue;
+
+			case 'b':
+			case '.':
+				c = std::min(c, MAX_PATTERN_SIZE - n) + n;
+				break;
+
+			case '$':
+				r = std::min(r, MAX_PATTERN_SIZE - n) + n;
+				c = col;
+				cells = r >= 0 && r < board.numRows ? board.cells + r * board.numCols : NULL;
+				break;
+
+			case '!':
+				return;
+
+			case '#':
+				p = std::find(p, end, '\n');
+				break;
+
+			default:
+				if (!isalpha(tag))
+					break;
+				//	multistate: "pA" to "yX" are single states
+				if (tag >= 'p' && tag <= 'y' && p + 1 < end && p[1] >= 'A' && p[1] <= 'X')
+					p++;
+				if (cells != NULL && c >= 0 && n <= board.numCols - c)
+				{
+					if (n == 1)
+						cells[c] = 1;
+					else
+						memset(cells + c, 1, n);
+				}
+				else
+					fillRun(1, board.cells, board.numRows, board.numCols, r, c, n);
+				c = std::min(c, MAX_PATTERN_SIZE - n) + n;
+				break;
+		}
+		count = 0;
+	}
+}
+
+
+//	Node of the pattern with its top left corner at (row, col) of the board
+void Pattern::placeNode(const Placement& board, uint32_t node, int64_t row, int64_t col) const
+{
+	const Node& n = nodes_[node];
+	int64_t size = (int64_t) 1 << n.level;
+	if (node == 0 || row >= board.numRows || col >= board.numCols || row + size <= 0 || col + size <= 0)
+		return;
+
+	if (n.isLeaf)
+	{
+		for (uint64_t bits = n.leaf; bits != 0; bits &= bits - 1)
+		{
+			unsigned int q = __builtin_ctzll(bits);
+			fillRun(1, board.cells, board.numRows, board.numCols, row + q / 8, col + q % 8, 1);
+		}
+	}
+	else if (n.level == 1)
+	{
+		for (unsigned int q = 0; q < 4; q++)
+			if (n.child[q] != 0)
+				fillRun(1, board.cells, board.numRows, board.numCols, row + q / 2, col + q % 2, 1);
+	}
+	else
+	{
+		int64_t half = size / 2;
+		for (unsigned int q = 0; q < 4; q++)
+			placeNode(board, n.child[q], row + (q / 2) * half, col + (q % 2) * half);
+	}
+}
+
+
+bool writePattern(const char* path, PatternFormat format, const uint8_t* cells, unsigned int numRows,
+				  unsigned int numCols, unsigned int rule)
+{
+	LiveBox box = liveBox(cells, numRows, numCols);
+
+	FILE* out = fopen(path, "w");
+	if (out == NULL)
+		return false;
+	if (format == PATTERN_MACROCELL)
+		writeMacrocell(out, cells, numCols, box, rule);
+	else
+		writeRle(out, cells, numCols, box, rule);
+
+	bool written = ferror(out) == 0;
+	int error = written ? 0 : (errno != 0 ? errno : EIO);
+	if (fclose(out) != 0 && written)
+	{
+		error = errno;
+		written = false;
+	}
+	if (!written)
+		errno = error;
+	return written;
+}
+
+
+static bool readFile(const char* path, std::string* text)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	bool done = fstat(fd, &info) == 0;
+	if (done)
+	{
+		text->resize(info.st_size);
+		size_t size = 0;
+		while (done && size < text->size())
+		{
+			ssize_t n = read(fd, text->data() + size, text->size() - size);
+			if (n == 0)
+				break;
+			done = n > 0 || errno == EINTR;
+			size += n > 0 ? n : 0;
+		}
+		text->resize(size);
+	}
+
+	int error = errno;
+	close(fd);
+	errno = error;
+	return done;
+}
+
+
+//	"x = <cols>, y = <rows>[, rule = <rule>]"
+static bool parseRleHeader(const char* line, size_t length, uint64_t* numCols, uint64_t* numRows, unsigned int* rule)
+{
+	std::string header(line, length);
+	bool hasCols = false, hasRows = false;
+	*rule = 0;
+
+	for (size_t start = 0; start < header.size(); )
+	{
+		size_t end = std::min(header.find(',', start), header.size());
+		std::string item = header.substr(start, end - start);
+		start = end + 1;
+
+		char key[32], value[256], *valueEnd;
+		if (sscanf(item.c_str(), " %31[^= \t] = %255s", key, value) != 2)
+			continue;
+		if (strcmp(key, "x") == 0 || strcmp(key, "y") == 0)
+		{
+			unsigned long long size = strtoull(value, &valueEnd, 10);
+			if (*valueEnd != '\0' || value[0] == '-' || size > (unsigned long long) MAX_PATTERN_SIZE)
+				return false;
+			*(key[0] == 'x' ? numCols : numRows) = size;
+			(key[0] == 'x' ? hasCols : hasRows) = true;
+		}
+		else if (strcmp(key, "rule") == 0)
+			*rule = parseRuleString(value);
+	}
+	return hasCols && hasRows;
+}
+
+
+//	Number after blanks, within [p, end).  Returns where it ends, or NULL
+//	if there is none.
+static const char* parseNumber(const char* p, const char* end, uint64_t* number)
+{
+	while (p < end && (*p == ' ' || *p == '\t'))
+		p++;
+	if (p == end || *p < '0' || *p > '9')
+		return NULL;
+	for (*number = 0; p < end && *p >= '0' && *p <= '9'; p++)
+		*number = std::min<uint64_t>(10 * *number + (*p - '0'), UINT32_MAX);
+	return p;
+}
+
+
+//	Sets count cells of row, from col, to state, within the board
+static void fillRun(const uint8_t state, uint8_t* cells, int64_t numRows, int64_t numCols, int64_t row,
+					int64_t col, int64_t count)
+{
+	if (row < 0 || row >= numRows)
+		return;
+	int64_t start = std::max<int64_t>(col, 0), end = count < numCols - col ? col + count : numCols;
+	if (start < end)
+		memset(cells + row * numCols + start, state, end - start);
+}
+
+
+//	First cell of [k, end) that is live (or dead), or end.  Cells are
+//	checked 8 at a time, since long runs of either kind are the rule.
+static size_t findCell(const uint8_t* cells, size_t k, size_t end, bool live)
+{
+	const uint64_t LOW_BITS = 0x0101010101010101ull, HIGH_BITS = 0x8080808080808080ull;
+	for (; k + 8 <= end; k += 8)
+	{
+		uint64_t word;
+		memcpy(&word, cells + k, 8);
+		//	(the second test is true iff a byte of word is zero)
+		if (live ? word != 0 : ((word - LOW_BITS) & ~word & HIGH_BITS) != 0)
+			break;
+	}
+	for (; k < end; k++)
+		if ((cells[k] != 0) == live)
+			return k;
+	return end;
+}
+
+
+//	One past the last live cell of [begin, end), or begin if there is none
+static size_t lastLiveCell(const uint8_t* cells, size_t begin, size_t end)
+{
+	size_t k = end;
+	for (; k >= begin + 8; k -= 8)
+	{
+		uint64_t word;
+		memcpy(&word, cells + k - 8, 8);
+		if (word != 0)
+			break;
+	}
+	while (k > begin && cells[k - 1] == 0)
+		k--;
+	return k;
+}
+
+
+//	All zeros if the board is empty
+static LiveBox liveBox(const uint8_t* cells, unsigned int numRows, unsigned int numCols)
+{
+	LiveBox box = {numRows, numCols, 0, 0};
+	for (unsigned int r = 0; r < numRows; r++)
+	{
+		const uint8_t* row = cells + (size_t) r * numCols;
+		size_t first = findCell(row, 0, numCols, true);
+		if (first == numCols)
+			continue;
+		box.top = std::min<int64_t>(box.top, r);
+		box.bottom = r + 1;
+		box.left = std::min<int64_t>(box.left, first);
+		box.right = std::max<int64_t>(box.right, lastLiveCell(row, first, numCols));
+	}
+	if (box.bottom == 0)
+		box = {0, 0, 0, 0};
+	return box;
+}
+
+
+static void writeRle(FILE* out, const uint8_t* cells, unsigned int numCols, const LiveBox& box, unsigned int rule)
+{
+	fprintf(out, "x = %lld, y = %lld, rule = %s\n", (long long) (box.right - box.left),
+			(long long) (box.bottom - box.top), ruleString(rule) != NULL ? ruleString(rule) : "B3/S23");
+
+	//	Dead cells at the end of a row are left out, and the ends of empty
+	//	rows merged into a single run of '$'
+	std::string text;
+	size_t lineLength = 0;
+	int64_t lastRow = box.top;
+	for (int64_t r = box.top; r < box.bottom; r++)
+	{
+		const uint8_t* row = cells + r * numCols;
+		size_t end = lastLiveCell(row, box.left, box.right);
+		if (end == (size_t) box.left)
+			continue;
+		if (r > lastRow)
+			appendRun(&text, &lineLength, out, r - lastRow, '$');
+		lastRow = r;
+
+		for (size_t k = box.left; k < end; )
+		{
+			size_t live = findCell(row, k, end, true);
+			size_t dead = findCell(row, live, end, false);
+			if (live > k)
+				appendRun(&text, &lineLength, out, live - k, 'b');
+			appendRun(&text, &lineLength, out, dead - live, 'o');
+			k = dead;
+		}
+	}
+	appendRun(&text, &lineLength, out, 1, '!');
+	text += '\n';
+	flushText(&text, out, 0);
+}
+
+
+//	Built bottom up: the 8x8 leaves of the bounding box, then each level
+//	from the nodes of the one below, two by two in each direction, until a
+//	single root is left.  A node is written the first time it shows up, and
+//	only referred to by its number afterwards.
+static void writeMacrocell(FILE* out, const uint8_t* cells, unsigned int numCols, const LiveBox& box,
+						   unsigned int rule)
+{
+	fprintf(out, "[M2] (cell)\n#R %s\n", ruleString(rule) != NULL ? ruleString(rule) : "B3/S23");
+	int64_t size = std::max(box.bottom - box.top, box.right - box.left);
+	if (size == 0)
+	{
+		fputs("$\n", out);
+		return;
+	}
+	unsigned int level = 3;
+	while (((int64_t) 1 << level) < size)
+		level++;
+
+	std::string text;
+	char line[96];
+	uint32_t numNodes = 0;
+
+	//	node numbers of the current level, row by row (0: empty)
+	int64_t rows = (box.bottom - box.top + 7) / 8, cols = (box.right - box.left + 7) / 8;
+	std::vector<uint32_t> nodes(rows * cols);
+	std::unordered_map<uint64_t, uint32_t> leaves;
+	for (int64_t i = 0; i < rows; i++)
+		for (int64_t j = 0; j < cols; j++)
+		{
+			uint64_t bits = leafBits(cells, numCols, box, box.top + 8 * i, box.left + 8 * j);
+			if (bits == 0)
+				continue;
+			auto [leaf, added] = leaves.try_emplace(bits, numNodes + 1);
+			nodes[i * cols + j] = leaf->second;
+			if (!added)
+				continue;
+			numNodes++;
+
+			//	'$' ends each row, and empty rows at the end are left out
+			for (unsigned int r = 0; r < 8 && (bits >> (8 * r)) != 0; r++)
+			{
+				unsigned int rowBits = (bits >> (8 * r)) & 0xff;
+				for (unsigned int c = 0; rowBits >> c != 0; c++)
+					text += (rowBits >> c & 1) != 0 ? '*' : '.';
+				text += '$';
+			}
+			text += '\n';
+			flushText(&text, out, WRITE_CHUNK);
+		}
+
+	for (unsigned int l = 4; l <= level; l++)
+	{
+		int64_t upperRows = (rows + 1) / 2, upperCols = (cols + 1) / 2;
+		std::vector<uint32_t> upper(upperRows * upperCols);
+		std::unordered_map<NodeKey, uint32_t, NodeKeyHash> known;
+		for (int64_t i = 0; i < upperRows; i++)
+			for (int64_t j = 0; j < upperCols; j++)
+			{
+				NodeKey key;
+				for (unsigned int q = 0; q < 4; q++)
+				{
+					int64_t r = 2 * i + q / 2, c = 2 * j + q % 2;
+					key.child[q] = r < rows && c < cols ? nodes[r * cols + c] : 0;
+				}
+				if ((key.child[0] | key.child[1] | key.child[2] | key.child[3]) == 0)
+					continue;
+				auto [node, added] = known.try_emplace(key, numNodes + 1);
+				upper[i * upperCols + j] = node->second;
+				if (!added)
+					continue;
+				numNodes++;
+
+				snprintf(line, sizeof(line), "%u %u %u %u %u\n", l, key.child[0], key.child[1], key.child[2],
+						 key.child[3]);
+				text += line;
+				flushText(&text, out, WRITE_CHUNK);
+			}
+		nodes.swap(upper);
+		rows = upperRows;
+		cols = upperCols;
+	}
+	flushText(&text, out, 0);
+}
+
+
+//	8x8 cells from (row, col), clipped to box: bit 8*r+c for cell (r, c)
+static uint64_t leafBits(const uint8_t* cells, unsigned int numCols, const LiveBox& box, int64_t row, int64_t col)
+{
+	const uint64_t LOW_BITS = 0x0101010101010101ull;
+	uint64_t bits = 0;
+	for (int64_t r = 0; r < 8 && row + r < box.bottom; r++)
+	{
+		const uint8_t* cell = cells + (row + r) * numCols + col;
+		uint64_t rowBits = 0;
+		if (col + 8 <= box.right)
+		{
+			//	the low bit of each byte (1 for a live cell), gathered into
+			//	the low 8 bits of the word, first cell first
+			uint64_t word;
+			memcpy(&word, cell, 8);
+			word = (word | word >> 1 | word >> 2) & LOW_BITS;
+			rowBits = (word * 0x0102040810204080ull) >> 56;
+		}
+		else
+			for (int64_t c = 0; col + c < box.right; c++)
+				rowBits |= (uint64_t) (cell[c] != 0) << c;
+		bits |= rowBits << (8 * r);
+	}
+	return bits;
+}
+
+
+//	Adds "<count><tag>" (no count if 1) to text, on a new line if the
+//	current one would get too long
+static void appendRun(std::string* text, size_t* lineLength, FILE* out, uint64_t count, char tag)
+{
+	char run[24];
+	char* end = run;
+	if (count != 1)
+		end = std::to_chars(run, run + sizeof(run) - 1, count).ptr;
+	*end++ = tag;
+
+	if (*lineLength + (end - run) > RLE_LINE_LENGTH)
+	{
+		*text += '\n';
+		*lineLength = 0;
+		flushText(text, out, WRITE_CHUNK);
+	}
+	text->append(run, end);
+	*lineLength += end - run;
+}
+
+
+//	Writes text out if it holds at least that many bytes
+static void flushText(std::string* text, FILE* out, size_t atLeast)
+{
+	if (text->size() < atLeast || text->empty())
+		return;
+	fwrite(text->data(), 1, text->size(), out);
+	text->clear();
+}
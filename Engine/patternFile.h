@@ -0,0 +1,105 @@
+//
+//  patternFile.h
+//  Cellular Automaton
+//
+//	Patterns in the two standard file formats of Life programs, to start a
+//	board from a known pattern (an R-pentomino, a glider gun, a breeder)
+//	rather than from random soup:
+//
+//	-	RLE (.rle): comment lines starting with '#', a header line
+//		"x = <cols>, y = <rows>, rule = B3/S23", then the rows of the
+//		pattern, run-length encoded: "<n>b" for n dead cells, "<n>o" for n
+//		live ones (any other letter is a live cell too, and '.' a dead one),
+//		"<n>$" to end n rows, and '!' at the end.  A missing count is 1.
+//	-	Macrocell (.mc): the quadtree of the pattern, as written by hashlife
+//		programs.  After a "[M2]" line and comments (the rule in "#R"), each
+//		line is a node, numbered from 1 (0: empty): an 8x8 leaf drawn with
+//		'.' (dead), '*' (live) and '$' (end of row), or "<level> <nw> <ne>
+//		<sw> <se>" for a node of 2^level x 2^level cells.  The last node is
+//		the root.  Identical subtrees are written once, so that huge but
+//		regular patterns stay small.
+//
+//	A file is read whole, then decoded in a single pass over its text (or
+//	its nodes) straight into the board, so that a pattern file of a few
+//	megabytes takes milliseconds.
+//
+
+#ifndef PATTERN_FILE_H
+#define PATTERN_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+typedef enum PatternFormat {
+	PATTERN_RLE = 0,
+	PATTERN_MACROCELL
+} PatternFormat;
+
+//	From the extension of path: .mc for Macrocell, RLE otherwise
+PatternFormat patternFormat(const char* path);
+
+class Pattern
+{
+	public:
+
+		Pattern(void);
+
+		//	Returns false, with errno set (EINVAL if the file is not a valid
+		//	pattern), on failure
+		bool read(const char* path);
+
+		//	Size of the pattern: the one given in the header of an RLE file,
+		//	the bounding box of the live cells of a Macrocell one
+		uint64_t numRows(void) const;
+		uint64_t numCols(void) const;
+
+		//	The rule of the file, if it is one of cellEngine.h (0 otherwise)
+		unsigned int rule(void) const;
+
+		//	Writes the pattern into cells, a board of numRows x numCols cells
+		//	stored row by row, with its top left corner at (row, col).  The
+		//	rectangle it covers is overwritten, and whatever falls outside the
+		//	board is dropped.  Live cells get state 1.
+		void place(uint8_t* cells, unsigned int numRows, unsigned int numCols, int64_t row, int64_t col) const;
+
+	private:
+
+		//	Macrocell node: four children of the level below (at level 1,
+		//	four cell states), nw, ne, sw and se, or an 8x8 leaf (level 3, bit
+		//	8*row+col set for a live cell)
+		typedef struct Node {
+			unsigned int level;
+			bool isLeaf;
+			uint32_t child[4];
+			uint64_t leaf;
+		} Node;
+
+		struct Placement;
+
+		bool parseRle(void);
+		bool parseMacrocell(void);
+		void placeRle(const Placement& board, int64_t row, int64_t col) const;
+		void placeNode(const Placement& board, uint32_t node, int64_t row, int64_t col) const;
+
+		PatternFormat format_;
+		uint64_t numRows_, numCols_;
+		unsigned int rule_;
+
+		//	RLE: the whole file, whose runs start at text_[body_]
+		std::string text_;
+		size_t body_;
+
+		//	Macrocell: node k of the file in nodes_[k] (nodes_[0]: empty), and
+		//	where the bounding box of the root starts within it
+		std::vector<Node> nodes_;
+		int64_t top_, left_;
+};
+
+//	Writes the bounding box of the live cells of a board of numRows x
+//	numCols cells, with rule (see cellEngine.h), as a pattern file.
+//	Returns false, with errno set, on failure.
+bool writePattern(const char* path, PatternFormat format, const uint8_t* cells, unsigned int numRows,
+				  unsigned int numCols, unsigned int rule);
+
+#endif	//	PATTERN_FILE_H
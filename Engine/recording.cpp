@@ -0,0 +1,866 @@
+//
+//  recording.cpp
+//  Cellular Automaton
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+//
+#include "recording.h"
+
+static const char RECORDING_MAGIC[8] = {'C', 'E', 'L', 'L', 'R', 'E', 'C', 'D'};
+static const char INDEX_MAGIC[8] = {'C', 'E', 'L', 'L', 'I', 'N', 'D', 'X'};
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+static const uint32_t RECORDING_VERSION = 1;
+
+//	Words of a group, whose words that are not zero are given by a mask
+const size_t GROUP_WORDS = 64;
+
+//	Beyond this many bytes of records waiting for the writer, the compute
+//	threads wait for it
+const size_t MAX_QUEUED_BYTES = (size_t) 256 << 20;
+
+//	Longest varint, for 64 bits
+const size_t MAX_VARINT_BYTES = 10;
+
+//	Buffers of written records kept for reuse
+const size_t MAX_SPARE_BUFFERS = 4;
+
+static uint64_t rowWord(const uint8_t* previous, const uint8_t* cells, size_t numCells, size_t w);
+static void storeWord(uint8_t* cells, size_t numCells, size_t w, uint64_t word);
+static size_t packGroup(const uint8_t* previous, const uint8_t* cells, unsigned int bits, uint8_t* packed,
+						uint64_t* mask, uint64_t* high);
+static void packWord(uint64_t word, unsigned int bits, uint8_t* packed, size_t* count);
+static uint8_t packBits(uint64_t word);
+static uint64_t unpackBits(uint8_t bits);
+static uint32_t packNibbles(uint64_t word);
+static uint64_t unpackNibbles(uint32_t nibbles);
+static uint8_t* chunkSpace(std::vector<uint8_t>* chunk, size_t used, size_t size);
+static uint8_t* putVarint(uint8_t* out, uint64_t value);
+static bool readVarint(const uint8_t** p, const uint8_t* end, uint64_t* value);
+static const uint8_t* decodeChunk(const uint8_t* p, const uint8_t* end, bool keyframe, uint8_t* cells,
+								  unsigned int numRows, unsigned int numCols);
+static bool writeBytes(int fd, const void* data, size_t size);
+static bool readBytes(int fd, void* data, size_t size, uint64_t offset);
+
+
+void encodeRecordRows(const uint8_t* previous, const uint8_t* cells, unsigned int firstRow,
+					  unsigned int numRows, unsigned int numCols, std::vector<uint8_t>* chunk)
+{
+	const uint64_t LOW_BITS = 0x0101010101010101ull;
+	size_t first = (size_t) firstRow * numCols;
+	size_t numCells = (size_t) numRows * numCols;
+	size_t numWords = (numCells + 7) / 8;
+	size_t numGroups = (numWords + GROUP_WORDS - 1) / GROUP_WORDS;
+	const uint8_t* now = cells + first;
+	const uint8_t* before = previous != NULL ? previous + first : NULL;
+	size_t chunkStart = chunk->size();
+
+	//	1 bit per cell, until a word has more than the low bit of a byte set:
+	//	the chunk then starts over with 4 bits per cell
+	for (unsigned int bits = 1; ; bits = 4)
+	{
+		uint8_t* out = chunkSpace(chunk, chunkStart, 3 * MAX_VARINT_BYTES + sizeof(uint64_t));
+		out = putVarint(out, firstRow);
+		out = putVarint(out, numRows);
+		out = putVarint(out, bits);
+		size_t sizeAt = out - chunk->data();
+		size_t used = sizeAt + sizeof(uint64_t);
+
+		//	Every word is packed, and kept only if it is not zero: no branch
+		//	on the contents of the board
+		uint8_t packed[GROUP_WORDS * 4];
+		uint64_t high = 0;
+		size_t numEmpty = 0;
+		bool restart = false;
+		for (size_t g = 0; g < numGroups && !restart; g++)
+		{
+			size_t firstWord = g * GROUP_WORDS;
+			size_t groupWords = std::min(GROUP_WORDS, numWords - firstWord);
+			uint64_t mask = 0;
+			size_t count = 0;
+			if (firstWord * 8 + GROUP_WORDS * 8 <= numCells)
+				count = packGroup(before != NULL ? before + firstWord * 8 : NULL, now + firstWord * 8, bits,
+								  packed, &mask, &high);
+			else
+				for (size_t i = 0; i < groupWords; i++)
+				{
+					uint64_t word = rowWord(before, now, numCells, firstWord + i);
+					high |= word;
+					mask |= (uint64_t) (word != 0) << i;
+					packWord(word, bits, packed, &count);
+				}
+			restart = bits == 1 && (high & ~LOW_BITS) != 0;
+
+			if (mask == 0)
+				numEmpty++;
+			else
+			{
+				size_t numBytes = bits == 1 ? count : 4 * count;
+				uint8_t* start = chunkSpace(chunk, used, MAX_VARINT_BYTES + sizeof(mask) + numBytes);
+				out = putVarint(start, numEmpty);
+				memcpy(out, &mask, sizeof(mask));
+				memcpy(out + sizeof(mask), packed, numBytes);
+				used += (out - start) + sizeof(mask) + numBytes;
+				numEmpty = 0;
+			}
+		}
+		if (restart)
+			continue;
+		if (numEmpty > 0)
+			used = putVarint(chunkSpace(chunk, used, MAX_VARINT_BYTES), numEmpty) - chunk->data();
+
+		chunk->resize(used);
+		uint64_t size = used - sizeAt - sizeof(uint64_t);
+		memcpy(chunk->data() + sizeAt, &size, sizeof(size));
+		return;
+	}
+}
+
+
+bool decodeRecordChunks(const uint8_t* bytes, size_t size, bool keyframe, uint8_t* cells,
+						unsigned int numRows, unsigned int numCols)
+{
+	const uint8_t* p = bytes;
+	const uint8_t* end = bytes + size;
+	while (p != NULL && p < end)
+		p = decodeChunk(p, end, keyframe, cells, numRows, numCols);
+	return p != NULL;
+}
+
+
+Recorder::Recorder(void)
+	:	fd_(-1),
+		numRows_(0),
+		numCols_(0),
+		recording_(false),
+		keyframeInterval_(0),
+		encodeNanos_(0),
+		queuedBytes_(0),
+		chained_(false),
+		stats_{}
+{
+}
+
+
+Recorder::~Recorder(void)
+{
+	stop();
+}
+
+
+bool Recorder::start(const char* path, const uint8_t* cells, unsigned int numRows, unsigned int numCols,
+					 unsigned long generation, unsigned long keyframeInterval)
+{
+	if (recording_)
+	{
+		errno = EBUSY;
+		return false;
+	}
+	if (keyframeInterval == 0)
+	{
+		errno = EINVAL;
+		return false;
+	}
+
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return false;
+
+	RecordingHeader header = {};
+	memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+	header.byteOrder = BYTE_ORDER_MARK;
+	header.version = RECORDING_VERSION;
+	header.numRows = numRows;
+	header.numCols = numCols;
+	header.keyframeInterval = keyframeInterval;
+
+	RecordChunk first;
+	encodeRecordRows(NULL, cells, 0, numRows, numCols, &first.bytes);
+
+	fd_ = fd;
+	numRows_ = numRows;
+	numCols_ = numCols;
+	keyframeInterval_ = keyframeInterval;
+	encodeNanos_ = 0;
+	queuedBytes_ = 0;
+	index_.clear();
+	stats_ = {};
+	stats_.fileBytes = sizeof(header);
+	if (!writeBytes(fd, &header, sizeof(header)))
+	{
+		int error = errno;
+		close(fd);
+		fd_ = -1;
+		errno = error;
+		return false;
+	}
+
+	//	The first record goes through the queue like the others
+	recording_ = true;
+	addRecord(generation, true, &first, 1);
+	writer_ = std::jthread([this](std::stop_token stop) {
+		writeRecords(stop);
+	});
+	return true;
+}
+
+
+bool Recorder::stop(void)
+{
+	if (!recording_)
+		return true;
+
+	writer_.request_stop();
+	writer_.join();
+	recording_ = false;
+
+	//	the writer is gone: no need for the lock any more
+	int error = stats_.lastError;
+	if (error == 0)
+	{
+		RecordHeader header = {};
+		header.type = RECORD_INDEX;
+		header.generation = stats_.lastGeneration;
+		header.size = index_.size() * sizeof(KeyframeEntry);
+		RecordingTrailer trailer = {};
+		trailer.indexOffset = stats_.fileBytes;
+		memcpy(trailer.magic, INDEX_MAGIC, sizeof(trailer.magic));
+
+		if (!writeBytes(fd_, &header, sizeof(header)) || !writeBytes(fd_, index_.data(), header.size) ||
+			!writeBytes(fd_, &trailer, sizeof(trailer)) || fsync(fd_) != 0)
+			error = errno;
+		else
+			stats_.fileBytes += sizeof(header) + header.size + sizeof(trailer);
+	}
+	if (close(fd_) != 0 && error == 0)
+		error = errno;
+	fd_ = -1;
+	stats_.lastError = error;
+	spare_.clear();
+
+	errno = error;
+	return error == 0;
+}
+
+
+bool Recorder::isRecording(void) const
+{
+	return recording_;
+}
+
+
+unsigned long Recorder::keyframeInterval(void) const
+{
+	return keyframeInterval_;
+}
+
+
+bool Recorder::wantsKeyframe(unsigned long generation) const
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	return recording_ && (!chained_ || stats_.lastGeneration + 1 != generation || generation % keyframeInterval_ == 0);
+}
+
+
+bool Recorder::addRecord(unsigned long generation, bool keyframe, const RecordChunk* chunks, unsigned int numChunks)
+{
+	size_t size = sizeof(RecordHeader);
+	for (unsigned int k = 0; k < numChunks; k++)
+		size += chunks[k].bytes.size();
+
+	std::unique_lock<std::mutex> lock(lock_);
+	bool dropped = stats_.lastError != 0 || (stats_.numRecords > 0 && generation <= stats_.lastGeneration);
+	if (!dropped && queuedBytes_ > MAX_QUEUED_BYTES)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		written_.wait(lock, [this] {
+			return queuedBytes_ <= MAX_QUEUED_BYTES || stats_.lastError != 0;
+		});
+		stats_.stallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		dropped = stats_.lastError != 0;
+	}
+	chained_ = !dropped;
+	if (dropped)
+		return false;
+
+	Record record = {generation, keyframe, {}};
+	if (!spare_.empty())
+	{
+		record.bytes.swap(spare_.back());
+		spare_.pop_back();
+	}
+	queuedBytes_ += size;
+	stats_.numRecords++;
+	stats_.numKeyframes += keyframe ? 1 : 0;
+	stats_.lastGeneration = generation;
+	stats_.rawBytes += (uint64_t) numRows_ * numCols_;
+	lock.unlock();
+
+	//	The chunks are copied without the lock, which the writer needs
+	RecordHeader header = {};
+	header.type = keyframe ? RECORD_KEYFRAME : RECORD_DELTA;
+	header.generation = generation;
+	header.size = size - sizeof(header);
+	record.bytes.resize(sizeof(header));
+	memcpy(record.bytes.data(), &header, sizeof(header));
+	for (unsigned int k = 0; k < numChunks; k++)
+		record.bytes.insert(record.bytes.end(), chunks[k].bytes.begin(), chunks[k].bytes.end());
+
+	lock.lock();
+	queue_.push_back(std::move(record));
+	queued_.notify_one();
+	return true;
+}
+
+
+void Recorder::addEncodeTime(unsigned long nanoseconds)
+{
+	encodeNanos_.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+
+void Recorder::stats(RecorderStats* stats) const
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	*stats = stats_;
+	stats->recording = recording_;
+	stats->encodeTime = encodeNanos_ * 1e-9;
+}
+
+
+//	The writer thread: writes the queued records in order, until a stop is
+//	requested and the queue is empty.  After a failed write, the records
+//	are dropped.
+void Recorder::writeRecords(std::stop_token stop)
+{
+	std::unique_lock<std::mutex> lock(lock_);
+	while (true)
+	{
+		queued_.wait(lock, stop, [this] {
+			return !queue_.empty();
+		});
+		if (queue_.empty())
+			return;
+
+		//	(a reference to the front of a deque survives push_back())
+		Record& record = queue_.front();
+		bool failed = stats_.lastError != 0;
+		lock.unlock();
+		bool written = !failed && writeBytes(fd_, record.bytes.data(), record.bytes.size());
+		int error = errno;
+		lock.lock();
+
+		if (written)
+		{
+			if (record.keyframe)
+				index_.push_back({record.generation, stats_.fileBytes});
+			stats_.fileBytes += record.bytes.size();
+		}
+		else if (!failed)
+			stats_.lastError = error;
+		queuedBytes_ -= record.bytes.size();
+		if (spare_.size() < MAX_SPARE_BUFFERS)
+			spare_.push_back(std::move(record.bytes));
+		queue_.pop_front();
+		written_.notify_all();
+	}
+}
+
+
+Player::Player(void)
+	:	fd_(-1),
+		fileSize_(0),
+		header_{},
+		lastGeneration_(0),
+		position_(0),
+		generation_(0)
+{
+}
+
+
+Player::~Player(void)
+{
+	close();
+}
+
+
+bool Player::open(const char* path)
+{
+	close();
+	fd_ = ::open(path, O_RDONLY);
+	if (fd_ < 0)
+		return false;
+
+	off_t fileSize = lseek(fd_, 0, SEEK_END);
+	fileSize_ = fileSize > 0 ? fileSize : 0;
+	bool valid = readBytes(fd_, &header_, sizeof(header_), 0) &&
+				 memcmp(header_.magic, RECORDING_MAGIC, sizeof(header_.magic)) == 0 &&
+				 header_.byteOrder == BYTE_ORDER_MARK &&
+				 header_.version == RECORDING_VERSION &&
+				 header_.numRows > 0 && header_.numCols > 0 &&
+				 (readIndex() || rebuildIndex());
+	if (!valid)
+	{
+		close();
+		errno = EINVAL;
+		return false;
+	}
+	return true;
+}
+
+
+void Player::close(void)
+{
+	if (fd_ >= 0)
+		::close(fd_);
+	fd_ = -1;
+	index_.clear();
+	position_ = 0;
+	buffer_.clear();
+}
+
+
+unsigned int Player::numRows(void) const
+{
+	return header_.numRows;
+}
+
+
+unsigned int Player::numCols(void) const
+{
+	return header_.numCols;
+}
+
+
+unsigned long Player::firstGeneration(void) const
+{
+	return index_.empty() ? 0 : index_.front().generation;
+}
+
+
+unsigned long Player::lastGeneration(void) const
+{
+	return lastGeneration_;
+}
+
+
+bool Player::seek(unsigned long generation, uint8_t* cells)
+{
+	position_ = 0;
+	if (fd_ < 0 || generation < firstGeneration() || generation > lastGeneration_)
+	{
+		errno = ERANGE;
+		return false;
+	}
+
+	//	last keyframe at or before generation
+	std::vector<KeyframeEntry>::const_iterator keyframe =
+		std::upper_bound(index_.begin(), index_.end(), generation,
+						 [](unsigned long gen, const KeyframeEntry& entry) { return gen < entry.generation; });
+	uint64_t offset = (keyframe - 1)->offset;
+
+	RecordHeader header;
+	do
+	{
+		if (!readRecord(offset, &header))
+			return false;
+		if (header.generation > generation)
+		{
+			errno = ERANGE;
+			return false;
+		}
+		if (!applyRecord(header, cells))
+			return false;
+		offset += sizeof(header) + header.size;
+	}
+	while (header.generation < generation);
+
+	position_ = offset;
+	generation_ = generation;
+	return true;
+}
+
+
+bool Player::next(uint8_t* cells)
+{
+	if (position_ == 0)
+	{
+		errno = EINVAL;
+		return false;
+	}
+	if (generation_ >= lastGeneration_)
+	{
+		errno = ERANGE;
+		return false;
+	}
+
+	RecordHeader header;
+	if (!readRecord(position_, &header) || !applyRecord(header, cells))
+	{
+		position_ = 0;
+		return false;
+	}
+	position_ += sizeof(header) + header.size;
+	generation_ = header.generation;
+	return true;
+}
+
+
+unsigned long Player::generation(void) const
+{
+	return generation_;
+}
+
+
+//	Reads the header of the keyframe or difference at offset, and its
+//	chunks into buffer_
+bool Player::readRecord(uint64_t offset, RecordHeader* header)
+{
+	bool valid = offset + sizeof(*header) <= fileSize_ && readBytes(fd_, header, sizeof(*header), offset) &&
+				 (header->type == RECORD_KEYFRAME || header->type == RECORD_DELTA) &&
+				 header->size <= fileSize_ - offset - sizeof(*header);
+	if (!valid)
+	{
+		errno = EINVAL;
+		return false;
+	}
+	buffer_.resize(header->size);
+	return readBytes(fd_, buffer_.data(), header->size, offset + sizeof(*header));
+}
+
+
+bool Player::applyRecord(const RecordHeader& header, uint8_t* cells) const
+{
+	if (!decodeRecordChunks(buffer_.data(), buffer_.size(), header.type == RECORD_KEYFRAME, cells,
+							header_.numRows, header_.numCols))
+	{
+		errno = EINVAL;
+		return false;
+	}
+	return true;
+}
+
+
+//	The index written at the end of a recording that was closed
+bool Player::readIndex(void)
+{
+	RecordingTrailer trailer;
+	RecordHeader header;
+	if (fileSize_ < sizeof(header_) + sizeof(header) + sizeof(trailer) ||
+		!readBytes(fd_, &trailer, sizeof(trailer), fileSize_ - sizeof(trailer)) ||
+		memcmp(trailer.magic, INDEX_MAGIC, sizeof(trailer.magic)) != 0 ||
+		trailer.indexOffset < sizeof(header_) || trailer.indexOffset > fileSize_ - sizeof(header) - sizeof(trailer) ||
+		!readBytes(fd_, &header, sizeof(header), trailer.indexOffset) ||
+		header.type != RECORD_INDEX || header.size % sizeof(KeyframeEntry) != 0 ||
+		header.size != fileSize_ - trailer.indexOffset - sizeof(header) - sizeof(trailer))
+		return false;
+
+	index_.resize(header.size / sizeof(KeyframeEntry));
+	if (index_.empty() || !readBytes(fd_, index_.data(), header.size, trailer.indexOffset + sizeof(header)))
+		return false;
+	for (size_t k = 0; k < index_.size(); k++)
+		if (index_[k].offset >= trailer.indexOffset || (k > 0 && (index_[k].generation <= index_[k-1].generation ||
+																   index_[k].offset <= index_[k-1].offset)))
+			return false;
+	lastGeneration_ = header.generation;
+	return lastGeneration_ >= index_.back().generation;
+}
+
+
+//	No index (the recording was not closed): the records that were written
+//	whole are walked to make one
+bool Player::rebuildIndex(void)
+{
+	index_.clear();
+	uint64_t offset = sizeof(header_);
+	RecordHeader header;
+	while (offset + sizeof(header) <= fileSize_ && readBytes(fd_, &header, sizeof(header), offset) &&
+		   (header.type == RECORD_KEYFRAME || header.type == RECORD_DELTA) &&
+		   header.size <= fileSize_ - offset - sizeof(header))
+	{
+		if (header.type == RECORD_KEYFRAME)
+			index_.push_back({header.generation, offset});
+		if (!index_.empty())
+			lastGeneration_ = header.generation;
+		offset += sizeof(header) + header.size;
+	}
+	return !index_.empty();
+}
+
+
+//	Word w (cells 8w to 8w+7) of rows of numCells cells, XORed with
+//	previous unless it is NULL.  The last word is padded with zeros.
+static inline uint64_t rowWord(const uint8_t* previous, const uint8_t* cells, size_t numCells, size_t w)
+{
+	uint64_t word = 0, before = 0;
+	size_t first = w * 8;
+	if (first + 8 <= numCells)
+	{
+		memcpy(&word, cells + first, 8);
+		if (previous != NULL)
+			memcpy(&before, previous + first, 8);
+	}
+	else
+	{
+		memcpy(&word, cells + first, numCells - first);
+		if (previous != NULL)
+			memcpy(&before, previous + first, numCells - first);
+	}
+	return word ^ before;
+}
+
+
+//	XORs word into word w of cells (a keyframe is decoded over zeros)
+static inline void storeWord(uint8_t* cells, size_t numCells, size_t w, uint64_t word)
+{
+	size_t first = w * 8;
+	size_t size = std::min<size_t>(8, numCells - first);
+	uint64_t current = 0;
+	memcpy(&current, cells + first, size);
+	current ^= word;
+	memcpy(cells + first, &current, size);
+}
+
+
+//	Packs the words of a whole group of cells that are not zero (XORed with
+//	previous unless it is NULL), sets their bits in mask, ORs them into
+//	high, and returns how many there are.  The words are made in a first
+//	loop, free of branches and of checks for the end of the rows (the bit
+//	of a word enters the mask from the top, and reaches bit i after the 64
+//	words); only those that are not zero, usually few, are then packed.
+static inline size_t packGroup(const uint8_t* previous, const uint8_t* cells, unsigned int bits, uint8_t* packed,
+							   uint64_t* mask, uint64_t* high)
+{
+	uint64_t words[GROUP_WORDS];
+	uint64_t nonzero = 0, any = 0;
+	if (previous != NULL)
+		for (size_t i = 0; i < GROUP_WORDS; i++)
+		{
+			uint64_t word, before;
+			memcpy(&word, cells + 8 * i, 8);
+			memcpy(&before, previous + 8 * i, 8);
+			words[i] = word ^ before;
+			any |= words[i];
+			nonzero = nonzero >> 1 | (words[i] | (0 - words[i])) >> 63 << 63;
+		}
+	else
+		for (size_t i = 0; i < GROUP_WORDS; i++)
+		{
+			memcpy(&words[i], cells + 8 * i, 8);
+			any |= words[i];
+			nonzero = nonzero >> 1 | (words[i] | (0 - words[i])) >> 63 << 63;
+		}
+
+	size_t count = 0;
+	for (uint64_t left = nonzero; left != 0; left &= left - 1)
+		packWord(words[__builtin_ctzll(left)], bits, packed, &count);
+	*mask = nonzero;
+	*high |= any;
+	return count;
+}
+
+
+//	Appends word to packed (where count words are) and counts it, unless it
+//	is zero: it is written anyway, to be overwritten by the next one (the
+//	words of the last group of a chunk go through here without a branch)
+static inline void packWord(uint64_t word, unsigned int bits, uint8_t* packed, size_t* count)
+{
+	if (bits == 1)
+		packed[*count] = packBits(word);
+	else
+	{
+		uint32_t nibbles = packNibbles(word);
+		memcpy(packed + 4 * *count, &nibbles, 4);
+	}
+	*count += word != 0;
+}
+
+
+//	The low bit of each byte, byte k in bit k (the multiplier moves bit 8k
+//	to bit 56+k, and all the other products land on distinct lower bits)
+static inline uint8_t packBits(uint64_t word)
+{
+	return (uint8_t) ((word & 0x0101010101010101ull) * 0x0102040810204080ull >> 56);
+}
+
+
+//	Bit k in byte k: copies of the byte in all bytes, one bit kept in each,
+//	then brought down to the low bit (adding 0x7f sets bit 7 of a byte iff
+//	it is not zero)
+static inline uint64_t unpackBits(uint8_t bits)
+{
+	uint64_t word = (bits * 0x0101010101010101ull) & 0x8040201008040201ull;
+	return ((word + 0x7f7f7f7f7f7f7f7full) & 0x8080808080808080ull) >> 7;
+}
+
+
+//	The low 4 bits of each byte, byte k in bits 4k to 4k+3
+static inline uint32_t packNibbles(uint64_t word)
+{
+	word &= 0x0f0f0f0f0f0f0f0full;
+	word = (word | word >> 4) & 0x00ff00ff00ff00ffull;
+	word = (word | word >> 8) & 0x0000ffff0000ffffull;
+	return (uint32_t) (word | word >> 16);
+}
+
+
+static inline uint64_t unpackNibbles(uint32_t nibbles)
+{
+	uint64_t word = nibbles;
+	word = (word | word << 16) & 0x0000ffff0000ffffull;
+	word = (word | word << 8) & 0x00ff00ff00ff00ffull;
+	return (word | word << 4) & 0x0f0f0f0f0f0f0f0full;
+}
+
+
+//	Where size bytes can be written after the first used bytes of chunk.
+//	The chunk grows by doubling, so that it is seldom resized (which fills
+//	what it adds with zeros).
+static inline uint8_t* chunkSpace(std::vector<uint8_t>* chunk, size_t used, size_t size)
+{
+	if (chunk->size() < used + size)
+		chunk->resize(std::max(used + size, 2 * chunk->size()));
+	return chunk->data() + used;
+}
+
+
+//	7 bits per byte, low bits first, the high bit set on all bytes but the
+//	last.  Returns the end of what was written.
+static inline uint8_t* putVarint(uint8_t* out, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		*out++ = (uint8_t) (value | 0x80);
+		value >>= 7;
+	}
+	*out++ = (uint8_t) value;
+	return out;
+}
+
+
+static bool readVarint(const uint8_t** p, const uint8_t* end, uint64_t* value)
+{
+	*value = 0;
+	for (unsigned int shift = 0; *p < end && shift < 64; shift += 7)
+	{
+		uint8_t byte = *(*p)++;
+		*value |= (uint64_t) (byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+
+//	Decodes the chunk at p (which ends before end) into cells, a board of
+//	numRows x numCols: copies its rows for a keyframe, XORs them in for a
+//	difference.  Returns the end of the chunk, or NULL if it is malformed.
+static const uint8_t* decodeChunk(const uint8_t* p, const uint8_t* end, bool keyframe, uint8_t* cells,
+								  unsigned int numRows, unsigned int numCols)
+{
+	uint64_t firstRow, rows, bits, size;
+	if (!readVarint(&p, end, &firstRow) || !readVarint(&p, end, &rows) || !readVarint(&p, end, &bits) ||
+		firstRow > numRows || rows > numRows - firstRow || (bits != 1 && bits != 4) ||
+		(size_t) (end - p) < sizeof(size))
+		return NULL;
+	memcpy(&size, p, sizeof(size));
+	p += sizeof(size);
+	if (size > (size_t) (end - p))
+		return NULL;
+	end = p + size;
+
+	uint8_t* out = cells + firstRow * numCols;
+	size_t numCells = rows * numCols;
+	size_t numWords = (numCells + 7) / 8;
+	size_t numGroups = (numWords + GROUP_WORDS - 1) / GROUP_WORDS;
+	size_t bytesPerWord = bits == 1 ? 1 : 4;
+	size_t g = 0;
+	while (g < numGroups)
+	{
+		uint64_t numEmpty, mask;
+		if (!readVarint(&p, end, &numEmpty) || numEmpty > numGroups - g)
+			return NULL;
+		if (keyframe)
+			memset(out + g * GROUP_WORDS * 8, 0, std::min(numEmpty * GROUP_WORDS * 8, numCells - g * GROUP_WORDS * 8));
+		g += numEmpty;
+		if (g == numGroups)
+			break;
+
+		size_t firstWord = g * GROUP_WORDS;
+		size_t groupWords = std::min(GROUP_WORDS, numWords - firstWord);
+		if ((size_t) (end - p) < sizeof(mask))
+			return NULL;
+		memcpy(&mask, p, sizeof(mask));
+		p += sizeof(mask);
+		if (mask == 0 || (groupWords < GROUP_WORDS && mask >> groupWords != 0) ||
+			__builtin_popcountll(mask) * bytesPerWord > (size_t) (end - p))
+			return NULL;
+
+		if (keyframe)
+			memset(out + firstWord * 8, 0, std::min(groupWords * 8, numCells - firstWord * 8));
+		for (; mask != 0; mask &= mask - 1)
+		{
+			uint64_t word;
+			if (bits == 1)
+				word = unpackBits(*p++);
+			else
+			{
+				uint32_t nibbles;
+				memcpy(&nibbles, p, 4);
+				p += 4;
+				word = unpackNibbles(nibbles);
+			}
+			storeWord(out, numCells, firstWord + __builtin_ctzll(mask), word);
+		}
+		g++;
+	}
+	return p == end ? p : NULL;
+}
+
+
+static bool writeBytes(int fd, const void* data, size_t size)
+{
+	const uint8_t* p = (const uint8_t*) data;
+	while (size > 0)
+	{
+		ssize_t written = write(fd, p, size);
+		if (written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		p += written;
+		size -= written;
+	}
+	return true;
+}
+
+
+//	pread() until everything is read.  A file that ends before is malformed
+//	(EINVAL).
+static bool readBytes(int fd, void* data, size_t size, uint64_t offset)
+{
+	uint8_t* p = (uint8_t*) data;
+	while (size > 0)
+	{
+		ssize_t numRead = pread(fd, p, size, offset);
+		if (numRead < 0 && errno == EINTR)
+			continue;
+		if (numRead <= 0)
+		{
+			if (numRead == 0)
+				errno = EINVAL;
+			return false;
+		}
+		p += numRead;
+		offset += numRead;
+		size -= numRead;
+	}
+	return true;
+}
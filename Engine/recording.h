@@ -0,0 +1,251 @@
+//
+//  recording.h
+//  Cellular Automaton
+//
+//	Recordings: every generation of a run, in a file small enough to keep,
+//	from which any generation can be brought back.  A generation is stored
+//	as its difference with the one before (the XOR of the two boards, zero
+//	wherever nothing changed), except for keyframes, which store the board
+//	itself: one every keyframe interval, and one after anything that breaks
+//	the chain of differences (an edit of the board, generations that were
+//	not recorded).  A player starts from the last keyframe before the
+//	generation it looks for, found in the index of keyframes that closes
+//	the file, rather than from the beginning.
+//
+//	Keyframes and differences go through the same codec, by chunks of rows.
+//	The rows are cut into 8-cell words, and the words into groups of 64: a
+//	group is stored as a mask of its words that are not zero, followed by
+//	these words, and runs of groups that are all zero are only counted.
+//	Words are stored 1 bit per cell when no cell of the chunk is above 1
+//	(there are only dead and live cells out of color mode), 4 bits per cell
+//	otherwise.  The compute threads encode the rows they just computed while
+//	they are still in their caches; a thread of the Recorder writes them
+//	out.
+//
+//	File layout (numbers in the byte order of the machine that wrote it):
+//
+//		RecordingHeader
+//		a record per generation: a RecordHeader, then its chunks:
+//			varint first row, varint number of rows, varint bits per cell,
+//			uint64_t number of bytes, then for each group that is not zero:
+//			varint number of zero groups before it, uint64_t mask (bit i
+//			for word i), the words of the mask (8 or 32 bits each), and at
+//			the end, varint number of zero groups after the last one
+//		the index: a RecordHeader of type RECORD_INDEX (whose generation is
+//			the last one recorded), then a KeyframeEntry per keyframe
+//		RecordingTrailer
+//
+//	A recording that was not closed (the program died) has no index: the
+//	player then rebuilds it by walking the records.
+//
+
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+//	Default number of generations between two keyframes
+const unsigned long DEFAULT_KEYFRAME_INTERVAL = 256;
+
+typedef struct RecordingHeader {
+	char magic[8];					//	"CELLRECD"
+	uint32_t byteOrder;				//	0x01020304, as written by this machine
+	uint32_t version;
+	uint32_t numRows, numCols;
+	uint64_t keyframeInterval;
+} RecordingHeader;
+
+typedef enum RecordType {
+	RECORD_KEYFRAME = 1,
+	RECORD_DELTA,
+	RECORD_INDEX
+} RecordType;
+
+typedef struct RecordHeader {
+	uint32_t type;
+	uint32_t reserved;
+	uint64_t generation;
+	uint64_t size;					//	bytes that follow this header
+} RecordHeader;
+
+typedef struct KeyframeEntry {
+	uint64_t generation;
+	uint64_t offset;				//	of its RecordHeader in the file
+} KeyframeEntry;
+
+typedef struct RecordingTrailer {
+	uint64_t indexOffset;			//	of the RecordHeader of the index
+	char magic[8];					//	"CELLINDX"
+} RecordingTrailer;
+
+//	Rows encoded by one band of compute threads, padded to a cache line so
+//	that two bands never share one
+typedef struct alignas(64) RecordChunk {
+	std::vector<uint8_t> bytes;
+} RecordChunk;
+
+//	Appends to chunk the encoding of rows [firstRow, firstRow+numRows) of a
+//	board numCols wide: the rows of cells for a keyframe (previous is NULL),
+//	their XOR with the same rows of previous otherwise.
+void encodeRecordRows(const uint8_t* previous, const uint8_t* cells, unsigned int firstRow,
+					  unsigned int numRows, unsigned int numCols, std::vector<uint8_t>* chunk);
+
+//	Decodes the chunks of a record (size bytes at bytes) into cells, a board
+//	of numRows x numCols: copies their rows for a keyframe, XORs them in for
+//	a difference.  Returns false if they are malformed.
+bool decodeRecordChunks(const uint8_t* bytes, size_t size, bool keyframe, uint8_t* cells,
+						unsigned int numRows, unsigned int numCols);
+
+typedef struct RecorderStats {
+	bool recording;
+	unsigned long numRecords;		//	generations recorded
+	unsigned long numKeyframes;
+	unsigned long lastGeneration;
+	uint64_t rawBytes;				//	size of the boards recorded
+	uint64_t fileBytes;				//	written so far
+	//	time the compute threads spent encoding, all threads together, and
+	//	that they waited for the writer to catch up, in seconds
+	double encodeTime, stallTime;
+	int lastError;					//	errno of the write that stopped the recording (0: none)
+} RecorderStats;
+
+class Recorder
+{
+	public:
+
+		Recorder(void);
+
+		//	Closes the recording, if any
+		~Recorder(void);
+
+		Recorder(const Recorder&) = delete;
+		Recorder& operator =(const Recorder&) = delete;
+
+		//	Creates a recording at path, whose first record is a keyframe of
+		//	cells, a board of numRows x numCols at generation.  Returns false,
+		//	with errno set, on failure.
+		bool start(const char* path, const uint8_t* cells, unsigned int numRows, unsigned int numCols,
+				   unsigned long generation, unsigned long keyframeInterval);
+
+		//	Writes out the records still queued and the index, and closes the
+		//	file.  Returns false, with errno set, if the recording was not
+		//	written whole.
+		bool stop(void);
+
+		bool isRecording(void) const;
+		unsigned long keyframeInterval(void) const;
+
+		//	Whether the record of generation must be a keyframe (while
+		//	recording): at the keyframe interval, or if the last record is
+		//	not of the generation before (or was dropped)
+		bool wantsKeyframe(unsigned long generation) const;
+
+		//	Queues the record of generation, made of the bytes of chunks[0]
+		//	to chunks[numChunks-1].  Waits for the writer if too much is
+		//	already queued.  Generations must only go up: the record of one
+		//	that does not (the board was taken back to an earlier generation)
+		//	is dropped, as are all records after a write failed.  Returns
+		//	false if the record was dropped.
+		bool addRecord(unsigned long generation, bool keyframe, const RecordChunk* chunks, unsigned int numChunks);
+
+		//	Adds to the time spent encoding (any thread)
+		void addEncodeTime(unsigned long nanoseconds);
+
+		void stats(RecorderStats* stats) const;
+
+	private:
+
+		typedef struct Record {
+			unsigned long generation;
+			bool keyframe;
+			std::vector<uint8_t> bytes;
+		} Record;
+
+		void writeRecords(std::stop_token stop);
+		bool writeRecord(const Record& record);
+
+		int fd_;
+		unsigned int numRows_, numCols_;
+		std::atomic<bool> recording_;
+		std::atomic<unsigned long> keyframeInterval_;
+		std::atomic<unsigned long> encodeNanos_;
+
+		//	guards everything below
+		mutable std::mutex lock_;
+		std::condition_variable_any queued_, written_;
+		std::deque<Record> queue_;
+		size_t queuedBytes_;
+		//	the last record added was not dropped
+		bool chained_;
+		//	buffers of written records, reused for the next ones
+		std::vector<std::vector<uint8_t>> spare_;
+		std::vector<KeyframeEntry> index_;
+		RecorderStats stats_;
+
+		std::jthread writer_;
+};
+
+class Player
+{
+	public:
+
+		Player(void);
+		~Player(void);
+
+		Player(const Player&) = delete;
+		Player& operator =(const Player&) = delete;
+
+		//	Returns false, with errno set (EINVAL if the file is not a
+		//	recording), on failure
+		bool open(const char* path);
+		void close(void);
+
+		unsigned int numRows(void) const;
+		unsigned int numCols(void) const;
+
+		//	First and last generations recorded.  Generations in between may
+		//	be missing (when the engine ran a strategy that is not recorded).
+		unsigned long firstGeneration(void) const;
+		unsigned long lastGeneration(void) const;
+
+		//	Writes the board of generation into cells (numRows x numCols
+		//	cells): decodes the last keyframe before it, then the differences
+		//	that lead to it.  Returns false, with errno set (ERANGE if the
+		//	generation was not recorded), on failure.
+		bool seek(unsigned long generation, uint8_t* cells);
+
+		//	Moves cells, as left by the last seek() or next(), to the next
+		//	generation recorded.  Returns false, with errno set (ERANGE at
+		//	the end of the recording), on failure.
+		bool next(uint8_t* cells);
+
+		//	Of the board left by the last seek() or next()
+		unsigned long generation(void) const;
+
+	private:
+
+		bool readRecord(uint64_t offset, RecordHeader* header);
+		bool applyRecord(const RecordHeader& header, uint8_t* cells) const;
+		bool readIndex(void);
+		bool rebuildIndex(void);
+
+		int fd_;
+		uint64_t fileSize_;
+		RecordingHeader header_;
+		std::vector<KeyframeEntry> index_;
+		unsigned long lastGeneration_;
+
+		//	the record after the current board (0: no current board)
+		uint64_t position_;
+		unsigned long generation_;
+		std::vector<uint8_t> buffer_;
+};
+
+#endif	//	RECORDING_H
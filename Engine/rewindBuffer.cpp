@@ -0,0 +1,221 @@
+//
+//  rewindBuffer.cpp
+//  Cellular Automaton
+//
+
+#include <algorithm>
+#include <cerrno>
+//
+#include "rewindBuffer.h"
+
+
+RewindBuffer::RewindBuffer(void)
+	:	maxGenerations_(0),
+		maxBytes_(DEFAULT_REWIND_BYTES),
+		numKeyframes_(0),
+		bytes_(0),
+		spanBytes_(0)
+{
+}
+
+
+void RewindBuffer::configure(unsigned long numGenerations, size_t maxBytes)
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	maxGenerations_ = numGenerations;
+	maxBytes_ = maxBytes;
+	if (maxGenerations_ == 0)
+		clearEntries();
+	else
+		trim();
+}
+
+
+bool RewindBuffer::isEnabled(void) const
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	return maxGenerations_ != 0;
+}
+
+
+bool RewindBuffer::wantsKeyframe(unsigned long generation) const
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	return maxGenerations_ != 0 && (generation == 0 || find(generation - 1) == entries_.size() ||
+									generation % REWIND_KEYFRAME_INTERVAL == 0 ||
+									spanBytes_ > maxBytes_ / REWIND_SPANS);
+}
+
+
+void RewindBuffer::add(unsigned long generation, bool keyframe, const RecordChunk* chunks, unsigned int numChunks)
+{
+	size_t size = 0;
+	for (unsigned int k = 0; k < numChunks; k++)
+		size += chunks[k].bytes.size();
+
+	std::lock_guard<std::mutex> lock(lock_);
+	if (maxGenerations_ == 0)
+		return;
+
+	//	A new history starts from the generation before
+	if (!entries_.empty() && entries_.back().generation >= generation)
+	{
+		while (!entries_.empty() && entries_.back().generation >= generation)
+		{
+			bytes_ -= entries_.back().bytes.capacity() + sizeof(Entry);
+			numKeyframes_ -= entries_.back().keyframe ? 1 : 0;
+			entries_.pop_back();
+		}
+		spanBytes_ = 0;
+		for (size_t k = entries_.size(); k > 0; k--)
+		{
+			spanBytes_ += entries_[k - 1].bytes.capacity() + sizeof(Entry);
+			if (entries_[k - 1].keyframe)
+				break;
+		}
+	}
+	if (!keyframe && (entries_.empty() || entries_.back().generation + 1 != generation))
+		return;
+	if (size + sizeof(Entry) > maxBytes_)
+	{
+		clearEntries();
+		return;
+	}
+
+	Entry entry = {generation, keyframe, {}};
+	entry.bytes.reserve(size);
+	for (unsigned int k = 0; k < numChunks; k++)
+		entry.bytes.insert(entry.bytes.end(), chunks[k].bytes.begin(), chunks[k].bytes.end());
+	size_t entryBytes = entry.bytes.capacity() + sizeof(Entry);
+	bytes_ += entryBytes;
+	spanBytes_ = keyframe ? entryBytes : spanBytes_ + entryBytes;
+	numKeyframes_ += keyframe ? 1 : 0;
+	entries_.push_back(std::move(entry));
+	trim();
+}
+
+
+bool RewindBuffer::nearest(unsigned long generation, bool earlier, unsigned long* held) const
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	if (entries_.empty())
+		return false;
+
+	//	first one at or after generation
+	size_t after = std::lower_bound(entries_.begin(), entries_.end(), generation,
+									[](const Entry& entry, unsigned long gen) { return entry.generation < gen; }) -
+				   entries_.begin();
+	bool exact = after < entries_.size() && entries_[after].generation == generation;
+	size_t k;
+	if (exact)
+		k = after;
+	else if (earlier)
+		k = after > 0 ? after - 1 : after;
+	else
+		k = after < entries_.size() ? after : after - 1;
+	*held = entries_[k].generation;
+	return true;
+}
+
+
+bool RewindBuffer::decode(unsigned long generation, uint8_t* cells, unsigned int numRows,
+						  unsigned int numCols) const
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	size_t last = find(generation);
+	if (last == entries_.size())
+	{
+		errno = ERANGE;
+		return false;
+	}
+
+	//	from the keyframe before it (the first entry is one)
+	size_t first = last;
+	while (!entries_[first].keyframe)
+		first--;
+	for (size_t k = first; k <= last; k++)
+		if (!decodeRecordChunks(entries_[k].bytes.data(), entries_[k].bytes.size(), entries_[k].keyframe, cells,
+								numRows, numCols))
+		{
+			errno = EINVAL;
+			return false;
+		}
+	return true;
+}
+
+
+void RewindBuffer::clear(void)
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	clearEntries();
+}
+
+
+void RewindBuffer::stats(RewindStats* stats) const
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	*stats = {};
+	stats->maxGenerations = maxGenerations_;
+	stats->maxBytes = maxBytes_;
+	stats->numGenerations = entries_.size();
+	stats->numKeyframes = numKeyframes_;
+	if (!entries_.empty())
+	{
+		stats->firstGeneration = entries_.front().generation;
+		stats->lastGeneration = entries_.back().generation;
+	}
+	stats->bytes = bytes_;
+}
+
+
+//	Index of the entry of generation, or the number of entries if none
+size_t RewindBuffer::find(unsigned long generation) const
+{
+	std::deque<Entry>::const_iterator entry =
+		std::lower_bound(entries_.begin(), entries_.end(), generation,
+						 [](const Entry& e, unsigned long gen) { return e.generation < gen; });
+	return entry != entries_.end() && entry->generation == generation ? entry - entries_.begin() : entries_.size();
+}
+
+
+//	Drops the oldest keyframes, with their differences, while the buffer is
+//	over its bytes, or would still hold enough generations without them.
+//	The last keyframe is only dropped, with everything, if it alone is over
+//	the bytes.
+void RewindBuffer::trim(void)
+{
+	while (!entries_.empty())
+	{
+		size_t span = 1;
+		while (span < entries_.size() && !entries_[span].keyframe)
+			span++;
+		bool overBytes = bytes_ > maxBytes_;
+		if (!overBytes && entries_.size() - span < maxGenerations_)
+			return;
+		if (span == entries_.size())
+		{
+			if (overBytes)
+				clearEntries();
+			return;
+		}
+		for (size_t k = 0; k < span; k++)
+			dropFront();
+	}
+}
+
+
+void RewindBuffer::dropFront(void)
+{
+	bytes_ -= entries_.front().bytes.capacity() + sizeof(Entry);
+	numKeyframes_ -= entries_.front().keyframe ? 1 : 0;
+	entries_.pop_front();
+}
+
+
+void RewindBuffer::clearEntries(void)
+{
+	entries_.clear();
+	numKeyframes_ = 0;
+	bytes_ = 0;
+	spanBytes_ = 0;
+}
@@ -0,0 +1,115 @@
+//
+//  rewindBuffer.h
+//  Cellular Automaton
+//
+//	The last generations computed, kept in memory so that the board can be
+//	taken back to any of them once something interesting has gone by.  They
+//	are kept as the records of a recording (see recording.h), which the
+//	compute threads encode anyway: a keyframe every REWIND_KEYFRAME_INTERVAL
+//	generations, and the differences with the generation before in between,
+//	so that bringing back a generation decodes a bounded number of records.
+//
+//	The buffer has two bounds: a number of generations, and bytes.  It
+//	keeps at least the number of generations asked for, and drops its oldest
+//	keyframe with the differences that follow it when it has more than
+//	that, or when it is over its bytes.  A keyframe is also started when
+//	the records since the last one take more than 1/REWIND_SPANS of the
+//	bytes, so that a drop never loses more than that.  A record that would
+//	not fit at all (a board too large for the bytes) empties the buffer.
+//
+
+#ifndef REWIND_BUFFER_H
+#define REWIND_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+//
+#include "recording.h"
+
+//	Bytes a buffer may use unless told otherwise
+const size_t DEFAULT_REWIND_BYTES = (size_t) 256 << 20;
+
+//	Generations between two keyframes (at most)
+const unsigned long REWIND_KEYFRAME_INTERVAL = 32;
+
+//	Fraction of the bytes that the records since the last keyframe may take
+const size_t REWIND_SPANS = 8;
+
+typedef struct RewindStats {
+	unsigned long maxGenerations;	//	asked for (0: no rewinding)
+	size_t maxBytes;
+	unsigned long numGenerations;	//	held
+	unsigned long numKeyframes;
+	unsigned long firstGeneration, lastGeneration;
+	size_t bytes;					//	taken by the records held
+} RewindStats;
+
+class RewindBuffer
+{
+	public:
+
+		RewindBuffer(void);
+
+		RewindBuffer(const RewindBuffer&) = delete;
+		RewindBuffer& operator =(const RewindBuffer&) = delete;
+
+		//	Keeps the last numGenerations generations (0: none), in at most
+		//	maxBytes.  The generations held that are over the new bounds are
+		//	dropped.
+		void configure(unsigned long numGenerations, size_t maxBytes);
+
+		bool isEnabled(void) const;
+
+		//	Whether the record of generation must be a keyframe: the
+		//	generation before is not held, at the keyframe interval, or when
+		//	the records since the last keyframe take too many bytes
+		bool wantsKeyframe(unsigned long generation) const;
+
+		//	Adds the record of generation, made of the bytes of chunks[0] to
+		//	chunks[numChunks-1].  The generations held from generation on
+		//	(the board was taken back) are dropped first.  A difference that
+		//	does not follow a generation held is ignored.
+		void add(unsigned long generation, bool keyframe, const RecordChunk* chunks, unsigned int numChunks);
+
+		//	Generation held closest to generation: the last one at or before
+		//	it (earlier), or the first one at or after it, or failing that,
+		//	the closest one the other way.  Returns false if none is held.
+		bool nearest(unsigned long generation, bool earlier, unsigned long* held) const;
+
+		//	Writes the board of generation into cells (numRows x numCols
+		//	cells).  Returns false, with errno set (ERANGE if the generation
+		//	is not held), on failure.
+		bool decode(unsigned long generation, uint8_t* cells, unsigned int numRows, unsigned int numCols) const;
+
+		void clear(void);
+		void stats(RewindStats* stats) const;
+
+	private:
+
+		typedef struct Entry {
+			unsigned long generation;
+			bool keyframe;
+			std::vector<uint8_t> bytes;
+		} Entry;
+
+		size_t find(unsigned long generation) const;
+		void trim(void);
+		void dropFront(void);
+		void clearEntries(void);
+
+		//	guards everything below
+		mutable std::mutex lock_;
+		unsigned long maxGenerations_;
+		size_t maxBytes_;
+		//	in order of generation, the first one a keyframe
+		std::deque<Entry> entries_;
+		unsigned long numKeyframes_;
+		size_t bytes_;
+		//	taken by the last keyframe and the records after it
+		size_t spanBytes_;
+};
+
+#endif	//	REWIND_BUFFER_H
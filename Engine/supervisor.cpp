@@ -0,0 +1,356 @@
+//
+//  supervisor.cpp
+//  Cellular Automaton
+//
+
+#include <algorithm>
+#include <chrono>
+//
+#include "supervisor.h"
+
+//	Cells computed in a phase, per thread of the pool.  Bigger phases make
+//	for fewer barriers, smaller ones for fairer schedules and shorter waits
+//	for the commands.
+const double PHASE_CELLS_PER_THREAD = 262144.;
+
+//	Smallest band worth handing to a thread of its own
+const double MIN_BAND_CELLS = 65536.;
+
+
+Supervisor::Supervisor(unsigned int numThreads)
+	:	nextIndex_(1),
+		actionsQueued_(0),
+		actionsDone_(0),
+		nextJob_(0)
+{
+	startPool(std::clamp(numThreads, 1u, MAX_NUM_THREADS));
+}
+
+
+Supervisor::~Supervisor(void)
+{
+	std::lock_guard<std::mutex> control(controlLock_);
+	pool_.stop();
+}
+
+
+unsigned int Supervisor::addBoard(unsigned int numCols, unsigned int numRows)
+{
+	unsigned int index = 0;
+	betweenPhases([&]() {
+		index = nextIndex_++;
+		boards_[index] = std::make_unique<Board>(Board{
+			std::make_unique<CellEngine>(numCols, numRows), false, 0, 1., 0., 0.});
+	});
+	return index;
+}
+
+
+bool Supervisor::removeBoard(unsigned int index)
+{
+	bool found = false;
+	betweenPhases([&]() {
+		found = boards_.erase(index) != 0;
+	});
+	return found;
+}
+
+
+bool Supervisor::run(unsigned int index)
+{
+	bool found = false;
+	betweenPhases([&]() {
+		auto board = boards_.find(index);
+		if (board == boards_.end())
+			return;
+		found = true;
+		Board& b = *board->second;
+		b.stopAtGeneration = 0;
+		if (!b.running)
+		{
+			//	no catching up on the time spent paused
+			b.virtualTime = std::max(b.virtualTime, leastVirtualTime());
+			b.running = true;
+		}
+	});
+	return found;
+}
+
+
+bool Supervisor::pause(unsigned int index)
+{
+	bool found = false;
+	betweenPhases([&]() {
+		auto board = boards_.find(index);
+		if (board == boards_.end())
+			return;
+		found = true;
+		board->second->running = false;
+		board->second->stopAtGeneration = 0;
+	});
+	return found;
+}
+
+
+bool Supervisor::step(unsigned int index, unsigned long numGenerations)
+{
+	bool found = false;
+	betweenPhases([&]() {
+		auto board = boards_.find(index);
+		if (board == boards_.end())
+			return;
+		found = true;
+		Board& b = *board->second;
+		b.running = numGenerations > 0;
+		b.stopAtGeneration = b.running ? b.engine->generation() + numGenerations : 0;
+		b.virtualTime = std::max(b.virtualTime, leastVirtualTime());
+	});
+	if (!found)
+		return false;
+
+	//	The step is over when it completes, is cut short by run() or pause(),
+	//	or the board goes away
+	std::unique_lock<std::mutex> lock(lock_);
+	actionsRun_.wait(lock, [&]() {
+		auto board = boards_.find(index);
+		return board == boards_.end() || board->second->stopAtGeneration == 0;
+	});
+	return true;
+}
+
+
+bool Supervisor::setShare(unsigned int index, double share)
+{
+	bool found = false;
+	betweenPhases([&]() {
+		auto board = boards_.find(index);
+		if (board == boards_.end())
+			return;
+		found = true;
+		board->second->share = share;
+	});
+	return found;
+}
+
+
+bool Supervisor::withEngine(unsigned int index, const std::function<void(CellEngine*)>& action)
+{
+	bool found = false;
+	betweenPhases([&]() {
+		auto board = boards_.find(index);
+		if (board == boards_.end())
+			return;
+		found = true;
+		action(board->second->engine.get());
+	});
+	return found;
+}
+
+
+//	Reads what the phase-end step writes under the lock, and atomic values
+//	of the engine: no need to wait for the end of the phase
+bool Supervisor::boardInfo(unsigned int index, BoardInfo* info)
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	auto board = boards_.find(index);
+	if (board == boards_.end())
+		return false;
+
+	const Board& b = *board->second;
+	info->numRows = b.engine->numRows();
+	info->numCols = b.engine->numCols();
+	info->generation = b.engine->generation();
+	info->running = b.running;
+	info->share = b.share;
+	info->cellUpdates = b.cellUpdates;
+	return true;
+}
+
+
+std::vector<unsigned int> Supervisor::boardIndexes(void)
+{
+	std::lock_guard<std::mutex> lock(lock_);
+	std::vector<unsigned int> indexes;
+	for (const auto& board : boards_)
+		indexes.push_back(board.first);
+	return indexes;
+}
+
+
+void Supervisor::setNumThreads(unsigned int numThreads)
+{
+	std::lock_guard<std::mutex> control(controlLock_);
+	numThreads = std::clamp(numThreads, 1u, MAX_NUM_THREADS);
+	if (numThreads != pool_.size())
+		startPool(numThreads);
+}
+
+
+unsigned int Supervisor::numThreads(void) const
+{
+	std::lock_guard<std::mutex> control(controlLock_);
+	return pool_.size();
+}
+
+
+//	The first phase has nothing to compute: its end picks the boards of
+//	the second one
+void Supervisor::startPool(unsigned int numThreads)
+{
+	pool_.start(numThreads,
+				[this](unsigned int index, unsigned int count, std::stop_token stop) {
+					(void) index;
+					(void) count;
+					computeJobs(stop);
+				},
+				[this](bool completed) {
+					return endOfPhase(completed);
+				});
+}
+
+
+//	Queues action for the end of the phase in flight, and waits until it
+//	has run
+void Supervisor::betweenPhases(const std::function<void(void)>& action)
+{
+	std::unique_lock<std::mutex> lock(lock_);
+	actions_.push_back(action);
+	uint64_t ticket = ++actionsQueued_;
+	actionQueued_.notify_one();
+	actionsRun_.wait(lock, [&]() {
+		return actionsDone_ >= ticket;
+	});
+}
+
+
+void Supervisor::computeJobs(std::stop_token stop)
+{
+	for (size_t k = nextJob_++; k < jobs_.size() && !stop.stop_requested(); k = nextJob_++)
+		jobs_[k].engine->computeHostedBand(jobs_[k].band, jobs_[k].count, stop);
+}
+
+
+//	Called by the last worker to reach the barrier, while all the others
+//	are blocked: nobody computes any board until it returns.  Waits there
+//	while there is nothing to compute.
+bool Supervisor::endOfPhase(bool completed)
+{
+	std::unique_lock<std::mutex> lock(lock_);
+
+	for (Board* board : phaseBoards_)
+	{
+		board->engine->endHostedGeneration(completed);
+		if (!completed)
+			continue;
+
+		double cells = (double) board->engine->numRows() * board->engine->numCols();
+		board->cellUpdates += cells;
+		board->virtualTime += cells / board->share;
+		if (board->stopAtGeneration != 0 && board->engine->generation() >= board->stopAtGeneration)
+		{
+			board->running = false;
+			board->stopAtGeneration = 0;
+			actionsRun_.notify_all();
+		}
+	}
+	phaseBoards_.clear();
+	jobs_.clear();
+	nextJob_ = 0;
+
+	std::stop_token stop = pool_.stopToken();
+	while (completed && !stop.stop_requested())
+	{
+		runActions();
+
+		int64_t waitNs = scheduleBoards();
+		if (waitNs == 0)
+			return true;
+
+		auto queued = [this]() { return !actions_.empty(); };
+		if (waitNs < 0)
+			actionQueued_.wait(lock, stop, queued);
+		else
+			actionQueued_.wait_for(lock, stop, std::chrono::nanoseconds(waitNs), queued);
+	}
+	return false;
+}
+
+
+void Supervisor::runActions(void)
+{
+	while (!actions_.empty())
+	{
+		actions_.front()();
+		actions_.pop_front();
+		actionsDone_++;
+		actionsRun_.notify_all();
+	}
+}
+
+
+//	Picks the boards of the next phase, by increasing virtual time, and
+//	cuts them into jobs.  Returns 0 if there is something to compute,
+//	otherwise the number of nanoseconds until a board is due (-1: no board
+//	is running).
+int64_t Supervisor::scheduleBoards(void)
+{
+	std::vector<Board*> candidates;
+	for (auto& board : boards_)
+		if (board.second->running)
+			candidates.push_back(board.second.get());
+	std::stable_sort(candidates.begin(), candidates.end(), [](const Board* a, const Board* b) {
+		return a->virtualTime < b->virtualTime;
+	});
+
+	unsigned int numThreads = pool_.size();
+	double budget = PHASE_CELLS_PER_THREAD * numThreads;
+	double cells = 0.;
+	int64_t waitNs = -1;
+
+	//	Boards that are ahead of the one furthest behind by more than a
+	//	phase wait for it to catch up
+	for (Board* board : candidates)
+	{
+		if (cells >= budget || board->virtualTime > candidates[0]->virtualTime + budget)
+			break;
+
+		//	Steps are unthrottled.  A board that waits for its next
+		//	generation does not bank virtual time meanwhile.
+		CellEngine* engine = board->engine.get();
+		int64_t dueNs = board->stopAtGeneration != 0 ? 0 : engine->pacer().tryPace();
+		if (dueNs > 0)
+		{
+			waitNs = waitNs < 0 ? dueNs : std::min(waitNs, dueNs);
+			board->virtualTime = std::max(board->virtualTime, candidates[0]->virtualTime);
+			continue;
+		}
+
+		double boardCells = (double) engine->numRows() * engine->numCols();
+		unsigned int count = (unsigned int) std::clamp(boardCells / MIN_BAND_CELLS, 1., (double) numThreads);
+		count = std::min(count, engine->numRows());
+
+		engine->beginHostedGeneration();
+		for (unsigned int band = 0; band < count; band++)
+			jobs_.push_back(Job{engine, band, count});
+		phaseBoards_.push_back(board);
+		cells += boardCells;
+	}
+
+	return phaseBoards_.empty() ? waitNs : 0;
+}
+
+
+//	Virtual time of the running board that is furthest behind (0 if none is
+//	running)
+double Supervisor::leastVirtualTime(void) const
+{
+	bool any = false;
+	double least = 0.;
+	for (const auto& board : boards_)
+		if (board.second->running && (!any || board.second->virtualTime < least))
+		{
+			least = board.second->virtualTime;
+			any = true;
+		}
+	return least;
+}
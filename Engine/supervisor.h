@@ -0,0 +1,148 @@
+//
+//  supervisor.h
+//  Cellular Automaton
+//
+//	Many independent boards in one process, computed by a single shared
+//	WorkerPool rather than by one set of threads per board (which
+//	oversubscribes the CPU as soon as the boards have more threads in total
+//	than there are cores).  Each board is a CellEngine that never starts
+//	threads of its own: the supervisor computes its generations through the
+//	engine's hosting interface.  Boards keep their own rule, color mode,
+//	border and Pacer.
+//
+//	Each phase of the pool computes one generation of a few boards, cut
+//	into bands that the workers pick up in turn.  The boards of a phase are
+//	chosen by fair share: the virtual time of a board is the number of
+//	cells it computed, divided by its share, and the running boards with the
+//	lowest virtual time go first, up to a budget of cells per phase.  A
+//	small board thus gets many generations while a large one gets one, and
+//	both get the same CPU time (in proportion to their shares).  A board
+//	whose next generation is not due yet (see Pacer::tryPace()) sits the
+//	phase out.
+//
+//	Boards are only touched between two phases: the methods below hand
+//	their work over to the pool, and wait until it has run (a phase lasts
+//	no longer than a generation of the largest board, shared among all the
+//	threads).  They can be called from any thread but the pool's.
+//
+
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <vector>
+//
+#include "cellEngine.h"
+#include "workerPool.h"
+
+typedef struct BoardInfo {
+	unsigned int numRows, numCols;
+	unsigned long generation;
+	bool running;
+	double share;
+	double cellUpdates;		//	cells computed since the board was added
+} BoardInfo;
+
+class Supervisor
+{
+	public:
+
+		explicit Supervisor(unsigned int numThreads);
+		~Supervisor(void);
+
+		Supervisor(const Supervisor&) = delete;
+		Supervisor& operator =(const Supervisor&) = delete;
+
+		//	Adds a board (paused, all dead) and returns its index: 1 for the
+		//	first board added, and so on.  Indexes are not reused.
+		unsigned int addBoard(unsigned int numCols, unsigned int numRows);
+
+		//	The methods below return false if there is no board index
+
+		bool removeBoard(unsigned int index);
+
+		//	Runs the board in the background, paced by its engine's pacer
+		bool run(unsigned int index);
+		bool pause(unsigned int index);
+
+		//	Pauses the board, then computes numGenerations generations,
+		//	unthrottled, and returns when they are done
+		bool step(unsigned int index, unsigned long numGenerations);
+
+		//	Share of the CPU time of the board, relative to the others (1 by
+		//	default)
+		bool setShare(unsigned int index, double share);
+
+		//	Runs action on the engine of the board, while no thread computes
+		//	it.  The action must not start the engine's own threads (run(),
+		//	step(), setStrategy() or setNumThreads() would).
+		bool withEngine(unsigned int index, const std::function<void(CellEngine*)>& action);
+
+		bool boardInfo(unsigned int index, BoardInfo* info);
+		std::vector<unsigned int> boardIndexes(void);
+
+		//	Size of the shared pool, clamped to [1, MAX_NUM_THREADS].  The
+		//	generations in flight are recomputed by the new set of threads.
+		void setNumThreads(unsigned int numThreads);
+		unsigned int numThreads(void) const;
+
+	private:
+
+		typedef struct Board {
+			std::unique_ptr<CellEngine> engine;
+			bool running;
+			unsigned long stopAtGeneration;	//	end of a step() (0: none)
+			double share;
+			double virtualTime;
+			double cellUpdates;
+		} Board;
+
+		//	Band index (out of count) of a board
+		typedef struct Job {
+			CellEngine* engine;
+			unsigned int band, count;
+		} Job;
+
+		void startPool(unsigned int numThreads);
+		void betweenPhases(const std::function<void(void)>& action);
+		void computeJobs(std::stop_token stop);
+		bool endOfPhase(bool completed);
+		void runActions(void);
+		int64_t scheduleBoards(void);
+		double leastVirtualTime(void) const;
+
+		//	Taken by the phase-end step while it works (not while it waits
+		//	for something to do), never by the workers
+		std::mutex lock_;
+		std::condition_variable_any actionQueued_, actionsRun_;
+
+		std::map<unsigned int, std::unique_ptr<Board>> boards_;
+		unsigned int nextIndex_;
+
+		//	Actions waiting for the end of the phase, and the number of them
+		//	that were run so far
+		std::deque<std::function<void(void)>> actions_;
+		uint64_t actionsQueued_, actionsDone_;
+
+		//	Work of the phase in flight, written at the end of the previous
+		//	one (the barrier publishes it to the workers)
+		std::vector<Job> jobs_;
+		std::vector<Board*> phaseBoards_;
+		std::atomic<size_t> nextJob_;
+
+		//	serializes setNumThreads() and the destructor
+		mutable std::mutex controlLock_;
+
+		//	declared last, so that it is stopped before anything else goes away
+		WorkerPool pool_;
+};
+
+#endif	//	SUPERVISOR_H
@@ -0,0 +1,178 @@
+//
+//  supervisorCommands.cpp
+//  Cellular Automaton
+//
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+//
+#include "engineCommands.h"
+#include "supervisorCommands.h"
+
+//	Target rate of a new board, as in the simulator's window
+const double LAUNCH_GENERATION_RATE = 200.;
+
+static bool runBoardCommand(Supervisor* supervisor, unsigned int index, const char* command, std::string* reply);
+static bool fail(std::string* reply, const char* reason);
+static bool parseCount(const char* text, unsigned long* count);
+
+
+bool runSupervisorCommand(Supervisor* supervisor, const char* command, std::string* reply)
+{
+	//	"<index>: <command>"
+	char* end;
+	unsigned long index = strtoul(command, &end, 10);
+	if (end != command && *end == ':' && command[0] != '-')
+	{
+		const char* boardCommand = end + 1;
+		while (*boardCommand == ' ')
+			boardCommand++;
+		return runBoardCommand(supervisor, (unsigned int) index, boardCommand, reply);
+	}
+
+	char name[32], arg[3][64], extra;
+	int numWords = sscanf(command, "%31s %63s %63s %63s %c", name, arg[0], arg[1], arg[2], &extra);
+	if (numWords < 1)
+		return false;
+
+	unsigned long count[3];
+	char values[256];
+
+	if (strcmp(name, "launch") == 0)
+	{
+		if (numWords < 3 || numWords > 4 || !parseCount(arg[0], &count[0]) || !parseCount(arg[1], &count[1]) ||
+			(numWords == 4 && !parseCount(arg[2], &count[2])))
+			return fail(reply, "launch takes a number of columns and rows, and an optional seed");
+		if (count[0] <= 5 || count[1] <= 5 || count[0] > UINT_MAX || count[1] > UINT_MAX)
+			return fail(reply, "the board must have more than 5 columns and rows");
+
+		unsigned int seed = numWords == 4 ? (unsigned int) count[2] : (unsigned int) time(NULL);
+		unsigned int board = supervisor->addBoard(count[0], count[1]);
+		supervisor->withEngine(board, [seed](CellEngine* engine) {
+			engine->randomize(seed);
+			engine->pacer().setRate(LAUNCH_GENERATION_RATE);
+		});
+		supervisor->run(board);
+		snprintf(values, sizeof(values), "ok %u", board);
+		*reply = values;
+	}
+	else if (strcmp(name, "list") == 0)
+	{
+		*reply = "ok";
+		for (unsigned int board : supervisor->boardIndexes())
+			*reply += " " + std::to_string(board);
+	}
+	else if (strcmp(name, "threads") == 0)
+	{
+		if (numWords != 2 || !parseCount(arg[0], &count[0]) || count[0] == 0 || count[0] > MAX_NUM_THREADS)
+			return fail(reply, "threads takes a number of threads");
+		supervisor->setNumThreads(count[0]);
+		*reply = "ok";
+	}
+	else
+		return false;
+
+	return true;
+}
+
+
+//	Command for board index.  Unknown commands are errors: nobody else
+//	knows about boards.
+static bool runBoardCommand(Supervisor* supervisor, unsigned int index, const char* command, std::string* reply)
+{
+	char name[32], arg[64], extra;
+	int numWords = sscanf(command, "%31s %63s %c", name, arg, &extra);
+	if (numWords < 1)
+		return fail(reply, "missing command");
+	bool hasArg = numWords >= 2;
+
+	bool found = true;
+	unsigned long count;
+	double share;
+	char values[256];
+	*reply = "ok";
+
+	if (strcmp(name, "run") == 0)
+		found = supervisor->run(index);
+	else if (strcmp(name, "pause") == 0)
+		found = supervisor->pause(index);
+	else if (strcmp(name, "end") == 0)
+		found = supervisor->removeBoard(index);
+	else if (strcmp(name, "step") == 0)
+	{
+		if (numWords > 2 || (hasArg && (!parseCount(arg, &count) || count == 0)))
+			return fail(reply, "the number of generations must be positive");
+		BoardInfo info;
+		found = supervisor->step(index, hasArg ? count : 1) && supervisor->boardInfo(index, &info);
+		if (found)
+		{
+			snprintf(values, sizeof(values), "ok generation %lu", info.generation);
+			*reply = values;
+		}
+	}
+	else if (strcmp(name, "share") == 0)
+	{
+		char* end;
+		share = hasArg ? strtod(arg, &end) : 0.;
+		if (numWords != 2 || *end != '\0' || !(share > 0.))
+			return fail(reply, "the share must be a positive number");
+		found = supervisor->setShare(index, share);
+	}
+	else if (strcmp(name, "query") == 0)
+	{
+		BoardInfo info;
+		unsigned int rule = 0;
+		bool colorMode = false;
+		double rate = 0.;
+		found = supervisor->boardInfo(index, &info) &&
+				supervisor->withEngine(index, [&](CellEngine* engine) {
+					rule = engine->rule();
+					colorMode = engine->colorMode();
+					rate = engine->pacer().rate();
+				});
+		if (found)
+		{
+			snprintf(values, sizeof(values),
+					 "ok generation %lu running %d share %g rule %u color %s rate %.1f board %ux%u cells %.0f",
+					 info.generation, info.running ? 1 : 0, info.share, rule, colorMode ? "on" : "off", rate,
+					 info.numCols, info.numRows, info.cellUpdates);
+			*reply = values;
+		}
+	}
+	else if (strcmp(name, "threads") == 0 || strcmp(name, "strategy") == 0)
+		return fail(reply, "the boards share the threads of the supervisor");
+	else
+	{
+		bool known = false;
+		found = supervisor->withEngine(index, [&](CellEngine* engine) {
+			known = runEngineCommand(engine, command, reply);
+		});
+		if (found && !known)
+			return fail(reply, "unknown command");
+	}
+
+	if (!found)
+		return fail(reply, "no such board");
+	return true;
+}
+
+
+//	Sets reply to an error.  Returns true: the command was ours.
+static bool fail(std::string* reply, const char* reason)
+{
+	*reply = std::string("error ") + reason;
+	return true;
+}
+
+
+static bool parseCount(const char* text, unsigned long* count)
+{
+	char* end;
+	errno = 0;
+	*count = strtoul(text, &end, 10);
+	return end != text && *end == '\0' && text[0] != '-' && errno == 0;
+}
@@ -0,0 +1,34 @@
+//
+//  supervisorCommands.h
+//  Cellular Automaton
+//
+//	Text commands that control a Supervisor, with the same one-line replies
+//	as engineCommands.h.  A command for one board is prefixed by its index,
+//	as in "2: rule 3":
+//
+//		launch <cols> <rows> [<seed>]	new random board, running at 200
+//										generations/s: ok <index>
+//		list							ok <index> <index> ...
+//		threads <n>						size of the shared pool
+//		<index>: run / pause
+//		<index>: step [<generations>]	pauses, then computes that many (1)
+//		<index>: share <weight>			share of the CPU time (1)
+//		<index>: query					ok generation <g> running <0|1> ...
+//		<index>: end					removes the board
+//		<index>: <command>				any other command of engineCommands.h
+//										but threads and strategy (the
+//										boards share the supervisor's threads)
+//
+
+#ifndef SUPERVISOR_COMMANDS_H
+#define SUPERVISOR_COMMANDS_H
+
+#include <string>
+//
+#include "supervisor.h"
+
+//	Returns false (and leaves reply alone) if command is not a supervisor
+//	command, so that the caller can try its own commands.
+bool runSupervisorCommand(Supervisor* supervisor, const char* command, std::string* reply);
+
+#endif	//	SUPERVISOR_COMMANDS_H
@@ -0,0 +1,203 @@
+//
+//  workerPool.cpp
+//  Cellular Automaton
+//
+
+#include "workerPool.h"
+
+
+WorkerPool::~WorkerPool(void)
+{
+	stop();
+}
+
+
+void WorkerPool::start(unsigned int numWorkers, Task task, PhaseEnd phaseEnd)
+{
+	stop();
+
+	numWorkers_ = numWorkers;
+	stopSource_ = std::stop_source();
+	run_ = std::make_shared<Run>();
+	run_->task = std::move(task);
+	run_->phaseEnd = std::move(phaseEnd);
+	run_->numWorkers = numWorkers;
+	run_->stopSource = stopSource_;
+	run_->barrier = std::make_unique<std::barrier<PhaseCompletion>>(numWorkers, PhaseCompletion{run_.get()});
+	run_->numLive = numWorkers;
+
+	workers_.reserve(numWorkers);
+	for (unsigned int k = 0; k < numWorkers; k++)
+		workers_.emplace_back(&WorkerPool::workerLoop, run_, k, stopSource_.get_token());
+}
+
+
+void WorkerPool::stop(void)
+{
+	if (workers_.empty())
+		return;
+
+	stopSource_.request_stop();
+
+	//	A worker cannot join itself (this happens if a task or the phase-end
+	//	callback decides to quit the application).  The other workers will
+	//	leave at the next barrier, with the run they share.
+	for (std::jthread& worker : workers_)
+	{
+		if (worker.get_id() == std::this_thread::get_id())
+		{
+			for (std::jthread& w : workers_)
+				w.detach();
+			workers_.clear();
+			return;
+		}
+	}
+
+	for (std::jthread& worker : workers_)
+		worker.join();
+	workers_.clear();
+}
+
+
+void WorkerPool::wait(void)
+{
+	for (std::jthread& worker : workers_)
+		worker.join();
+	workers_.clear();
+}
+
+
+void WorkerPool::resize(unsigned int numWorkers)
+{
+	if (!isRunning())
+	{
+		if (run_)
+			start(numWorkers, run_->task, run_->phaseEnd);
+		return;
+	}
+	if (numWorkers == numWorkers_)
+		return;
+
+	//	The workers beyond the count the last phase end applied are gone
+	//	(or about to be), unless a resize is still waiting for one
+	unsigned int applied = 0;
+	{
+		std::lock_guard<std::mutex> lock(run_->resizeLock);
+		if (run_->pendingWorkers == 0 && !run_->exiting)
+			applied = run_->numWorkers;
+	}
+	if (applied > 0 && workers_.size() > applied)
+	{
+		for (size_t k = applied; k < workers_.size(); k++)
+			workers_[k].join();
+		workers_.resize(applied);
+	}
+
+	std::lock_guard<std::mutex> lock(run_->resizeLock);
+	numWorkers_ = numWorkers;
+	if (run_->exiting)
+		return;
+	run_->pendingWorkers = numWorkers;
+
+	//	Workers already there for an index (even one that was to leave) stay
+	for (unsigned int k = (unsigned int) workers_.size(); k < numWorkers; k++)
+	{
+		run_->numLive++;
+		workers_.emplace_back(&WorkerPool::joinRun, run_, k, run_->numResizes, stopSource_.get_token());
+	}
+}
+
+
+unsigned int WorkerPool::size(void) const
+{
+	return numWorkers_;
+}
+
+
+unsigned int WorkerPool::liveCount(void) const
+{
+	return run_ ? run_->numLive.load() : 0;
+}
+
+
+bool WorkerPool::isRunning(void) const
+{
+	return !workers_.empty();
+}
+
+
+std::stop_token WorkerPool::stopToken(void) const
+{
+	return stopSource_.get_token();
+}
+
+
+void WorkerPool::workerLoop(std::shared_ptr<Run> run, unsigned int index, std::stop_token stop)
+{
+	while (true)
+	{
+		if (!stop.stop_requested())
+			run->task(index, run->numWorkers, stop);
+
+		run->barrier->arrive_and_wait();
+
+		if (run->exiting || index >= run->numWorkers)
+			break;
+	}
+
+	run->numLive--;
+}
+
+
+//	A worker added by resize(): waits for the phase end that applies it
+//	(the first resize done after numResizes) to start working, unless the
+//	count it applies has no room for it after all.
+void WorkerPool::joinRun(std::shared_ptr<Run> run, unsigned int index, unsigned long numResizes,
+						 std::stop_token stop)
+{
+	bool joins;
+	{
+		std::unique_lock<std::mutex> lock(run->resizeLock);
+		run->resized.wait(lock, [&] { return run->exiting || run->numResizes > numResizes; });
+		joins = !run->exiting && index < run->numWorkers;
+	}
+	if (joins)
+		workerLoop(std::move(run), index, stop);
+	else
+		run->numLive--;
+}
+
+
+void WorkerPool::PhaseCompletion::operator ()(void) noexcept
+{
+	WorkerPool::endPhase(run);
+}
+
+
+void WorkerPool::endPhase(Run* run) noexcept
+{
+	//	Any stop request that arrived before this point may have cut some
+	//	workers short: the phase is then incomplete.  Later requests will be
+	//	seen at the next phase.
+	bool completed = !run->stopSource.stop_requested();
+
+	bool keepGoing = completed;
+	if (run->phaseEnd && !run->phaseEnd(completed))
+		keepGoing = false;
+
+	std::lock_guard<std::mutex> lock(run->resizeLock);
+	run->exiting = !keepGoing;
+	if (keepGoing && run->pendingWorkers != 0)
+	{
+		//	(we are in the completion of the current barrier: it is kept)
+		if (run->pendingWorkers != run->numWorkers)
+		{
+			run->oldBarriers.push_back(std::move(run->barrier));
+			run->barrier = std::make_unique<std::barrier<PhaseCompletion>>(run->pendingWorkers, PhaseCompletion{run});
+			run->numWorkers = run->pendingWorkers;
+		}
+		run->pendingWorkers = 0;
+		run->numResizes++;
+	}
+	run->resized.notify_all();
+}
@@ -0,0 +1,144 @@
+//
+//  workerPool.h
+//  Cellular Automaton
+//
+//	A persistent pool of compute threads shared by the different versions
+//	of the simulation.  The threads are created once and repeatedly run the
+//	same task, one "phase" (typically one generation) at a time.  All
+//	workers meet at a std::barrier at the end of each phase, and the last
+//	one to arrive runs the phase-end callback while the others are blocked,
+//	which is where grids get swapped.
+//
+//	Shutdown goes through a std::stop_token: tasks are expected to poll it
+//	and return early, so that stopping the pool never has to wait for more
+//	than a row or a cell worth of work.  A phase cut short that way is
+//	reported as not completed, and should simply be discarded.
+//
+//	The number of workers of a running pool changes at the end of a phase:
+//	the phase-end step swaps in a barrier for the new count, the workers
+//	beyond it leave, and new ones, created beforehand, wait for that phase
+//	end to join.  No phase is cut short, and the next one is split between
+//	the new number of workers.
+//
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <barrier>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+class WorkerPool
+{
+	public:
+
+		//	Work done by worker index (out of count) for one phase.
+		using Task = std::function<void(unsigned int index, unsigned int count, std::stop_token stop)>;
+
+		//	Runs once per phase, in the last worker to arrive at the barrier,
+		//	while all the other workers are blocked.  completed is false when
+		//	the phase was interrupted by a stop request.  Returning false ends
+		//	the run: the workers leave instead of starting another phase.
+		using PhaseEnd = std::function<bool(bool completed)>;
+
+		WorkerPool(void) = default;
+		~WorkerPool(void);
+
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator =(const WorkerPool&) = delete;
+
+		//	Creates numWorkers threads that run task until the pool is stopped.
+		void start(unsigned int numWorkers, Task task, PhaseEnd phaseEnd = nullptr);
+
+		//	Requests a stop and joins all the workers.  Safe to call on a pool
+		//	that is not running, and from one of the workers themselves.
+		void stop(void);
+
+		//	Joins the workers once they have left on their own (the phase-end
+		//	callback returned false).  Does not request a stop.
+		void wait(void);
+
+		//	Runs the next phases with a different number of workers: from the
+		//	end of the phase in flight if the pool is running (a run that
+		//	never ends a phase before it stops must be restarted instead),
+		//	right away, with the same task, if it is not.
+		void resize(unsigned int numWorkers);
+
+		//	Number of workers the pool was last started or resized with
+		unsigned int size(void) const;
+
+		//	Number of workers that have not terminated yet
+		unsigned int liveCount(void) const;
+
+		bool isRunning(void) const;
+
+		//	Token of the current run, for the phase-end callback (tasks get
+		//	it as an argument)
+		std::stop_token stopToken(void) const;
+
+	private:
+
+		struct Run;
+
+		//	std::barrier wants its completion function as a noexcept callable type
+		struct PhaseCompletion
+		{
+			Run* run;
+			void operator ()(void) noexcept;
+		};
+
+		//	What the workers of one run share.  Each worker holds a reference
+		//	to it, so that workers a stop from one of them had to detach can
+		//	still finish their phase after the pool was restarted or deleted.
+		struct Run
+		{
+			Task task;
+			PhaseEnd phaseEnd;
+			std::stop_source stopSource;
+			std::atomic<unsigned int> numLive;
+
+			//	Written by the phase-end step only (under resizeLock), read by
+			//	all workers after the barrier, so they all agree on who works
+			//	in the next phase and whether to leave.  (A worker that leaves
+			//	may read them after the others have ended the next phase, hence
+			//	the atomics: it leaves whatever it reads, since a resize joins
+			//	the workers leaving before it lets the count grow again.)
+			std::atomic<unsigned int> numWorkers;
+			std::unique_ptr<std::barrier<PhaseCompletion>> barrier;
+			std::atomic<bool> exiting = false;
+
+			//	Barriers replaced by a resize.  Workers may still be on their
+			//	way out of them, so they are kept until the run ends.
+			std::vector<std::unique_ptr<std::barrier<PhaseCompletion>>> oldBarriers;
+
+			//	guards the fields above (for the workers waiting to join) and
+			//	below
+			std::mutex resizeLock;
+			std::condition_variable resized;
+			unsigned int pendingWorkers = 0;		//	0: no resize requested
+			unsigned long numResizes = 0;			//	done by the phase-end step
+		};
+
+		static void workerLoop(std::shared_ptr<Run> run, unsigned int index, std::stop_token stop);
+		static void joinRun(std::shared_ptr<Run> run, unsigned int index, unsigned long numResizes,
+							std::stop_token stop);
+		static void endPhase(Run* run) noexcept;
+
+		//	Thread of each worker, by index, including those that leave at the
+		//	next phase end and those waiting to join
+		std::vector<std::jthread> workers_;
+		std::stop_source stopSource_;
+		unsigned int numWorkers_ = 0;
+
+		//	the last run started (kept after it stops, for its task and
+		//	its live count)
+		std::shared_ptr<Run> run_;
+};
+
+#endif	//	WORKER_POOL_H
@@ -5,26 +5,35 @@ WIDTH=$1
 HEIGHT=$2
 THREADS=$3
 
-# lauch of a cellular automaton process
-./Version3/cell $WIDTH $HEIGHT $THREADS &
+# launch of a cellular automaton process, listening for commands on a socket
+SOCKET=/tmp/cell.$$.sock
+./Simulator/cell $WIDTH $HEIGHT $THREADS -c $SOCKET &
+CELL_PID=$!
+
+# wait for the socket to appear
+while [[ ! -S $SOCKET ]]; do
+  if ! kill -0 $CELL_PID 2>/dev/null; then
+    echo "The simulator did not start"
+    exit 1
+  fi
+  sleep 0.1
+done
 
-# pip setup
-PIPE=/tmp/cellpipe
-rm -f $PIPE
-mkfifo $PIPE
+# one connection for the whole session: a line in, a line back
+coproc CELL { nc -U $SOCKET; }
 
 send_cmd() {
-    echo "$1" > /proc/$!/fd/0
-    read -t 1 RESPONSE < /proc/$!/fd/1
+    echo "$1" >&${CELL[1]}
+    read -t 1 RESPONSE <&${CELL[0]}
     echo "$RESPONSE"
 }
 
 
-# communicate with the process
-while true; do
-  read -r CMD
+# communicate with the process (see Engine/engineCommands.h for the commands
+# it understands, plus "line", "zoom out" and "end")
+while read -r CMD; do
 
-  case "$CMD" in 
+  case "$CMD" in
     rule*)
       RULE=$(echo "$CMD" | cut -d " " -f 2)
       if [[ $RULE =~ ^[0-9]+$ ]]; then
@@ -33,33 +42,16 @@ while true; do
         echo "Invalid rule number: $RULE"
       fi
       ;;
-    color\ on)
+    end)
       send_cmd "$CMD"
+      break
       ;;
-    color\ on)
-    send_cmd "$CMD"
-      ;;
-    color\ off)
-    send_cmd "$CMD"
-      ;;
-    line)
-    send_cmd "$CMD"
-      ;;
-    faster)
-    send_cmd "$CMD"
-      ;;
-    slower)
-    send_cmd "$CMD"
-      ;;
-    end)
-    send_cmd "$CMD"
-    break
+    "")
       ;;
     *)
-    echo "Invalid command: $CMD"
-    ;;
+      send_cmd "$CMD"
+      ;;
   esac
 done
 
-# Clean up named pipe
-rm -f $PIPE
+wait $CELL_PID
@@ -1,80 +1,62 @@
 #!/bin/bash
 
-# initialize variables
-next_index=1
-declare -A pids
-declare -A widths
-declare -A heights
+# parse arguments: size of the first board, and number of threads shared
+# by all the boards
+WIDTH=${1:-400}
+HEIGHT=${2:-400}
+THREADS=${3:-$(nproc)}
 
-# function to launch a new cellular automaton process
-function launch_cell {
-    # get width and height arguments
-    width=$1
-    height=$2
-    
-    # launch process with given dimensions and assign index
-    ./Version3/cell $WIDTH $HEIGHT | sed -e "s/^/$next_index: /" &
-    pids["$next_index"]=$!
-    widths["$next_index"]=$width
-    heights["$next_index"]=$height
-    
-    # increment index for next process
-    next_index=$((next_index+1))
+# launch one supervisor process: it hosts all the boards (board 1 to begin
+# with), on a single set of threads
+SOCKET=/tmp/cell.$$.sock
+./Simulator/cell $WIDTH $HEIGHT $THREADS -m $SOCKET &
+CELL_PID=$!
+
+# wait for the socket to appear
+while [[ ! -S $SOCKET ]]; do
+    if ! kill -0 $CELL_PID 2>/dev/null; then
+        echo "The supervisor did not start"
+        exit 1
+    fi
+    sleep 0.1
+done
+
+# one connection for the whole session: a line in, a line back
+coproc CELL { nc -U $SOCKET; }
+
+send_cmd() {
+    echo "$1" >&${CELL[1]}
+    read -t 5 RESPONSE <&${CELL[0]}
+    echo "$RESPONSE"
 }
 
-# loop to read and process user commands
+# loop to read and process user commands (see Engine/supervisorCommands.h)
+#   launch <width> <height> [seed]   start a new board: ok <index>
+#   list                             indexes of the boards
+#   <index>: <command>               send a command to a board
+#   end                              quit
 while true; do
-    read -p "> " cmd
+    read -p "> " cmd || break
 
-    # extract index and command from input
-    index=${cmd%%:*}
-    cmd=${cmd#*: }
-    
-    # check if index is valid
-    if [[ -z ${pids[$index]} ]]; then
-        echo "Invalid index: $index"
-        continue
-    fi
-    
-    # check if process is still running
-    if ! kill -0 ${pids[$index]} 2>/dev/null; then
-        echo "Process $index has terminated"
-        unset pids[$index]
-        unset widths[$index]
-        unset heights[$index]
-        continue
-    fi
-    
-    # process command for selected process
     case "$cmd" in
-        "end")
-            kill ${pids[$index]}
-            ;;
-        "faster")
-            echo "faster" > /proc/${pids[$index]}/fd/0
+        "")
             ;;
-        "slower")
-            echo "slower" > /proc/${pids[$index]}/fd/0
+        end)
+            send_cmd "$cmd"
+            break
             ;;
-        "rule "*)
-            rule=${cmd#rule }
-            if [[ $rule -ge 0 && $rule -le 255 ]]; then
-                echo "rule $rule" > /proc/${pids[$index]}/fd/0
+        *:\ rule\ *)
+            rule=${cmd#*: rule }
+            if [[ $rule =~ ^[0-9]+$ ]]; then
+                send_cmd "$cmd"
             else
                 echo "Invalid rule number: $rule"
             fi
             ;;
-        "color on")
-            echo "color on" > /proc/${pids[$index]}/fd/0
-            ;;
-        "color off")
-            echo "color off" > /proc/${pids[$index]}/fd/0
-            ;;
-        "line")
-            echo "line" > /proc/${pids[$index]}/fd/0
-            ;;
         *)
-            echo "Invalid command: $cmd"
+            send_cmd "$cmd"
             ;;
     esac
 done
+
+wait $CELL_PID
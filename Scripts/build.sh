@@ -1,8 +1,16 @@
-
 #!/bin/bash
 
+# Build the simulation engine library, shared by all the programs
+cd Engine
+for source in *.cpp
+do
+    g++ -Wall -std=c++20 -O2 -c "$source"
+done
+ar rcs libcellengine.a *.o
+cd ..
+
 # List all versions of the project
-versions=("version1" "version2" "version3")
+versions=("Version1" "Version2" "Version3" "Simulator")
 
 # Build each version
 for version in "${versions[@]}"
@@ -11,8 +19,13 @@ do
     cd "$version"
     
     # Build the executable
-    g++ -Wall -std=c++20 main.cpp gl_frontEnd.cpp -framework OpenGL -framework GLUT -o cell
+    g++ -Wall -std=c++20 -O2 main.cpp gl_frontEnd.cpp ../Engine/libcellengine.a -framework OpenGL -framework GLUT -o cell
     
     # Return to the root directory
     cd ..
 done
+
+# The benchmarks have no window
+cd Benchmark
+g++ -Wall -std=c++20 -O2 main.cpp ../Engine/libcellengine.a -o bench
+cd ..
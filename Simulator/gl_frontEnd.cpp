@@ -0,0 +1,917 @@
+//
+//  gl_frontEnd.cpp
+//
+//
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <vector>
+//
+#include "gl_frontEnd.h"
+
+//	Pixel buffer objects need headers for OpenGL 2.1 or later (used when
+//	the driver supports them, checked at runtime)
+#if defined(GL_VERSION_2_1)
+	#define PIXEL_BUFFERS	1
+#else
+	#define PIXEL_BUFFERS	0
+#endif
+
+
+//---------------------------------------------------------------------------
+//  Private functions' prototypes
+//---------------------------------------------------------------------------
+
+void myResize(int w, int h);
+void displayTextualInfo(const char* infoStr, int x, int y, int isLarge);
+void myMouse(int b, int s, int x, int y);
+void myGridPaneMouse(int b, int s, int x, int y);
+void myGridPaneMotion(int x, int y);
+void myStatePaneMouse(int b, int s, int x, int y);
+void myKeyboard(unsigned char c, int x, int y);
+void myMenuHandler(int value);
+void mySubmenuHandler(int colorIndex);
+void myTimerFunc(int val);
+void enableVsync(void);
+void allocateGridTextures(unsigned int numRows, unsigned int numCols);
+void loadCellPalette(void);
+void uploadGridTiles(const uint8_t* data, unsigned int numRows, unsigned int numCols,
+					 GLenum format, unsigned int bytesPerCell);
+#if PIXEL_BUFFERS
+	bool pixelBuffersSupported(void);
+	bool fillPixelBuffer(int k, const uint8_t* cells, size_t numCells);
+#endif
+//
+//	implemented in main.cpp
+void cleanupAndQuit(void);
+void faster(void);
+void slower(void);
+void toggleUnthrottled(void);
+void moreThreads(void);
+void fewerThreads(void);
+void nextStrategy(void);
+void zoomView(double factor, double x, double y);
+void panView(double dx, double dy);
+void resetView(void);
+bool gridPaneChanged(void);
+bool statePaneChanged(void);
+void setRule(unsigned int rule);
+void toggleColorMode(void);
+void saveBoard(void);
+void exportBoard(void);
+void stepBack(void);
+void stepForward(void);
+void togglePause(void);
+
+//---------------------------------------------------------------------------
+//  Interface constants
+//---------------------------------------------------------------------------
+
+//	I like to setup my meny item indices as enumerated values, but really
+//	regular int constants would do the job just fine.
+
+enum MenuItemID {	SEPARATOR = -1,
+					//
+					QUIT_MENU = 0,
+					OTHER_MENU_ITEM
+};
+
+const char* MAIN_MENU_ITEM_STR[] = {	"Quit",			//	QUIT_MENU
+										"Something"		//	OTHER_MENU_ITEM
+};
+
+enum FirstSubmenuItemID {	FIRST_SUBMENU_ITEM = 11,
+							SECOND_SUBMENU_ITEM
+};
+
+#define SMALL_DISPLAY_FONT    GLUT_BITMAP_HELVETICA_12
+#define LARGE_DISPLAY_FONT    GLUT_BITMAP_HELVETICA_18
+// const int SMALL_FONT_HEIGHT = 12;
+// const int LARGE_FONT_HEIGHT = 18;
+const int TEXT_PADDING = 0;
+const float kTextColor[4] = {1.f, 1.f, 1.f, 1.f};
+
+//	Predefine some colors for "age"-based rendering of the cells
+GLfloat cellColor[NB_COLORS][4] = {	{0.f, 0.f, 0.f, 1.f},	//	BLACK_COL
+									{1.f, 1.f, 1.f, 1.f},	//	WHITE_COL,
+									{0.f, 0.f, 1.f, 1.f},	//	BLUE_COL,
+									{0.f, 1.f, 0.f, 1.f},	//	GREEN_COL,
+									{1.f, 1.f, 0.f, 1.f},	//	YELLOW_COL,
+									{1.f, 0.f, 0.f, 1.f}};	//	RED_COL
+
+//	The board is drawn as textured quads, one texel per cell.  Textures are
+//	limited in size, so a large board is split into tiles of at most
+//	GRID_TILE_SIZE x GRID_TILE_SIZE cells, each with its own texture.
+const unsigned int GRID_TILE_SIZE = 2048;
+
+//	Mouse wheel, as reported by freeglut, and zoom factor for one step of it
+const int MOUSE_WHEEL_UP = 3;
+const int MOUSE_WHEEL_DOWN = 4;
+const double ZOOM_STEP = 1.25;
+
+//	Upper bound on the number of frames drawn per second, by default
+const double DEFAULT_MAX_FRAME_RATE = 60.;
+
+//	Size of the color-index-to-RGBA pixel maps (must be a power of 2)
+const int PALETTE_SIZE = 8;
+	
+
+//	Initial position of the window
+const int   INIT_WIN_X = 100,
+            INIT_WIN_Y = 40;
+
+//	Wow!  gcc on Linux is really dumb!  The code below doesn't even compile there.
+//const int	GRID_PANE_WIDTH = 600,
+//			GRID_PANE_HEIGHT = GRID_PANE_WIDTH,	//	--> claims GRID_PANE_WIDTH not constant!
+//			STATE_PANE_WIDTH = 300,
+//			STATE_PANE_HEIGHT = GRID_PANE_HEIGHT,
+//			H_PADDING = 5,
+//			WINDOW_WIDTH = GRID_PANE_WIDTH + STATE_PANE_WIDTH + H_PADDING,
+//			WINDOW_HEIGHT = GRID_PANE_HEIGHT;
+//	(sigh!)	This completely negates the point of using constants for this kind of setup.
+//	No wonder most Linux apps suck so hard.
+const int GRID_PANE_WIDTH = 800;
+const int GRID_PANE_HEIGHT = 700;
+const int STATE_PANE_WIDTH = 300;
+const int STATE_PANE_HEIGHT = 700;
+const int H_PADDING = 0;
+const int WINDOW_WIDTH = 1100;
+const int WINDOW_HEIGHT = 700;
+
+
+//---------------------------------------------------------------------------
+//  File-level global variables
+//---------------------------------------------------------------------------
+
+void (*gridDisplayFunc)(void);
+void (*stateDisplayFunc)(void);
+
+//	We use a window split into two panes/subwindows.  The subwindows
+//	will be accessed by an index.
+int	GRID_PANE = 0,
+	STATE_PANE = 1;
+int	gMainWindow,
+	gSubwindow[2];
+
+int drawGridLines = 0;
+
+//	Time between two looks at what needs redrawing, in milliseconds
+int framePeriod = (int) (1000. / DEFAULT_MAX_FRAME_RATE);
+
+//	Last position of the mouse while dragging in the grid pane
+bool dragging = false;
+int dragX = 0, dragY = 0;
+
+//	The tile textures, row by row, for a board of gridTexRows x gridTexCols
+//	cells.  (Re)allocated when the size of the board changes.
+std::vector<GLuint> gridTextures;
+unsigned int gridTexRows = 0, gridTexCols = 0;
+
+//	Number of the frame (see ViewFrame::sequence) last sent to the textures
+const unsigned long NO_FRAME = ~0ul;
+unsigned long uploadedFrame = NO_FRAME;
+
+#if PIXEL_BUFFERS
+	//	The two pixel buffers used to stream frames to the textures, the one
+	//	filled last, and the one whose transfer is still to be started (-1
+	//	if none)
+	GLuint gridPixelBuffers[2] = {0, 0};
+	int fillingBuffer = 0;
+	int pendingBuffer = -1;
+#endif
+
+//---------------------------------------------------------------------------
+//	Drawing functions
+//---------------------------------------------------------------------------
+
+
+//	Makes sure that the tile textures (and pixel buffers) exist for a board
+//	of numRows x numCols cells.  Must be called with the grid pane's GL
+//	context current.
+void allocateGridTextures(unsigned int numRows, unsigned int numCols)
+{
+	if (numRows == gridTexRows && numCols == gridTexCols)
+		return;
+
+	if (!gridTextures.empty())
+		glDeleteTextures((GLsizei) gridTextures.size(), gridTextures.data());
+
+	unsigned int tileRows = (numRows + GRID_TILE_SIZE - 1) / GRID_TILE_SIZE;
+	unsigned int tileCols = (numCols + GRID_TILE_SIZE - 1) / GRID_TILE_SIZE;
+	gridTextures.assign((size_t) tileRows * tileCols, 0);
+	glGenTextures((GLsizei) gridTextures.size(), gridTextures.data());
+
+	for (unsigned int ti = 0; ti < tileRows; ti++)
+		for (unsigned int tj = 0; tj < tileCols; tj++)
+		{
+			unsigned int h = std::min(GRID_TILE_SIZE, numRows - ti * GRID_TILE_SIZE);
+			unsigned int w = std::min(GRID_TILE_SIZE, numCols - tj * GRID_TILE_SIZE);
+
+			glBindTexture(GL_TEXTURE_2D, gridTextures[(size_t) ti * tileCols + tj]);
+			//	one texel per cell: no filtering, so that cells keep sharp edges
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, (GLsizei) w, (GLsizei) h, 0,
+						 GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	#if PIXEL_BUFFERS
+		if (pixelBuffersSupported())
+		{
+			if (gridPixelBuffers[0] == 0)
+				glGenBuffers(2, gridPixelBuffers);
+			pendingBuffer = -1;
+		}
+	#endif
+
+	gridTexRows = numRows;
+	gridTexCols = numCols;
+	uploadedFrame = NO_FRAME;
+}
+
+
+//	Loads cellColor in the pixel maps that turn the color index (the cell
+//	state) of each uploaded byte into an RGBA texel
+void loadCellPalette(void)
+{
+	GLfloat map[4][PALETTE_SIZE] = {{0.f}};
+	for (int k = 0; k < NB_COLORS; k++)
+		for (int c = 0; c < 4; c++)
+			map[c][k] = cellColor[k][c];
+
+	glPixelMapfv(GL_PIXEL_MAP_I_TO_R, PALETTE_SIZE, map[0]);
+	glPixelMapfv(GL_PIXEL_MAP_I_TO_G, PALETTE_SIZE, map[1]);
+	glPixelMapfv(GL_PIXEL_MAP_I_TO_B, PALETTE_SIZE, map[2]);
+	glPixelMapfv(GL_PIXEL_MAP_I_TO_A, PALETTE_SIZE, map[3]);
+}
+
+
+//	Copies a board (or, with a pixel buffer bound, the board stored at
+//	offset 0 of the buffer) into the tile textures.  data holds numCols
+//	cells per row, bytesPerCell bytes each, in the given pixel format.
+void uploadGridTiles(const uint8_t* data, unsigned int numRows, unsigned int numCols,
+					 GLenum format, unsigned int bytesPerCell)
+{
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint) numCols);
+
+	unsigned int tileCols = (numCols + GRID_TILE_SIZE - 1) / GRID_TILE_SIZE;
+	for (size_t t = 0; t < gridTextures.size(); t++)
+	{
+		unsigned int r0 = (unsigned int) (t / tileCols) * GRID_TILE_SIZE;
+		unsigned int c0 = (unsigned int) (t % tileCols) * GRID_TILE_SIZE;
+		unsigned int r1 = std::min(r0 + GRID_TILE_SIZE, numRows);
+		unsigned int c1 = std::min(c0 + GRID_TILE_SIZE, numCols);
+
+		glBindTexture(GL_TEXTURE_2D, gridTextures[t]);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei) (c1 - c0), (GLsizei) (r1 - r0),
+						format, GL_UNSIGNED_BYTE, data + ((size_t) r0 * numCols + c0) * bytesPerCell);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+
+#if PIXEL_BUFFERS
+
+//	Pixel buffer objects are core in OpenGL 2.1
+bool pixelBuffersSupported(void)
+{
+	static int supported = -1;
+	if (supported < 0)
+	{
+		int major = 0, minor = 0;
+		const char* version = (const char*) glGetString(GL_VERSION);
+		supported = version != NULL && sscanf(version, "%d.%d", &major, &minor) == 2 &&
+					(major > 2 || (major == 2 && minor >= 1));
+	}
+	return supported != 0;
+}
+
+
+//	Writes the RGBA colors of the cells into pixel buffer k.  The previous
+//	contents are orphaned first, so that mapping the buffer does not wait
+//	for a transfer from it that may still be in progress.
+//	Returns false if the buffer could not be filled.
+bool fillPixelBuffer(int k, const uint8_t* cells, size_t numCells)
+{
+	uint32_t palette[NB_COLORS];
+	for (int c = 0; c < NB_COLORS; c++)
+	{
+		uint8_t rgba[4];
+		for (int x = 0; x < 4; x++)
+			rgba[x] = (uint8_t) (255.f * cellColor[c][x] + 0.5f);
+		memcpy(palette + c, rgba, 4);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gridPixelBuffers[k]);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr) (4 * numCells), NULL, GL_STREAM_DRAW);
+	uint32_t* texels = (uint32_t*) glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+	bool ok = texels != NULL;
+	if (ok)
+	{
+		for (size_t i = 0; i < numCells; i++)
+			texels[i] = palette[cells[i]];
+		ok = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	return ok;
+}
+
+#endif	//	PIXEL_BUFFERS
+
+
+//	This is the function that does the actual grid drawing
+//	The cells are stored row by row, one byte per cell.  They are kept in
+//	textures (one texel per cell), which are only updated when frameNumber
+//	says that the cells changed, and drawn as one quad per tile.
+//	With pixel buffers, a frame is streamed in two steps: the cells are
+//	turned into colors in one pixel buffer, which is only transferred to the
+//	textures at the next call, while the other buffer gets the next frame.
+//	The transfer thus runs in the background and never stalls the copy.
+//	Without them, the bytes are uploaded as they are (as color indices) and
+//	the palette lookup is done by OpenGL during the transfer.
+//	window is the part of the cells that fills the pane (the rest is clipped)
+void drawGrid(const uint8_t* cells, unsigned int numRows, unsigned int numCols, unsigned long frameNumber,
+			  const GridWindow& window)
+{
+	const float	DH = (float) (GRID_PANE_WIDTH / window.numCols),
+				DV = (float) (GRID_PANE_HEIGHT / window.numRows);
+
+	allocateGridTextures(numRows, numCols);
+
+	#if PIXEL_BUFFERS
+	if (pixelBuffersSupported())
+	{
+		if (pendingBuffer >= 0)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gridPixelBuffers[pendingBuffer]);
+			uploadGridTiles(NULL, numRows, numCols, GL_RGBA, 4);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			pendingBuffer = -1;
+		}
+		if (frameNumber != uploadedFrame)
+		{
+			fillingBuffer = 1 - fillingBuffer;
+			if (fillPixelBuffer(fillingBuffer, cells, (size_t) numRows * numCols))
+			{
+				pendingBuffer = fillingBuffer;
+				uploadedFrame = frameNumber;
+			}
+		}
+	}
+	else
+	#endif
+	if (frameNumber != uploadedFrame)
+	{
+		loadCellPalette();
+		uploadGridTiles(cells, numRows, numCols, GL_COLOR_INDEX, 1);
+		uploadedFrame = frameNumber;
+	}
+
+	glPushMatrix();
+	glTranslatef((float) (-window.col * DH), (float) (-window.row * DV), 0.f);
+
+	glEnable(GL_TEXTURE_2D);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+	unsigned int tileCols = (numCols + GRID_TILE_SIZE - 1) / GRID_TILE_SIZE;
+	for (size_t t = 0; t < gridTextures.size(); t++)
+	{
+		unsigned int r0 = (unsigned int) (t / tileCols) * GRID_TILE_SIZE;
+		unsigned int c0 = (unsigned int) (t % tileCols) * GRID_TILE_SIZE;
+		unsigned int r1 = std::min(r0 + GRID_TILE_SIZE, numRows);
+		unsigned int c1 = std::min(c0 + GRID_TILE_SIZE, numCols);
+
+		//	Row r0 of the tile is texture row 0, drawn at the bottom, like
+		//	row 0 of the board
+		glBindTexture(GL_TEXTURE_2D, gridTextures[t]);
+		glBegin(GL_QUADS);
+			glTexCoord2f(0.f, 0.f);		glVertex2f(c0*DH, r0*DV);
+			glTexCoord2f(1.f, 0.f);		glVertex2f(c1*DH, r0*DV);
+			glTexCoord2f(1.f, 1.f);		glVertex2f(c1*DH, r1*DV);
+			glTexCoord2f(0.f, 1.f);		glVertex2f(c0*DH, r1*DV);
+		glEnd();
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+
+	if (drawGridLines)
+	{
+		//	Then draw a grid of lines on top of the squares
+		glColor4f(0.5f, 0.5f, 0.5f, 1.f);
+		glBegin(GL_LINES);
+			//	Horizontal
+			for (unsigned int i=0; i<= numRows; i++)
+			{
+				glVertex2f(0, i*DV);
+				glVertex2f(numCols*DH, i*DV);
+			}
+			//	Vertical
+			for (unsigned int j=0; j<= numCols; j++)
+			{
+				glVertex2f(j*DH, 0);
+				glVertex2f(j*DH, numRows*DV);
+			}
+		glEnd();
+	}
+
+	glPopMatrix();
+}
+
+
+
+void displayTextualInfo(const char* infoStr, int xPos, int yPos, int isLarge)
+{
+    //-----------------------------------------------
+    //  0.  get current material properties
+    //-----------------------------------------------
+    float oldAmb[4], oldDif[4], oldSpec[4], oldShiny;
+    glGetMaterialfv(GL_FRONT, GL_AMBIENT, oldAmb);
+    glGetMaterialfv(GL_FRONT, GL_DIFFUSE, oldDif);
+    glGetMaterialfv(GL_FRONT, GL_SPECULAR, oldSpec);
+    glGetMaterialfv(GL_FRONT, GL_SHININESS, &oldShiny);
+
+    glPushMatrix();
+
+    //-----------------------------------------------
+    //  1.  Build the string to display <-- parameter
+    //-----------------------------------------------
+    unsigned int infoLn = (unsigned int) strlen(infoStr);
+
+    //-----------------------------------------------
+    //  2.  Determine the string's length (in pixels)
+    //-----------------------------------------------
+    int textWidth = 0;
+    for (unsigned int k=0; k<infoLn; k++)
+	{
+		if (isLarge)
+			textWidth += glutBitmapWidth(LARGE_DISPLAY_FONT, infoStr[k]);
+		else
+			textWidth += glutBitmapWidth(SMALL_DISPLAY_FONT, infoStr[k]);
+		
+    }
+	//  add a few pixels of padding
+    textWidth += 2*TEXT_PADDING;
+    (void) textWidth;
+	
+    //-----------------------------------------------
+    //  4.  Draw the string
+    //-----------------------------------------------    
+    glColor4fv(kTextColor);
+    int x = xPos;
+    for (unsigned int k=0; k<infoLn; k++)
+    {
+        glRasterPos2i(x, yPos);
+		if (isLarge)
+		{
+			glutBitmapCharacter(LARGE_DISPLAY_FONT, infoStr[k]);
+			x += glutBitmapWidth(LARGE_DISPLAY_FONT, infoStr[k]);
+		}
+		else
+		{
+			glutBitmapCharacter(SMALL_DISPLAY_FONT, infoStr[k]);
+			x += glutBitmapWidth(SMALL_DISPLAY_FONT, infoStr[k]);
+		}
+	}
+
+    //-----------------------------------------------
+    //  5.  Restore old material properties
+    //-----------------------------------------------
+	glMaterialfv(GL_FRONT, GL_AMBIENT, oldAmb);
+	glMaterialfv(GL_FRONT, GL_DIFFUSE, oldDif);
+	glMaterialfv(GL_FRONT, GL_SPECULAR, oldSpec);
+	glMaterialf(GL_FRONT, GL_SHININESS, oldShiny);  
+    
+    //-----------------------------------------------
+    //  6.  Restore reference frame
+    //-----------------------------------------------
+    glPopMatrix();
+}
+
+
+
+//	A targetRate of 0 means that the simulation is unthrottled, a
+//	rewindMaxMB of 0 that no generations are kept to step back through
+void drawState(const char* strategy, unsigned int numLiveThreads, double achievedRate, double targetRate,
+			   const char* rateUnit, double frameMicroseconds, unsigned long rewindGenerations,
+			   double rewindMB, double rewindMaxMB)
+{
+	const int H_PAD = STATE_PANE_WIDTH / 16;
+	const int TOP_LEVEL_TXT_Y = 4*STATE_PANE_HEIGHT / 5;
+	const int LINE_SPACING = STATE_PANE_HEIGHT / 20;
+
+	//	Build, then display text info for the red, green, and blue tanks
+	char infoStr[256];
+	//	display info about number of live threads
+	sprintf(infoStr, "Live Threads: %d", numLiveThreads);
+	displayTextualInfo(infoStr, H_PAD, TOP_LEVEL_TXT_Y, 1);
+
+	//	display the achieved and target simulation rates
+	sprintf(infoStr, "Rate: %.1f %s", achievedRate, rateUnit);
+	displayTextualInfo(infoStr, H_PAD, TOP_LEVEL_TXT_Y - LINE_SPACING, 0);
+	if (targetRate > 0.)
+		sprintf(infoStr, "Target: %.1f %s", targetRate, rateUnit);
+	else
+		sprintf(infoStr, "Target: unthrottled");
+	displayTextualInfo(infoStr, H_PAD, TOP_LEVEL_TXT_Y - 2*LINE_SPACING, 0);
+
+	sprintf(infoStr, "Strategy: %s", strategy);
+	displayTextualInfo(infoStr, H_PAD, TOP_LEVEL_TXT_Y - 3*LINE_SPACING, 0);
+
+	//	time the compute threads spend on each frame they publish
+	sprintf(infoStr, "Frame cost: %.0f us", frameMicroseconds);
+	displayTextualInfo(infoStr, H_PAD, TOP_LEVEL_TXT_Y - 4*LINE_SPACING, 0);
+
+	//	generations kept to step back through, and the memory they take
+	if (rewindMaxMB > 0.)
+		sprintf(infoStr, "Rewind: %lu gen, %.1f / %.0f MB", rewindGenerations, rewindMB, rewindMaxMB);
+	else
+		sprintf(infoStr, "Rewind: off");
+	displayTextualInfo(infoStr, H_PAD, TOP_LEVEL_TXT_Y - 5*LINE_SPACING, 0);
+}
+
+
+//	This callback function is called when the window is resized
+//	(generally by the user of the application).
+//	It is also called when the window is created, why I placed there the
+//	code to set up the virtual camera for this application.
+//
+void myResize(int w, int h)
+{
+	if ((w != WINDOW_WIDTH) || (h != WINDOW_HEIGHT))
+	{
+		glutReshapeWindow(WINDOW_WIDTH, WINDOW_HEIGHT);
+	}
+	else
+	{
+		glutPostRedisplay();
+	}
+}
+
+
+void myDisplay(void)
+{
+    glutSetWindow(gMainWindow);
+
+    glMatrixMode(GL_MODELVIEW);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glutSwapBuffers();
+
+	gridDisplayFunc();
+	stateDisplayFunc();
+	
+    glutSetWindow(gMainWindow);	
+}
+
+//	This function is called when a mouse event occurs just in the tiny
+//	space between the two subwindows.
+//
+void myMouse(int button, int state, int x, int y)
+{
+	(void) button;
+	(void) state;
+	(void) x;
+	(void) y;
+	
+	glutSetWindow(gMainWindow);
+	glutPostRedisplay();
+}
+
+//	This function is called when a mouse event occurs in the grid pane
+//	The wheel zooms in and out around the mouse (freeglut reports it as
+//	buttons 3 and 4), and a drag with the left button pans the view.
+//
+void myGridPaneMouse(int button, int state, int x, int y)
+{
+	switch (button)
+	{
+		case GLUT_LEFT_BUTTON:
+			dragging = state == GLUT_DOWN;
+			dragX = x;
+			dragY = y;
+			break;
+
+		case MOUSE_WHEEL_UP:
+		case MOUSE_WHEEL_DOWN:
+			if (state == GLUT_DOWN)
+				zoomView(button == MOUSE_WHEEL_UP ? ZOOM_STEP : 1. / ZOOM_STEP,
+						 (double) x / GRID_PANE_WIDTH, 1. - (double) y / GRID_PANE_HEIGHT);
+			break;
+
+		default:
+			break;
+	}
+
+	glutSetWindow(gMainWindow);
+	glutPostRedisplay();
+}
+
+//	This function is called when the mouse moves in the grid pane with a
+//	button pressed
+//
+void myGridPaneMotion(int x, int y)
+{
+	if (!dragging)
+		return;
+
+	//	The board follows the mouse (glut's y axis points down)
+	panView((double) (dragX - x) / GRID_PANE_WIDTH, (double) (y - dragY) / GRID_PANE_HEIGHT);
+	dragX = x;
+	dragY = y;
+}
+
+//	This callback function is called when a keyboard event occurs
+//
+void myKeyboard(unsigned char c, int x, int y)
+{
+	(void) x;
+	(void) y;
+	
+	bool ok = true;
+	
+	switch (c)
+	{
+		//	'ESC' --> exit the application
+		case 27:
+			cleanupAndQuit();
+			break;
+
+		//	spacebar --> resets the grid
+		case ' ':
+			resetGrid();
+			break;
+
+		//	'+' --> increase simulation speed
+		case '+':
+			faster();
+			break;
+
+		//	'-' --> reduce simulation speed
+		case '-':
+			slower();
+			break;
+
+		//	'u' --> toggles on/off unthrottled simulation
+		case 'u':
+			toggleUnthrottled();
+			break;
+
+		//	'>' --> add a compute thread
+		case '>':
+			moreThreads();
+			break;
+
+		//	'<' --> remove a compute thread
+		case '<':
+			fewerThreads();
+			break;
+
+		//	's' --> switch to the next execution strategy
+		case 's':
+			nextStrategy();
+			break;
+
+		//	'1' --> apply Rule 1 (Game of Life: B23/S3)
+		case '1':
+			setRule(GAME_OF_LIFE_RULE);
+			break;
+
+		//	'2' --> apply Rule 2 (Coral: B3_S45678)
+		case '2':
+			setRule(CORAL_GROWTH_RULE);
+			break;
+
+		//	'3' --> apply Rule 3 (Amoeba: B357/S1358)
+		case '3':
+			setRule(AMOEBA_RULE);
+			break;
+
+		//	'4' --> apply Rule 4 (Maze: B3/S12345)
+		case '4':
+			setRule(MAZE_RULE);
+			break;
+
+		//	'c' --> toggles on/off color mode
+		//	'b' --> toggles off/on color mode
+		case 'c':
+		case 'b':
+			toggleColorMode();
+			break;
+
+		//	'l' --> toggles on/off grid line rendering
+		case 'l':
+			drawGridLines = !drawGridLines;
+			break;
+
+		//	'z' --> zoom back out to the whole board
+		case 'z':
+			resetView();
+			break;
+
+		//	'w' --> write a checkpoint of the board
+		case 'w':
+			saveBoard();
+			break;
+
+		//	'e' --> export the live part of the board as an RLE pattern
+		case 'e':
+			exportBoard();
+			break;
+
+		//	'[' --> pause, and step back one generation
+		case '[':
+			stepBack();
+			break;
+
+		//	']' --> pause, and step forward one generation
+		case ']':
+			stepForward();
+			break;
+
+		//	'p' --> pause / resume (from the generation shown)
+		case 'p':
+			togglePause();
+			break;
+
+		default:
+			ok = false;
+			break;
+	}
+	if (!ok)
+	{
+		//	do something?
+	}
+	
+	glutSetWindow(gMainWindow);
+	glutPostRedisplay();
+}
+
+
+//	This function is called when a mouse event occurs in the state pane
+void myStatePaneMouse(int button, int state, int x, int y)
+{
+	(void) state;
+	(void) x;
+	(void) y;
+	
+	switch (button)
+	{
+		case GLUT_LEFT_BUTTON:
+			if (state == GLUT_DOWN)
+			{
+				//	do something
+			}
+			else if (state == GLUT_UP)
+			{
+				//	exit(0);
+			}
+			break;
+			
+		default:
+			break;
+	}
+
+	glutSetWindow(gMainWindow);
+	glutPostRedisplay();
+}
+
+
+//	Called once per frame period.  Only the panes whose contents changed
+//	are redrawn: the grid pane when the engine has a new frame (or the view
+//	moved), the state pane when one of its numbers changed.  A paused or
+//	slow simulation thus costs next to nothing to display.
+void myTimerFunc(int value)
+{
+	//	value not used.  Warning suppression
+	(void) value;
+
+	int start = glutGet(GLUT_ELAPSED_TIME);
+
+	//	This is not the way it should be done (glutPostRedisplay), but it
+	//	seems that Apple is not happy with having marked glut as deprecated.
+	//	They are doing things to make it break
+	bool redrawGrid = gridPaneChanged();
+	#if PIXEL_BUFFERS
+		//	A frame filled at the last redraw is only uploaded at the next one,
+		//	which a paused board would otherwise never get
+		redrawGrid = redrawGrid || pendingBuffer >= 0;
+	#endif
+	if (redrawGrid)
+		gridDisplayFunc();
+	if (statePaneChanged())
+		stateDisplayFunc();
+
+	//	Re-prime the timer, one frame period after the start of this frame
+	//	(with vsync, the buffer swaps already waited for the display)
+	int elapsed = glutGet(GLUT_ELAPSED_TIME) - start;
+	glutTimerFunc(std::max(framePeriod - elapsed, 1), myTimerFunc, 0);
+}
+
+
+void setMaxFrameRate(double framesPerSecond)
+{
+	framePeriod = std::max((int) (1000. / framesPerSecond), 1);
+}
+
+
+//	Makes the buffer swaps of the current window wait for the vertical
+//	retrace of the display, when the platform lets us, so that we never
+//	draw frames that cannot be shown
+void enableVsync(void)
+{
+#if defined(__APPLE__)
+	GLint interval = 1;
+	CGLSetParameter(CGLGetCurrentContext(), kCGLCPSwapInterval, &interval);
+#elif defined(GLX_VERSION_1_4)
+	typedef int (*SwapInterval)(unsigned int interval);
+	SwapInterval swapInterval = (SwapInterval) glXGetProcAddress((const GLubyte*) "glXSwapIntervalMESA");
+	if (swapInterval == NULL)
+		swapInterval = (SwapInterval) glXGetProcAddress((const GLubyte*) "glXSwapIntervalSGI");
+	if (swapInterval != NULL)
+		swapInterval(1);
+#endif
+}
+
+void myMenuHandler(int choice)
+{
+	switch (choice)
+	{
+		//	Exit/Quit
+		case QUIT_MENU:
+			cleanupAndQuit();
+			break;
+		
+		//	Do something
+		case OTHER_MENU_ITEM:
+			break;
+		
+		default:	//	this should not happen
+			break;
+	
+	}
+
+    glutPostRedisplay();
+}
+
+
+void initializeFrontEnd(int argc, char** argv, void (*gridDisplayCB)(void),
+						void (*stateDisplayCB)(void))
+{
+
+	//	Initialize glut and create a new window
+	glutInit(&argc, argv);
+	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
+
+
+	glutInitWindowSize(WINDOW_WIDTH, WINDOW_HEIGHT);
+	glutInitWindowPosition(INIT_WIN_X, INIT_WIN_Y);
+	gMainWindow = glutCreateWindow("Programming Assignment 04 -- Cellular Automaton -- CSC 412 - Spring 2018");
+	glClearColor(0.2f, 0.2f, 0.2f, 1.f);
+	
+	//	set up the callbacks for the main window
+	glutDisplayFunc(myDisplay);
+	glutReshapeFunc(myResize);
+	glutMouseFunc(myMouse);
+	glutTimerFunc(20, myTimerFunc, 0);
+
+	gridDisplayFunc = gridDisplayCB;
+	stateDisplayFunc = stateDisplayCB;
+	
+	//	create the two panes as glut subwindows
+	gSubwindow[GRID_PANE] = glutCreateSubWindow(gMainWindow,
+												0, 0,							//	origin
+												GRID_PANE_WIDTH, GRID_PANE_HEIGHT);
+    glViewport(0, 0, GRID_PANE_WIDTH, GRID_PANE_HEIGHT);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+	glOrtho(0.0f, GRID_PANE_WIDTH, 0.0f, GRID_PANE_HEIGHT, -1, 1);
+	glClearColor(0.f, 0.f, 0.f, 1.f);
+	glutKeyboardFunc(myKeyboard);
+	glutMouseFunc(myGridPaneMouse);
+	glutMotionFunc(myGridPaneMotion);
+	glutDisplayFunc(gridDisplayCB);
+	enableVsync();
+	
+	
+	glutSetWindow(gMainWindow);
+	gSubwindow[STATE_PANE] = glutCreateSubWindow(gMainWindow,
+												GRID_PANE_WIDTH + H_PADDING, 0,	//	origin
+												STATE_PANE_WIDTH, STATE_PANE_HEIGHT);
+    glViewport(0, 0, STATE_PANE_WIDTH, STATE_PANE_WIDTH);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+	glOrtho(0.0f, STATE_PANE_WIDTH, 0.0f, STATE_PANE_HEIGHT, -1, 1);
+	glClearColor(0.f, 0.f, 0.f, 1.f);
+	glutKeyboardFunc(myKeyboard);
+	glutMouseFunc(myStatePaneMouse);
+	glutDisplayFunc(stateDisplayCB);
+	enableVsync();
+}
@@ -0,0 +1,65 @@
+//
+//  gl_frontEnd.h
+//  GL threads
+//
+
+#ifndef GL_FRONT_END_H
+#define GL_FRONT_END_H
+
+#include <cstdint>
+//
+#include "glPlatform.h"
+#include "../Engine/cellEngine.h"
+
+
+//-----------------------------------------------------------------------------
+//	Custom data types
+//-----------------------------------------------------------------------------
+
+
+typedef enum ColorLabel {
+	BLACK_COL = 0,
+	WHITE_COL,
+	BLUE_COL,
+	GREEN_COL,
+	YELLOW_COL,
+	RED_COL,
+	//
+	NB_COLORS
+} ColorLabel;
+
+//	One color per cell state of the engine
+static_assert(NB_COLORS == NUM_CELL_STATES, "one color per cell state");
+
+//	The rules of the automaton are defined by the engine (cellEngine.h)
+
+//	Size of the pane that displays the grid, in pixels
+extern const int GRID_PANE_WIDTH, GRID_PANE_HEIGHT;
+
+//	Part of the cells passed to drawGrid() that fills the grid pane, in
+//	cells (with fractions), from the lower left corner.  Cells out of it are
+//	clipped.
+typedef struct GridWindow {
+	double row, col;
+	double numRows, numCols;
+} GridWindow;
+
+
+//-----------------------------------------------------------------------------
+//	Function prototypes
+//-----------------------------------------------------------------------------
+
+void drawGrid(const uint8_t* cells, unsigned int numRows, unsigned int numCols, unsigned long frameNumber,
+			  const GridWindow& window);
+void drawState(const char* strategy, unsigned int numLiveThreads, double achievedRate, double targetRate, const char* rateUnit,
+			   double frameMicroseconds, unsigned long rewindGenerations, double rewindMB, double rewindMaxMB);
+void initializeFrontEnd(int argc, char** argv, void (*gridCB)(void), void (*stateCB)(void));
+
+//	The panes are redrawn at most that many times per second (60 by default)
+void setMaxFrameRate(double framesPerSecond);
+
+//	Functions implemented in main.cpp but called by the glut callback functions
+void resetGrid(void);
+
+#endif // GL_FRONT_END_H
+
@@ -0,0 +1,1031 @@
+//
+//  main.cpp
+//  Cellular Automaton
+//
+//	Graphic (or headless) front end for the simulation engine of ../Engine
+//
+// Headless (no window, unthrottled):  ./cell <num_cols> <num_rows> <num_threads> -g <generations>
+//                                     ./cell <num_cols> <num_rows> <num_threads> -t <seconds>
+// Execution strategy (default banded): ./cell <num_cols> <num_rows> <num_threads> -s serial|banded|wavefront|async ...
+// Max frames per second (default 60):  ./cell <num_cols> <num_rows> <num_threads> -f <fps> ...
+// Control socket (window mode only):   ./cell <num_cols> <num_rows> <num_threads> -c <socket path> ...
+// Supervisor (many boards, no window): ./cell <num_cols> <num_rows> <num_threads> -m <socket path>
+// Checkpoints:                        ./cell <num_cols> <num_rows> <num_threads> -l <checkpoint to load> ...
+//                                     ./cell <num_cols> <num_rows> <num_threads> -w <checkpoint to write at exit and on 'w'> ...
+//                                     (a loaded checkpoint sets the size of the board)
+// Pattern (.rle or .mc) centered on an empty board:
+//                                     ./cell <num_cols> <num_rows> <num_threads> -p <pattern file> ...
+// Background checkpoints:             ./cell <num_cols> <num_rows> <num_threads> -i <every that many generations> [-o <directory>] ...
+// Recording of every generation:      ./cell <num_cols> <num_rows> <num_threads> -R <recording> [-k <keyframe interval>] ...
+// Start from a recorded generation:   ./cell <num_cols> <num_rows> <num_threads> -P <recording> [-G <generation>] ...
+//                                     (the board takes the size of the recording, and starts at its first
+//                                     generation by default)
+// Out-of-core board (grids in files):  ./cell <num_cols> <num_rows> <num_threads> -O <directory> [-M <memory budget in MB>] ...
+//                                     (serial or banded strategy; no background checkpoints)
+// Generations kept to step back through ('[' and ']', default 1000 with a window, none headless):
+//                                     ./cell <num_cols> <num_rows> <num_threads> -b <generations> ...
+// Ensemble (sweep, no window):         ./cell <num_cols> <num_rows> <num_threads> -e <csv path>
+//                                          [-r <rules, as 1,3>] [-d <densities, as 0.2,0.5>] [-n <seeds>] -g <generations>
+// g++ -Wall -std=c++20 main.cpp gl_frontEnd.cpp ../Engine/libcellengine.a -framework OpenGL -framework GLUT -o cell
+
+ /*-------------------------------------------------------------------------+
+ |	A graphic front end for a grid+state simulation.						|
+ |																			|
+ |	This application simply creates a glut window with a pane to display	|
+ |	a colored grid and the other to display some state information.			|
+ |	Sets up callback functions to handle menu, mouse and keyboard events.	|
+ |	All the simulation itself is done by a CellEngine.						|
+ |																			|
+ |	Current keyboard controls:												|
+ |																			|
+ |		- 'ESC' --> exit the application									|
+ |		- space bar --> resets the grid										|
+ |																			|
+ |		- 'c' --> toggle color mode on/off									|
+ |		- 'b' --> toggles color mode off/on									|
+ |		- 'l' --> toggles on/off grid line rendering						|
+ |																			|
+ |		- '+' --> increase simulation speed									|
+ |		- '-' --> reduce simulation speed									|
+ |		- 'u' --> toggle unthrottled simulation speed on/off				|
+ |		- '>' --> add a compute thread										|
+ |		- '<' --> remove a compute thread									|
+ |		- 's' --> switch to the next execution strategy						|
+ |		- 'z' --> zoom back out to the whole board							|
+ |		- 'w' --> write a checkpoint of the board (see -w)					|
+ |		- 'e' --> export the live part of the board to cell.rle				|
+ |		- '[' --> pause, and step back one generation (see -b)				|
+ |		- ']' --> pause, and step forward one generation					|
+ |		- 'p' --> pause / resume (from the generation shown)				|
+ |																			|
+ |		- mouse wheel in the grid pane --> zoom in/out around the mouse		|
+ |		- drag in the grid pane --> pan										|
+ |																			|
+ |		- '1' --> apply Rule 1 (Conway's classical Game of Life: B3/S23)	|
+ |		- '2' --> apply Rule 2 (Coral: B3/S45678)							|
+ |		- '3' --> apply Rule 3 (Amoeba: B357/S1358)							|
+ |		- '4' --> apply Rule 4 (Maze: B3/S12345)							|
+ |																			|
+ +-------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <iostream>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <time.h>
+//
+#include "gl_frontEnd.h"
+#include "../Engine/cellEngine.h"
+#include "../Engine/checkpoint.h"
+#include "../Engine/commandServer.h"
+#include "../Engine/ensemble.h"
+#include "../Engine/engineCommands.h"
+#include "../Engine/headless.h"
+#include "../Engine/supervisorCommands.h"
+
+//==================================================================================
+//	Function prototypes
+//==================================================================================
+void displayGridPane(void);
+void displayStatePane(void);
+void runHeadless(const HeadlessOptions& options);
+int runSupervisor(const char* socketPath, unsigned int numCols, unsigned int numRows, unsigned int numThreads);
+int runEnsembleSweep(const char* csvPath, EnsembleOptions* options, unsigned int numThreads);
+void saveBoard(void);
+void exportBoard(void);
+void reportBackgroundCheckpoints(void);
+void reportRecording(void);
+void stepBack(void);
+void stepForward(void);
+void togglePause(void);
+bool parseNumberList(const char* text, std::vector<double>* numbers);
+bool parseSize(const char* text, unsigned int* size);
+BoardView visibleView(void);
+GridWindow frameWindow(const ViewFrame& frame);
+void clampView(void);
+void resetView(void);
+void cleanupAndQuit(void);
+bool gridPaneChanged(void);
+bool statePaneChanged(void);
+std::string runCommand(const std::string& command);
+void runPendingCommands(void);
+
+//==================================================================================
+//	Application-level global variables
+//==================================================================================
+
+//	Don't touch
+extern int GRID_PANE, STATE_PANE;
+extern int gMainWindow, gSubwindow[2];
+extern int drawGridLines;
+
+//	The simulation
+CellEngine* engine;
+
+//	Paces the simulation at a target number of generations per second
+const double DEFAULT_GENERATION_RATE = 200.;
+
+//	Checkpoint written by the 'w' key when none was given with -w
+const char* DEFAULT_CHECKPOINT_PATH = "cell.ckpt";
+
+//	Pattern written by the 'e' key
+const char* DEFAULT_PATTERN_PATH = "cell.rle";
+
+//	-w: the board is saved there when the program quits
+const char* checkpointPath = NULL;
+
+//	-o: directory of the background checkpoints taken every -i generations
+const char* DEFAULT_CHECKPOINT_DIRECTORY = ".";
+
+//	-R: recording of the run, closed when the program quits
+const char* recordingPath = NULL;
+
+//	-b: generations kept in memory to step back through, when there is a
+//	window (none headless unless asked for)
+const long DEFAULT_REWIND_GENERATIONS = 1000;
+
+//	Control socket.  The commands that only concern the display are left
+//	for the glut thread, which owns it: these count the pending ones.
+CommandServer commandServer;
+std::atomic<unsigned int> pendingGridLineToggles(0), pendingViewResets(0);
+std::atomic<bool> pendingQuit(false);
+
+//	Part of the board shown in the grid pane: viewZoom times smaller than the
+//	board in each dimension (1: the whole board), with its lower left corner
+//	at cell (viewRow, viewCol).  viewChanged is set until the grid pane is
+//	redrawn for the new view.
+double viewRow = 0., viewCol = 0., viewZoom = 1.;
+bool viewChanged = true;
+
+//	The view never gets smaller than that many cells across
+const double MIN_VIEW_CELLS = 8.;
+
+//	What the state pane shows, sampled at most every STATE_PANE_PERIOD
+//	seconds, so that it is only redrawn when one of these changes (rates
+//	are rounded as they are shown)
+typedef struct StateInfo {
+	ExecutionStrategy strategy;
+	unsigned int numLiveThreads;
+	double measuredRate, targetRate;
+	double frameMicroseconds;
+	unsigned long rewindGenerations;
+	double rewindMB, rewindMaxMB;
+} StateInfo;
+const double STATE_PANE_PERIOD = 0.25;
+StateInfo shownState = {STRATEGY_BANDED, 0, 0., 0., 0., 0, 0., 0.};
+double stateSampleTime = 0.;
+
+//	Publication cost of the frames, as of the last sample
+unsigned long sampledFrames = 0;
+double sampledFrameSeconds = 0.;
+
+//==================================================================================
+//	These are the functions that tie the simulation with the rendering.
+//==================================================================================
+
+
+void displayGridPane(void)
+{
+	//	This is OpenGL/glut magic.  Don't touch
+	glutSetWindow(gSubwindow[GRID_PANE]);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	//---------------------------------------------------------
+	//	This is the call that makes OpenGL render the grid.
+	//	Only the visible part of the board is sent, with at most
+	//	one cell per pixel, as published by the engine: all its
+	//	cells belong to the same generation.
+	//---------------------------------------------------------
+	engine->setView(visibleView());
+	const ViewFrame& frame = engine->acquireFrame();
+	viewChanged = false;
+	drawGrid(frame.cells.data(), frame.numRows, frame.numCols, frame.sequence, frameWindow(frame));
+
+	//	This is OpenGL/glut magic.  Don't touch
+	glutSwapBuffers();
+	glutSetWindow(gMainWindow);
+}
+
+//	The part of the board the view covers, reduced to at most one cell per
+//	pixel of the pane.  Blocks are aligned on the board, so that they do
+//	not change as the view pans.
+BoardView visibleView(void)
+{
+	unsigned int boardRows = engine->numRows(), boardCols = engine->numCols();
+	unsigned int rows = (unsigned int) ceil(boardRows / viewZoom) + 1;
+	unsigned int cols = (unsigned int) ceil(boardCols / viewZoom) + 1;
+	unsigned int block = std::max({1u, (rows + GRID_PANE_HEIGHT - 1) / GRID_PANE_HEIGHT,
+									   (cols + GRID_PANE_WIDTH - 1) / GRID_PANE_WIDTH});
+	unsigned int row = (unsigned int) viewRow / block * block;
+	unsigned int col = (unsigned int) viewCol / block * block;
+
+	//	(clipped to the board by the engine)
+	return {row, col, rows + block, cols + block, block};
+}
+
+//	Part of the cells of a frame that the view covers.  The frame may have
+//	been made for an earlier view.
+GridWindow frameWindow(const ViewFrame& frame)
+{
+	const BoardView& view = frame.view;
+	return {(viewRow - view.row) / view.block, (viewCol - view.col) / view.block,
+			engine->numRows() / viewZoom / view.block, engine->numCols() / viewZoom / view.block};
+}
+
+void displayStatePane(void)
+{
+	//	This is OpenGL/glut magic.  Don't touch
+	glutSetWindow(gSubwindow[STATE_PANE]);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	//---------------------------------------------------------
+	//	This is the call that makes OpenGL render information
+	//	about the state of the simulation.
+	//
+	//---------------------------------------------------------
+	drawState(strategyName(shownState.strategy), shownState.numLiveThreads,
+			  shownState.measuredRate, shownState.targetRate, "gen/s", shownState.frameMicroseconds,
+			  shownState.rewindGenerations, shownState.rewindMB, shownState.rewindMaxMB);
+
+	//	This is OpenGL/glut magic.  Don't touch
+	glutSwapBuffers();
+	glutSetWindow(gMainWindow);
+}
+
+//	The grid pane only needs to be redrawn for a new frame of the engine,
+//	or to show the current one through another view
+bool gridPaneChanged(void)
+{
+	runPendingCommands();
+	return viewChanged || engine->frameReady();
+}
+
+//	Samples the numbers of the state pane (not too often) and tells whether
+//	any of them changed
+bool statePaneChanged(void)
+{
+	double now = headlessClock();
+	if (now - stateSampleTime < STATE_PANE_PERIOD)
+		return false;
+	stateSampleTime = now;
+
+	Pacer& pacer = engine->pacer();
+	StateInfo state = shownState;
+	state.strategy = engine->strategy();
+	state.numLiveThreads = engine->liveThreadCount();
+	state.measuredRate = round(10. * pacer.measuredRate()) / 10.;
+	state.targetRate = round(10. * pacer.rate()) / 10.;
+
+	//	average cost of the frames published since the last sample
+	unsigned long numFrames;
+	double frameSeconds;
+	engine->publicationCost(&numFrames, &frameSeconds);
+	if (numFrames > sampledFrames)
+		state.frameMicroseconds = round(1.e6 * (frameSeconds - sampledFrameSeconds) / (numFrames - sampledFrames));
+	sampledFrames = numFrames;
+	sampledFrameSeconds = frameSeconds;
+
+	RewindStats rewind;
+	engine->rewindBuffer().stats(&rewind);
+	state.rewindGenerations = rewind.numGenerations;
+	state.rewindMB = round(10. * rewind.bytes / (1 << 20)) / 10.;
+	state.rewindMaxMB = rewind.maxGenerations > 0 ? round((double) rewind.maxBytes / (1 << 20)) : 0.;
+
+	bool changed = state.strategy != shownState.strategy || state.numLiveThreads != shownState.numLiveThreads ||
+				   state.measuredRate != shownState.measuredRate || state.targetRate != shownState.targetRate ||
+				   state.frameMicroseconds != shownState.frameMicroseconds ||
+				   state.rewindGenerations != shownState.rewindGenerations || state.rewindMB != shownState.rewindMB ||
+				   state.rewindMaxMB != shownState.rewindMaxMB;
+	shownState = state;
+	return changed;
+}
+
+//	Runs a command of the control socket, in the thread of the server.  The
+//	engine's own commands run right away (the engine takes care of its
+//	locking), the display's are left for the glut thread.
+std::string runCommand(const std::string& command)
+{
+	std::string reply;
+	if (runEngineCommand(engine, command.c_str(), &reply))
+		return reply;
+
+	//	'l' and 'z' keys, and quitting (ESC)
+	if (command == "line")
+		pendingGridLineToggles++;
+	else if (command == "zoom out")
+		pendingViewResets++;
+	else if (command == "end" || command == "quit")
+		pendingQuit = true;
+	else
+		return "error unknown command: " + command;
+	return "ok";
+}
+
+//	Runs, in the glut thread, the display commands received since the last
+//	frame
+void runPendingCommands(void)
+{
+	if (pendingQuit)
+		cleanupAndQuit();
+
+	if (pendingGridLineToggles.exchange(0) % 2 != 0)
+	{
+		drawGridLines = !drawGridLines;
+		viewChanged = true;
+	}
+	if (pendingViewResets.exchange(0) > 0)
+		resetView();
+}
+
+//------------------------------------------------------------------------
+//	main function
+//------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    // Verify that three arguments (plus the optional ones) were passed
+    if (argc < 4)
+	{
+        std::cerr << "Usage: " << argv[0] << " <num_cols> <num_rows> <num_threads> [-s <strategy>] [-f <fps>] [-l <checkpoint>] [-w <checkpoint>] [-p <pattern>] [-i <generations> [-o <directory>]] [-R <recording> [-k <keyframe interval>]] [-P <recording> [-G <generation>]] [-b <generations>] [-O <directory> [-M <MB>]] [-c <socket> | -m <socket> | -e <csv> ...] " << HEADLESS_USAGE << "\n";
+        return 1;
+    }
+	ExecutionStrategy strategy = STRATEGY_BANDED;
+	double maxFrameRate = 0.;
+	const char* socketPath = NULL;
+	const char* supervisorPath = NULL;
+	const char* ensemblePath = NULL;
+	const char* loadPath = NULL;
+	const char* patternPath = NULL;
+	const char* checkpointDirectory = DEFAULT_CHECKPOINT_DIRECTORY;
+	long checkpointInterval = 0;
+	long keyframeInterval = DEFAULT_KEYFRAME_INTERVAL;
+	const char* playPath = NULL;
+	long playGeneration = -1;
+	long rewindGenerations = -1;
+	const char* backingDirectory = NULL;
+	long memoryBudgetMB = DEFAULT_MEMORY_BUDGET >> 20;
+	EnsembleOptions ensemble = {0, 0, FRAME_DEAD, false, {GAME_OF_LIFE_RULE}, {0.5}, 1, 1, 0};
+	std::vector<double> numbers;
+	int firstHeadlessArg = 4;
+	while (argc > firstHeadlessArg + 1)
+	{
+		if (strcmp(argv[firstHeadlessArg], "-s") == 0)
+		{
+			if (!parseStrategy(argv[firstHeadlessArg + 1], &strategy))
+			{
+				std::cerr << "Invalid arguments. The strategy must be serial, banded, wavefront, or async.\n";
+				return 1;
+			}
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-c") == 0)
+		{
+			socketPath = argv[firstHeadlessArg + 1];
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-m") == 0)
+		{
+			supervisorPath = argv[firstHeadlessArg + 1];
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-l") == 0)
+		{
+			loadPath = argv[firstHeadlessArg + 1];
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-w") == 0)
+		{
+			checkpointPath = argv[firstHeadlessArg + 1];
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-p") == 0)
+		{
+			patternPath = argv[firstHeadlessArg + 1];
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-i") == 0)
+		{
+			checkpointInterval = std::atol(argv[firstHeadlessArg + 1]);
+			if (checkpointInterval <= 0)
+			{
+				std::cerr << "Invalid arguments. The checkpoint interval must be a positive number of generations.\n";
+				return 1;
+			}
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-o") == 0)
+		{
+			checkpointDirectory = argv[firstHeadlessArg + 1];
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-R") == 0)
+		{
+			recordingPath = argv[firstHeadlessArg + 1];
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-k") == 0)
+		{
+			keyframeInterval = std::atol(argv[firstHeadlessArg + 1]);
+			if (keyframeInterval <= 0)
+			{
+				std::cerr << "Invalid arguments. The keyframe interval must be a positive number of generations.\n";
+				return 1;
+			}
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-P") == 0)
+		{
+			playPath = argv[firstHeadlessArg + 1];
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-G") == 0)
+		{
+			playGeneration = std::atol(argv[firstHeadlessArg + 1]);
+			if (playGeneration < 0)
+			{
+				std::cerr << "Invalid arguments. The generation must not be negative.\n";
+				return 1;
+			}
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-b") == 0)
+		{
+			rewindGenerations = std::atol(argv[firstHeadlessArg + 1]);
+			if (rewindGenerations < 0)
+			{
+				std::cerr << "Invalid arguments. The number of generations to keep must not be negative.\n";
+				return 1;
+			}
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-O") == 0)
+		{
+			backingDirectory = argv[firstHeadlessArg + 1];
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-M") == 0)
+		{
+			memoryBudgetMB = std::atol(argv[firstHeadlessArg + 1]);
+			if (memoryBudgetMB <= 0)
+			{
+				std::cerr << "Invalid arguments. The memory budget must be a positive number of MB.\n";
+				return 1;
+			}
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-e") == 0)
+		{
+			ensemblePath = argv[firstHeadlessArg + 1];
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-r") == 0)
+		{
+			ensemble.rules.clear();
+			bool valid = parseNumberList(argv[firstHeadlessArg + 1], &numbers);
+			for (double rule : numbers)
+			{
+				valid = valid && rule >= GAME_OF_LIFE_RULE && rule <= MAZE_RULE && rule == (unsigned int) rule;
+				ensemble.rules.push_back((unsigned int) rule);
+			}
+			if (!valid)
+			{
+				std::cerr << "Invalid arguments. The rules must be a list of 1, 2, 3, or 4.\n";
+				return 1;
+			}
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-d") == 0)
+		{
+			bool valid = parseNumberList(argv[firstHeadlessArg + 1], &ensemble.densities);
+			for (double density : ensemble.densities)
+				valid = valid && density >= 0. && density <= 1.;
+			if (!valid)
+			{
+				std::cerr << "Invalid arguments. The densities must be a list of numbers between 0 and 1.\n";
+				return 1;
+			}
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-n") == 0)
+		{
+			int numSeeds = std::atoi(argv[firstHeadlessArg + 1]);
+			if (numSeeds <= 0)
+			{
+				std::cerr << "Invalid arguments. The number of seeds must be positive.\n";
+				return 1;
+			}
+			ensemble.numSeeds = numSeeds;
+		}
+		else if (strcmp(argv[firstHeadlessArg], "-f") == 0)
+		{
+			maxFrameRate = std::atof(argv[firstHeadlessArg + 1]);
+			if (maxFrameRate <= 0.)
+			{
+				std::cerr << "Invalid arguments. The frame rate must be positive.\n";
+				return 1;
+			}
+		}
+		else
+			break;
+		firstHeadlessArg += 2;
+	}
+	HeadlessOptions headless;
+	if (!parseHeadlessOptions(argc, argv, firstHeadlessArg, &headless))
+		return 1;
+
+    // Parse arguments and check for validity
+    unsigned int num_cols, num_rows, num_threads;
+	if (!parseSize(argv[1], &num_cols) || !parseSize(argv[2], &num_rows) || !parseSize(argv[3], &num_threads))
+	{
+		std::cerr << "Invalid arguments. num_cols, num_rows and num_threads must be whole numbers no larger than " << UINT_MAX << ".\n";
+		return 1;
+	}
+
+	//	The board takes the size of the checkpoint
+	CheckpointHeader checkpoint;
+	if (loadPath != NULL)
+	{
+		int fd = openCheckpoint(loadPath, &checkpoint);
+		if (fd < 0)
+		{
+			std::cerr << "Cannot load " << loadPath << ": " << strerror(errno) << "\n";
+			return 1;
+		}
+		close(fd);
+		num_cols = checkpoint.numCols;
+		num_rows = checkpoint.numRows;
+	}
+
+	//	and so does the recording to start from
+	Player player;
+	if (playPath != NULL)
+	{
+		if (!player.open(playPath))
+		{
+			std::cerr << "Cannot play " << playPath << ": " << strerror(errno) << "\n";
+			return 1;
+		}
+		num_cols = player.numCols();
+		num_rows = player.numRows();
+		if (playGeneration < 0)
+			playGeneration = player.firstGeneration();
+		player.close();
+	}
+
+    if (num_cols <= 5 || num_rows <= 5 || num_threads == 0 || num_threads > num_rows ||
+		num_threads > MAX_NUM_THREADS)
+	{
+        std::cerr << "Invalid arguments. num_cols and num_rows must be larger than 5, and num_threads must be positive and not exceed num_rows (or " << MAX_NUM_THREADS << ").\n";
+        return 1;
+    }
+
+	if (supervisorPath != NULL)
+		return runSupervisor(supervisorPath, num_cols, num_rows, num_threads);
+	if (ensemblePath != NULL)
+	{
+		if (headless.generations == 0)
+		{
+			std::cerr << "Invalid arguments. An ensemble needs a number of generations (-g).\n";
+			return 1;
+		}
+		ensemble.numCols = num_cols;
+		ensemble.numRows = num_rows;
+		ensemble.maxGenerations = headless.generations;
+		ensemble.firstSeed = (unsigned int) time(NULL);
+		return runEnsembleSweep(ensemblePath, &ensemble, num_threads);
+	}
+
+	engine = new CellEngine(num_cols, num_rows, num_threads);
+	engine->setStrategy(strategy);
+	if (backingDirectory != NULL)
+	{
+		if (checkpointInterval > 0)
+		{
+			std::cerr << "Invalid arguments. Background checkpoints (-i) are not available for a board in files (-O).\n";
+			return 1;
+		}
+		if (!engine->backWithFiles(backingDirectory, (size_t) memoryBudgetMB << 20))
+		{
+			std::cerr << "Cannot create the grids in " << backingDirectory << ": " << strerror(errno) << "\n";
+			return 1;
+		}
+		if (strategy == STRATEGY_WAVEFRONT || strategy == STRATEGY_ASYNC)
+			std::cerr << "The " << strategyName(strategy) << " strategy does not go through the board in order: "
+					  << "only the serial and banded ones keep a board in files within its memory budget.\n";
+	}
+	if (loadPath == NULL && patternPath == NULL && playPath == NULL)
+		engine->randomize((unsigned int) time(NULL));
+	else if (loadPath != NULL && !engine->loadCheckpoint(loadPath))
+	{
+		std::cerr << "Cannot load " << loadPath << ": " << strerror(errno) << "\n";
+		return 1;
+	}
+	if (playPath != NULL)
+	{
+		double startTime = headlessClock();
+		if (!engine->loadRecordedGeneration(playPath, playGeneration))
+		{
+			std::cerr << "Cannot play generation " << playGeneration << " of " << playPath << ": "
+					  << strerror(errno) << "\n";
+			return 1;
+		}
+		std::cout << "Decoded generation " << playGeneration << " of " << playPath << " in "
+				  << headlessClock() - startTime << " s\n";
+	}
+	if (patternPath != NULL)
+	{
+		Pattern pattern;
+		double startTime = headlessClock();
+		if (!pattern.read(patternPath))
+		{
+			std::cerr << "Cannot read " << patternPath << ": " << strerror(errno) << "\n";
+			return 1;
+		}
+		engine->placePattern(pattern, ((int64_t) num_rows - (int64_t) pattern.numRows()) / 2,
+							 ((int64_t) num_cols - (int64_t) pattern.numCols()) / 2);
+		std::cout << "Placed " << pattern.numCols() << " x " << pattern.numRows() << " pattern in "
+				  << headlessClock() - startTime << " s\n";
+	}
+	engine->backgroundSaver().setSchedule(checkpointDirectory, checkpointInterval);
+	if (checkpointInterval > 0 && (strategy == STRATEGY_WAVEFRONT || strategy == STRATEGY_ASYNC))
+		std::cerr << "The " << strategyName(strategy) << " strategy has no generation boundaries: "
+				  << "checkpoints are only taken in the background with the serial and banded ones.\n";
+	if (recordingPath != NULL)
+	{
+		if (!engine->startRecording(recordingPath, keyframeInterval))
+		{
+			std::cerr << "Cannot record to " << recordingPath << ": " << strerror(errno) << "\n";
+			return 1;
+		}
+		if (strategy == STRATEGY_WAVEFRONT || strategy == STRATEGY_ASYNC)
+			std::cerr << "The " << strategyName(strategy) << " strategy has no generation boundaries: "
+					  << "generations are only recorded with the serial and banded ones.\n";
+	}
+
+	if (rewindGenerations < 0)
+		rewindGenerations = headless.enabled ? 0 : DEFAULT_REWIND_GENERATIONS;
+	engine->setRewindDepth(rewindGenerations);
+
+	if (headless.enabled)
+	{
+		runHeadless(headless);
+		if (checkpointPath != NULL)
+			saveBoard();
+		reportBackgroundCheckpoints();
+		reportRecording();
+		delete engine;
+		return 0;
+	}
+
+	//	This takes care of initializing glut and the GUI.
+	initializeFrontEnd(argc, argv, displayGridPane, displayStatePane);
+	if (maxFrameRate > 0.)
+		setMaxFrameRate(maxFrameRate);
+	if (socketPath != NULL && !commandServer.start(socketPath, runCommand))
+	{
+		std::cerr << "Cannot listen on " << socketPath << ": " << strerror(errno) << "\n";
+		return 1;
+	}
+
+	//	The compute threads run in the background until we quit
+	engine->pacer().setRate(DEFAULT_GENERATION_RATE);
+	engine->run();
+
+	//	Now we enter the main loop of the program and to a large extend
+	//	"lose control" over its execution.  The callback functions that
+	//	we set up earlier will be called when the corresponding event
+	//	occurs
+	glutMainLoop();
+
+	//	This will never be executed (the exit point will be in one of the
+	//	call back functions).
+	return 0;
+}
+
+
+//==================================================================================
+//
+//	Functions called by the front end
+//
+//==================================================================================
+
+void cleanupAndQuit(void)
+{
+	//	No more commands, then stop and join the compute threads before
+	//	freeing the grids
+	commandServer.stop();
+	if (checkpointPath != NULL)
+		saveBoard();
+	reportBackgroundCheckpoints();
+	reportRecording();
+	delete engine;
+
+	exit(0);
+}
+
+
+//	Hosts any number of boards, with no window, all computed by one pool of
+//	numThreads threads, and controlled through a socket (see
+//	../Engine/supervisorCommands.h).  Starts with one board, of index 1.
+//	Returns when a client sends "end".
+int runSupervisor(const char* socketPath, unsigned int numCols, unsigned int numRows, unsigned int numThreads)
+{
+	Supervisor supervisor(numThreads);
+	std::string reply;
+	std::string launch = "launch " + std::to_string(numCols) + " " + std::to_string(numRows);
+	runSupervisorCommand(&supervisor, launch.c_str(), &reply);
+
+	std::atomic<bool> quit(false);
+	CommandServer server;
+	bool listening = server.start(socketPath, [&supervisor, &quit](const std::string& command) {
+		std::string reply;
+		if (runSupervisorCommand(&supervisor, command.c_str(), &reply))
+			return reply;
+		if (command != "end" && command != "quit")
+			return "error unknown command: " + command;
+		quit = true;
+		quit.notify_one();
+		return std::string("ok");
+	});
+	if (!listening)
+	{
+		std::cerr << "Cannot listen on " << socketPath << ": " << strerror(errno) << "\n";
+		return 1;
+	}
+
+	quit.wait(false);
+	server.stop();
+	return 0;
+}
+
+
+//	Runs all the boards of a parameter sweep, writes their statistics to
+//	a CSV file, and reports the throughput
+int runEnsembleSweep(const char* csvPath, EnsembleOptions* options, unsigned int numThreads)
+{
+	FILE* csv = fopen(csvPath, "w");
+	if (csv == NULL)
+	{
+		std::cerr << "Cannot write " << csvPath << ": " << strerror(errno) << "\n";
+		return 1;
+	}
+
+	std::vector<BoardStats> stats;
+	double wallSeconds = runEnsemble(*options, numThreads, &stats);
+	writeEnsembleCsv(csv, stats);
+	fclose(csv);
+
+	printEnsembleReport(*options, numThreads, stats, wallSeconds);
+	return 0;
+}
+
+
+//	Comma-separated list of numbers
+bool parseNumberList(const char* text, std::vector<double>* numbers)
+{
+	numbers->clear();
+	while (true)
+	{
+		char* end;
+		double number = strtod(text, &end);
+		if (end == text || (*end != ',' && *end != '\0'))
+			return false;
+		numbers->push_back(number);
+		if (*end == '\0')
+			return true;
+		text = end + 1;
+	}
+}
+
+
+//	A board dimension or a number of threads: a whole number that fits in
+//	an unsigned int (which std::atoi would silently wrap or truncate)
+bool parseSize(const char* text, unsigned int* size)
+{
+	char* end;
+	errno = 0;
+	unsigned long value = strtoul(text, &end, 10);
+	if (end == text || *end != '\0' || text[0] == '-' || errno != 0 || value > UINT_MAX)
+		return false;
+	*size = (unsigned int) value;
+	return true;
+}
+
+
+//	Runs the simulation without any window and as fast as possible, for
+//	a number of generations or a duration, then reports the throughput.
+void runHeadless(const HeadlessOptions& options)
+{
+	//	(a loaded board starts at the generation it was saved at)
+	unsigned long startGeneration = engine->generation();
+	double startTime = headlessClock();
+
+	if (options.generations > 0)
+	{
+		engine->step(options.generations);
+	}
+	else
+	{
+		engine->pacer().setRate(0.);
+		engine->run();
+		while (headlessClock() - startTime < options.seconds)
+			usleep(1000);
+		engine->pause();
+	}
+	double wallTime = headlessClock() - startTime;
+
+	printf("strategy:       %s\n", strategyName(engine->strategy()));
+	printHeadlessReport(engine->numCols(), engine->numRows(),
+						engine->strategy() == STRATEGY_SERIAL ? 1 : engine->numThreads(),
+						engine->generation() - startGeneration, wallTime);
+}
+
+
+//	Writes a checkpoint of the board to the -w path (or the default one)
+void saveBoard(void)
+{
+	const char* path = checkpointPath != NULL ? checkpointPath : DEFAULT_CHECKPOINT_PATH;
+	double startTime = headlessClock();
+	if (engine->saveCheckpoint(path))
+		std::cout << "Saved generation " << engine->generation() << " to " << path << " in "
+				  << headlessClock() - startTime << " s\n";
+	else
+		std::cerr << "Cannot save " << path << ": " << strerror(errno) << "\n";
+}
+
+
+//	Writes the live part of the board as an RLE pattern
+void exportBoard(void)
+{
+	if (engine->savePattern(DEFAULT_PATTERN_PATH, PATTERN_RLE))
+		std::cout << "Exported generation " << engine->generation() << " to " << DEFAULT_PATTERN_PATH << "\n";
+	else
+		std::cerr << "Cannot export " << DEFAULT_PATTERN_PATH << ": " << strerror(errno) << "\n";
+}
+
+
+//	Background checkpoints taken so far, if any, and how long they held up
+//	the compute threads.  A checkpoint still being written is waited for
+//	when the engine goes away.
+void reportBackgroundCheckpoints(void)
+{
+	BackgroundSaverStats stats;
+	engine->backgroundSaver().stats(&stats);
+	if (stats.numStarted == 0 && stats.numFailed == 0)
+		return;
+
+	printf("checkpoints:    %lu started, %lu saved, %lu failed, %lu skipped%s\n", stats.numStarted,
+		   stats.numSaved, stats.numFailed, stats.numSkipped, stats.writing ? " (one still being written)" : "");
+	if (stats.lastError != 0)
+		printf("last error:     %s\n", strerror(stats.lastError));
+	if (stats.numStarted > 0)
+		printf("fork pauses:    %.3f ms mean, %.3f ms max\n", 1000. * stats.totalPause / stats.numStarted,
+			   1000. * stats.maxPause);
+}
+
+
+//	Closes the recording, if any, and tells how much it took: of disk, and
+//	of the time of the compute threads
+void reportRecording(void)
+{
+	RecorderStats stats;
+	engine->recorder().stats(&stats);
+	if (!stats.recording)
+		return;
+	bool closed = engine->stopRecording();
+	int error = errno;
+	engine->recorder().stats(&stats);
+
+	printf("recording:      %lu generations (%lu keyframes) up to generation %lu, in %s\n", stats.numRecords,
+		   stats.numKeyframes, stats.lastGeneration, recordingPath != NULL ? recordingPath : "the recording");
+	printf("recorded size:  %.1f MB, for %.1f MB of boards (%.1f%%)\n", stats.fileBytes / 1e6, stats.rawBytes / 1e6,
+		   stats.rawBytes > 0 ? 100. * stats.fileBytes / stats.rawBytes : 0.);
+	printf("recording time: %.3f s encoding (all threads), %.3f s waiting for the disk\n", stats.encodeTime,
+		   stats.stallTime);
+	if (!closed)
+		printf("last error:     %s\n", strerror(error));
+}
+
+
+//	The generations kept in memory: '[' and ']' pause the engine and go
+//	through them, and 'p' resumes from the one shown
+void stepBack(void)
+{
+	if (!engine->stepBack())
+		std::cerr << "No earlier generation kept to go back to\n";
+}
+
+
+void stepForward(void)
+{
+	if (!engine->stepForward())
+		std::cerr << "No later generation kept to go forward to\n";
+}
+
+
+void togglePause(void)
+{
+	if (engine->isRunning())
+		engine->pause();
+	else
+		engine->run();
+}
+
+
+void resetGrid(void)
+{
+	engine->randomize((unsigned int) time(NULL) + (unsigned int) engine->generation());
+}
+
+
+void setRule(unsigned int rule)
+{
+	engine->setRule(rule);
+}
+
+
+void toggleColorMode(void)
+{
+	engine->setColorMode(!engine->colorMode());
+}
+
+
+//	Speed changes are 10% of the target generation rate.  They have no
+//	effect while the simulation is unthrottled.
+void faster(void)
+{
+	Pacer& pacer = engine->pacer();
+	if (!pacer.isUnthrottled())
+		pacer.setRate(11 * pacer.rate() / 10);
+}
+
+
+void slower(void)
+{
+	Pacer& pacer = engine->pacer();
+	if (!pacer.isUnthrottled())
+		pacer.setRate(9 * pacer.rate() / 10);
+}
+
+
+void toggleUnthrottled(void)
+{
+	engine->pacer().toggleUnthrottled();
+}
+
+
+void moreThreads(void)
+{
+	engine->setNumThreads(engine->numThreads() + 1);
+}
+
+
+void fewerThreads(void)
+{
+	if (engine->numThreads() > 1)
+		engine->setNumThreads(engine->numThreads() - 1);
+}
+
+
+//	Switches live, on the current board, so that the throughput of the
+//	strategies can be compared
+void nextStrategy(void)
+{
+	engine->setStrategy((ExecutionStrategy) ((engine->strategy() + 1) % NUM_STRATEGIES));
+}
+
+
+//	Zooms in (factor > 1) or out around the point (x, y) of the grid pane,
+//	given as fractions of its width and height (from its lower left corner).
+//	The cell under that point stays in place.
+void zoomView(double factor, double x, double y)
+{
+	double boardRows = engine->numRows(), boardCols = engine->numCols();
+	double maxZoom = std::max(1., std::min(boardRows, boardCols) / MIN_VIEW_CELLS);
+
+	double row = viewRow + y * boardRows / viewZoom;
+	double col = viewCol + x * boardCols / viewZoom;
+	viewZoom = std::clamp(viewZoom * factor, 1., maxZoom);
+	viewRow = row - y * boardRows / viewZoom;
+	viewCol = col - x * boardCols / viewZoom;
+	clampView();
+}
+
+
+//	Moves the view by (dx, dy), in fractions of the width and height of the
+//	grid pane
+void panView(double dx, double dy)
+{
+	viewRow += dy * engine->numRows() / viewZoom;
+	viewCol += dx * engine->numCols() / viewZoom;
+	clampView();
+}
+
+
+void resetView(void)
+{
+	viewRow = viewCol = 0.;
+	viewZoom = 1.;
+	viewChanged = true;
+}
+
+
+//	Keeps the view within the board
+void clampView(void)
+{
+	viewRow = std::clamp(viewRow, 0., engine->numRows() * (1. - 1. / viewZoom));
+	viewCol = std::clamp(viewCol, 0., engine->numCols() * (1. - 1. / viewZoom));
+	viewChanged = true;
+}
@@ -1,7 +1,10 @@
 //
 //  main.c
 //  Cellular Automaton
-// g++ -Wall -std=c++20 main.cpp gl_frontEnd.cpp -framework OpenGL -framework GLUT -o cell
+//
+// Headless (no window, unthrottled):  ./cell <num_cols> <num_rows> <num_threads> -g <generations>
+//                                     ./cell <num_cols> <num_rows> <num_threads> -t <seconds>
+// g++ -Wall -std=c++20 main.cpp gl_frontEnd.cpp ../Engine/libcellengine.a -framework OpenGL -framework GLUT -o cell
 
  /*-------------------------------------------------------------------------+
  |	A graphic front end for a grid+state simulation.						|
@@ -42,6 +45,7 @@
 #include <cstdlib>
 //
 #include "gl_frontEnd.h"
+#include "../Engine/headless.h"
 
 //==================================================================================
 //	Custom data types
@@ -59,6 +63,7 @@ using ThreadInfo = struct
 void displayGridPane(void);
 void displayStatePane(void);
 void initializeApplication(void);
+void runHeadless(const HeadlessOptions& options);
 void* threadFunc(void*);
 void swapGrids(void);
 unsigned int cellNewState(unsigned int i, unsigned int j);
@@ -112,6 +117,10 @@ unsigned int colorMode = 0;
 
 ThreadInfo* info;
 
+//	In headless mode generations are computed back to back, without the
+//	rendering loop and without the pause after each of them
+bool headlessRun = false;
+
 
 //==================================================================================
 //	These are the functions that tie the simulation with the rendering.
@@ -165,11 +174,14 @@ void displayStatePane(void)
 
 int main(int argc, char** argv)
 {
-    // Verify that three arguments were passed
-    if (argc != 4) {
-        std::cerr << "Usage: " << argv[0] << " <num_cols> <num_rows> <num_threads>\n";
+    // Verify that three arguments (plus the optional headless ones) were passed
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <num_cols> <num_rows> <num_threads> " << HEADLESS_USAGE << "\n";
         return 1;
     }
+	HeadlessOptions headless;
+	if (!parseHeadlessOptions(argc, argv, 4, &headless))
+		return 1;
 
     // Parse arguments and check for validity
     num_cols = std::atoi(argv[1]);
@@ -198,6 +210,12 @@ int main(int argc, char** argv)
         }
 	}
 
+	if (headless.enabled)
+	{
+		runHeadless(headless);
+		return 0;
+	}
+
     // This takes care of initializing glut and the GUI.
     // You shouldn’t have to touch this
     initializeFrontEnd(argc, argv, displayGridPane, displayStatePane);
@@ -241,6 +259,28 @@ void cleanupAndQuit(void)
 }
 
 
+//	Runs the simulation without any window and as fast as possible, for
+//	a number of generations or a duration, then reports the throughput.
+//	The generations are driven from here instead of the glut timer.
+void runHeadless(const HeadlessOptions& options)
+{
+	headlessRun = true;
+	initializeApplication();
+
+	double startTime = headlessClock();
+	unsigned long numGenerations = 0;
+	while (options.generations > 0 ? numGenerations < options.generations :
+									 headlessClock() - startTime < options.seconds)
+	{
+		generationVI();
+		numGenerations++;
+	}
+	double wallTime = headlessClock() - startTime;
+
+	printHeadlessReport(num_cols, num_rows, num_threads, numGenerations, wallTime);
+}
+
+
 void initializeApplication(void)
 {
     //  Allocate 2D grids
@@ -310,7 +350,8 @@ void* threadFunc(void* arg)
 
 	oneGeneration();
 
-	usleep(5000);
+	if (!headlessRun)
+		usleep(5000);
 	return NULL;
 }
 
@@ -373,7 +414,8 @@ void generationVI(void)
 
 		swapGrids();
 
-		usleep(5000);
+		if (!headlessRun)
+			usleep(5000);
 		
 	#endif
 
@@ -39,7 +39,7 @@ typedef enum ColorLabel {
 //-----------------------------------------------------------------------------
 
 void drawGrid(unsigned int**grid, unsigned int numRows, unsigned int numCols);
-void drawState(unsigned int numLiveThreads);
+void drawState(unsigned int numLiveThreads, double achievedRate, double targetRate, const char* rateUnit);
 void initializeFrontEnd(int argc, char** argv, void (*gridCB)(void), void (*stateCB)(void));
 
 //	Functions implemented in main.c but called byt the glut callback functions
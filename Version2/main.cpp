@@ -1,7 +1,10 @@
 //
 //  main.c
 //  Cellular Automaton
-// g++ -Wall -std=c++20 main.cpp gl_frontEnd.cpp -framework OpenGL -framework GLUT -o cell
+//
+// Headless (no window, unthrottled):  ./cell <num_cols> <num_rows> <num_threads> -g <generations>
+//                                     ./cell <num_cols> <num_rows> <num_threads> -t <seconds>
+// g++ -Wall -std=c++20 main.cpp gl_frontEnd.cpp ../Engine/libcellengine.a -framework OpenGL -framework GLUT -o cell
 
  /*-------------------------------------------------------------------------+
  |	A graphic front end for a grid+state simulation.						|
@@ -26,6 +29,9 @@
  |																			|
  |		- '+' --> increase simulation speed									|
  |		- '-' --> reduce simulation speed									|
+ |		- 'u' --> toggle unthrottled simulation speed on/off				|
+ |		- '>' --> add a compute thread (at the next generation)				|
+ |		- '<' --> remove a compute thread (at the next generation)			|
  |																			|
  |		- '1' --> apply Rule 1 (Conway's classical Game of Life: B3/S23)	|
  |		- '2' --> apply Rule 2 (Coral: B3/S45678)							|
@@ -39,19 +45,15 @@
 #include <cstdlib>
 #include <unistd.h>
 #include <time.h>
-#include <pthread.h>
+#include <stop_token>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 //
 #include "gl_frontEnd.h"
-
-//==================================================================================
-//	Custom data types
-//==================================================================================
-using ThreadInfo = struct {
-	pthread_t id;
-	unsigned int index;
-	unsigned int start_row, end_row;
-	pthread_mutex_t lock;
-};
+#include "../Engine/workerPool.h"
+#include "../Engine/pacer.h"
+#include "../Engine/headless.h"
 
 
 //==================================================================================
@@ -60,10 +62,21 @@ using ThreadInfo = struct {
 void displayGridPane(void);
 void displayStatePane(void);
 void initializeApplication(void);
-void* threadFunc(void*);
+void runHeadless(const HeadlessOptions& options);
+void threadFunc(unsigned int index, unsigned int count, std::stop_token stop);
+void wavefrontThreadFunc(unsigned int index, unsigned int count, std::stop_token stop);
+bool endOfGeneration(bool completed);
 void swapGrids(void);
-unsigned int cellNewState(unsigned int i, unsigned int j);
-void createThreads(void);
+void bandRows(unsigned int index, unsigned int count, unsigned int* start_row, unsigned int* end_row);
+bool computeRows(unsigned int** src, unsigned int** dst, unsigned int start_row, unsigned int end_row,
+				 std::stop_token stop);
+bool waitForBand(unsigned int band, unsigned int gen, std::stop_token stop);
+void realignBands(unsigned int count);
+void resetBands(void);
+unsigned int cellNewState(unsigned int** grid, unsigned int i, unsigned int j);
+void requestThreadCount(unsigned int n);
+void moreThreads(void);
+void fewerThreads(void);
 
 //==================================================================================
 //	Precompiler #define to let us specify how things should be handled at the
@@ -78,6 +91,17 @@ void createThreads(void);
 //	Pick one value for FRAME_BEHAVIOR
 #define FRAME_BEHAVIOR	FRAME_DEAD
 
+//==================================================================================
+//	Precompiler #define to let us specify how the threads synchronize between
+//	two generations
+//==================================================================================
+
+#define SYNC_BARRIER	0	//	all threads meet at the pool's barrier after each generation
+#define SYNC_WAVEFRONT	1	//	a band only waits for its two neighbor bands
+
+//	Pick one value for SYNC_MODE
+#define SYNC_MODE	SYNC_BARRIER
+
 //==================================================================================
 //	Application-level global variables
 //==================================================================================
@@ -98,21 +122,49 @@ unsigned int** nextGrid;
 //	spot accidental row-col inversion bugs.
 unsigned int num_rows, num_cols;
 
-//	the number of live threads (that haven't terminated yet)
+//	the number of compute threads.  The number of live threads (that
+//	haven't terminated yet) is tracked by the pool itself.
 unsigned int num_threads;
-unsigned int numLiveThreads = 0;
+
+//	Upper bound on the size of the thread pool
+const int MAX_NUM_THREADS = 256;
+
+//	The persistent compute threads.  Each one handles a band of rows,
+//	and they all meet at the pool's barrier at the end of a generation.
+WorkerPool pool;
 
 unsigned int rule = GAME_OF_LIFE_RULE;
-unsigned int speed = 5000;
 
-unsigned int colorMode = 0;
+//	Paces the simulation at a target number of generations per second
+const double DEFAULT_GENERATION_RATE = 200.;
+Pacer pacer(DEFAULT_GENERATION_RATE);
 
-ThreadInfo* thread_data;
+unsigned int colorMode = 0;
 
 int generation = 0;
 
-unsigned int done = 0;
-pthread_mutex_t counter_lock;
+//	In headless mode, the number of generations to run (0 to run until
+//	the pool is stopped)
+unsigned long maxGenerations = 0;
+
+//	Wavefront synchronization.  A band computes its first and last rows
+//	(the halo rows of its neighbors) before its interior, and publishes
+//	them right away in bandSync[k].edgeGeneration.  A band may compute
+//	generation g+1 as soon as its two neighbors have published the edge
+//	rows of generation g, even if they are still busy with their interior.
+//	bandSync[k].generation is the last generation the band fully completed.
+//	Generation g of a band lives in wfGrid[g%2].  Bands can drift apart (by
+//	at most one generation between neighbors), so the display goes through
+//	displayRows, which points to the latest published version of each row.
+using BandSync = struct alignas(64) {
+	std::atomic<unsigned int> generation;
+	std::atomic<unsigned int> edgeGeneration;
+	std::mutex lock;
+	std::condition_variable_any published;
+};
+BandSync* bandSync;
+unsigned int** wfGrid[2];
+unsigned int** displayRows;
 
 //==================================================================================
 //	These are the functions that tie the simulation with the rendering.
@@ -133,7 +185,11 @@ void displayGridPane(void)
 	//	This is the call that makes OpenGL render the grid.
 	//
 	//---------------------------------------------------------
-	drawGrid(currentGrid, num_rows, num_cols);
+	#if SYNC_MODE == SYNC_WAVEFRONT
+		drawGrid(displayRows, num_rows, num_cols);
+	#else
+		drawGrid(currentGrid, num_rows, num_cols);
+	#endif
 	
 	//	This is OpenGL/glut magic.  Don't touch
 	glutSwapBuffers();
@@ -153,7 +209,7 @@ void displayStatePane(void)
 	//	about the state of the simulation.
 	//
 	//---------------------------------------------------------
-	drawState(numLiveThreads);
+	drawState(pool.liveCount(), pacer.measuredRate(), pacer.rate(), "gen/s");
 	
 	
 	//	This is OpenGL/glut magic.  Don't touch
@@ -165,24 +221,34 @@ void displayStatePane(void)
 //	You shouldn't have to change anything in the main function
 //------------------------------------------------------------------------
 int main(int argc, char** argv) {
-    // Verify that three arguments were passed
-    if (argc != 4) 
+    // Verify that three arguments (plus the optional headless ones) were passed
+    if (argc < 4) 
 	{
-        std::cerr << "Usage: " << argv[0] << " <num_cols> <num_rows> <num_threads>\n";
+        std::cerr << "Usage: " << argv[0] << " <num_cols> <num_rows> <num_threads> " << HEADLESS_USAGE << "\n";
         return 1;
     }
+	HeadlessOptions headless;
+	if (!parseHeadlessOptions(argc, argv, 4, &headless))
+		return 1;
 
     // Parse arguments and check for validity
     num_cols = std::atoi(argv[1]);
     num_rows = std::atoi(argv[2]);
     num_threads = std::atoi(argv[3]);
 
-    if (num_cols <= 5 || num_rows <= 5 || num_threads <= 0 || num_threads > num_rows) 
+    if (num_cols <= 5 || num_rows <= 5 || num_threads <= 0 || num_threads > num_rows ||
+		num_threads > MAX_NUM_THREADS) 
 	{
-        std::cerr << "Invalid arguments. num_cols and num_rows must be larger than 5, and num_threads must be positive and not exceed num_rows.\n";
+        std::cerr << "Invalid arguments. num_cols and num_rows must be larger than 5, and num_threads must be positive and not exceed num_rows (or " << MAX_NUM_THREADS << ").\n";
         return 1;
     }
 
+	if (headless.enabled)
+	{
+		runHeadless(headless);
+		return 0;
+	}
+
 	//	This takes care of initializing glut and the GUI.
 	//	You shouldn’t have to touch this
 	initializeFrontEnd(argc, argv, displayGridPane, displayStatePane);
@@ -191,34 +257,12 @@ int main(int argc, char** argv) {
 	initializeApplication();
 
 	//	Now would be the place & time to create mutex locks and threads
-	// createThreads();
-	pthread_mutex_init(&counter_lock, nullptr);
-	
-	// initialize array of ThreadInfo structs
-	thread_data = (ThreadInfo*) calloc(num_threads, sizeof(ThreadInfo)); 
-	
-	unsigned int row_per_thread = num_rows / num_threads;
+	#if SYNC_MODE == SYNC_WAVEFRONT
+		pool.start(num_threads, wavefrontThreadFunc, endOfGeneration);
+	#else
+		pool.start(num_threads, threadFunc, endOfGeneration);
+	#endif
 
-	for (unsigned int k = 0; k < num_threads; k++) 
-	{
-		thread_data[k].index = k;
-		thread_data[k].start_row = k * row_per_thread;
-		thread_data[k].end_row = (k + 1) * row_per_thread;
-
-        if (k == num_threads - 1) 
-            thread_data[k].end_row = num_rows;
-
-		pthread_mutex_init(&(thread_data[k].lock), nullptr);
-		pthread_mutex_lock(&(thread_data[k].lock));
-	}
-
-	for (unsigned int k = 0; k < num_threads; k++) 
-	{
-		int code = pthread_create(&(thread_data[k].id), nullptr, threadFunc, &(thread_data[k]));
-		if (code < 0)
-			std::cerr << "Thread creation failed " << code << std::endl;
-		else numLiveThreads++;  
-	}
 	//	Now we enter the main loop of the program and to a large extend
 	//	"lose control" over its execution.  The callback functions that 
 	//	we set up earlier will be called when the corresponding event
@@ -242,18 +286,51 @@ void cleanupAndQuit(void)
 	//	Free allocated resource before leaving (not absolutely needed, but
 	//	just nicer.  Also, if you crash there, you know something is wrong
 	//	in your code.
-    for (unsigned int i=1; i<num_rows; i++)
+
+	//	Stop and join the compute threads before their grids go away
+	pool.stop();
+
+    for (unsigned int i=0; i<num_rows; i++)
     {
         delete []currentGrid[i];
         delete []nextGrid[i];
     }
 	delete []currentGrid;
 	delete []nextGrid;
+	delete []displayRows;
+	delete []bandSync;
 
 	exit(0);
 }
 
 
+//	Runs the simulation without any window and as fast as possible, for
+//	a number of generations or a duration, then reports the throughput.
+void runHeadless(const HeadlessOptions& options)
+{
+	initializeApplication();
+	pacer.setRate(0.);
+	maxGenerations = options.generations;
+
+	double startTime = headlessClock();
+	pool.start(num_threads, SYNC_MODE == SYNC_WAVEFRONT ? wavefrontThreadFunc : threadFunc, endOfGeneration);
+
+	if (maxGenerations > 0)
+	{
+		pool.wait();
+	}
+	else
+	{
+		while (headlessClock() - startTime < options.seconds)
+			usleep(1000);
+		pool.stop();
+	}
+	double wallTime = headlessClock() - startTime;
+
+	printHeadlessReport(num_cols, num_rows, num_threads, generation, wallTime);
+}
+
+
 void initializeApplication(void)
 {
     //  Allocate 2D grids
@@ -265,6 +342,8 @@ void initializeApplication(void)
         currentGrid[i] = new unsigned int[num_cols];
         nextGrid[i] = new unsigned int[num_cols];
     }
+	displayRows = new unsigned int*[num_rows];
+	bandSync = new BandSync[MAX_NUM_THREADS];
 	
 	//---------------------------------------------------------------
 	//	All the code below to be replaced/removed
@@ -284,75 +363,287 @@ void initializeApplication(void)
 //	Implement this function
 //---------------------------------------------------------------------
 
-void* threadFunc(void* arg)
+//	Rows [start_row, end_row) handled by thread index (out of count).
+//	The last band absorbs the remainder of the division.
+void bandRows(unsigned int index, unsigned int count, unsigned int* start_row, unsigned int* end_row)
 {
-	ThreadInfo* info = (ThreadInfo*) arg;
-	
-	while (true) {
-		
-		for (unsigned int i = info->start_row; i < info->end_row; i++)
+	unsigned int row_per_thread = num_rows / count;
+	*start_row = index * row_per_thread;
+	*end_row = (index == count - 1) ? num_rows : (index + 1) * row_per_thread;
+}
+
+//	Computes into dst the next state of rows [start_row, end_row) of src.
+//	The stop token is polled at each row so that shutting down or resizing
+//	the pool never waits for a whole band.  Returns false if interrupted.
+bool computeRows(unsigned int** src, unsigned int** dst, unsigned int start_row, unsigned int end_row,
+				 std::stop_token stop)
+{
+	for (unsigned int i = start_row; i < end_row; i++)
+	{
+		if (stop.stop_requested())
+			return false;
+
+		for (unsigned int j = 0; j < num_cols; j++)
 		{
-			for (unsigned int j = 0; j < num_cols; j++)
+			unsigned int newState = cellNewState(src, i, j);
+
+			//	In black and white mode, only alive/dead matters
+			//	Dead is dead in any mode
+			if (colorMode == 0 || newState == 0) 
+				dst[i][j] = newState;
+			
+			//	in color mode, color reflext the "age" of a live cell
+			else 
 			{
-				unsigned int newState = cellNewState(i, j);
-
-				//	In black and white mode, only alive/dead matters
-				//	Dead is dead in any mode
-				if (colorMode == 0 || newState == 0) 
-					nextGrid[i][j] = newState;
-				
-				//	in color mode, color reflext the "age" of a live cell
-				else 
-				{
-					//	Any cell that has not yet reached the "very old cell"
-					//	stage simply got one generation older
-					if (currentGrid[i][j] < NB_COLORS - 1)
-						nextGrid[i][j] = currentGrid[i][j] + 1;
-					//	An old cell remains old until it dies
-					else
-						nextGrid[i][j] = currentGrid[i][j];
-				}
+				//	Any cell that has not yet reached the "very old cell"
+				//	stage simply got one generation older
+				if (src[i][j] < NB_COLORS - 1)
+					dst[i][j] = src[i][j] + 1;
+				//	An old cell remains old until it dies
+				else
+					dst[i][j] = src[i][j];
 			}
 		}
+	}
+	return true;
+}
 
-		pthread_mutex_lock(&counter_lock);
-		done++;
+//	Computes the next state of the band of rows assigned to thread index
+//	(out of count).
+void threadFunc(unsigned int index, unsigned int count, std::stop_token stop)
+{
+	unsigned int start_row, end_row;
+	bandRows(index, count, &start_row, &end_row);
+
+	computeRows(currentGrid, nextGrid, start_row, end_row, stop);
+}
+
+//	Called by the last thread to reach the barrier, while all the others
+//	are blocked.  A generation interrupted by a stop is simply dropped:
+//	currentGrid is still intact and will be recomputed from.
+//	In wavefront mode, we only get here when the pool is stopped (or all
+//	bands are done in headless mode), and the bands must first be brought
+//	back to a common generation.
+//	Returns false to end the run (in headless mode, after maxGenerations).
+bool endOfGeneration(bool completed)
+{
+	#if SYNC_MODE == SYNC_WAVEFRONT
+
+		(void) completed;
+		realignBands(pool.size());
+		return false;
+
+	#else
+
+		if (!completed)
+			return false;
+
+		swapGrids();
+		generation++;
+		pacer.pace(1, pool.stopToken());
+
+		return maxGenerations == 0 || (unsigned long) generation < maxGenerations;
+
+	#endif
+}
+
+//	Wavefront version of the thread function.  It never returns on its
+//	own: the band keeps going from one generation to the next, only waiting
+//	for its neighbors, until a stop is requested.
+//	Waiting for the neighbors to have published the edges of generation g
+//	before computing g+1 also guarantees that they are done reading our
+//	edge rows of generation g-1, which is what we overwrite in wfGrid[(g+1)%2]
+//	(their interior rows never read ours).
+void wavefrontThreadFunc(unsigned int index, unsigned int count, std::stop_token stop)
+{
+	unsigned int start_row, end_row;
+	bandRows(index, count, &start_row, &end_row);
+	BandSync& self = bandSync[index];
+
+	while (!stop.stop_requested())
+	{
+		unsigned int g = self.generation.load(std::memory_order_relaxed);
+
+		//	headless run: every band stops at the same generation
+		if (maxGenerations > 0 && g >= maxGenerations)
+			return;
 
-		if (done == num_threads) 
+		if (index > 0 && !waitForBand(index - 1, g, stop))
+			return;
+		if (index < count - 1 && !waitForBand(index + 1, g, stop))
+			return;
+
+		unsigned int** src = wfGrid[g % 2];
+		unsigned int** dst = wfGrid[(g + 1) % 2];
+
+		//	Edge rows first, so that the neighbors can move on to g+1 while
+		//	we compute our interior
+		if (!computeRows(src, dst, start_row, start_row + 1, stop) ||
+			(end_row - 1 > start_row && !computeRows(src, dst, end_row - 1, end_row, stop)))
+			return;
 		{
-			pthread_mutex_unlock(&counter_lock);
+			std::lock_guard<std::mutex> guard(self.lock);
+			self.edgeGeneration.store(g + 1, std::memory_order_release);
+		}
+		self.published.notify_all();
 
-			swapGrids();
-			usleep(speed);
-			done = 0;
-			generation++;  
+		if (end_row - start_row > 2 && !computeRows(src, dst, start_row + 1, end_row - 1, stop))
+			return;
 
-			for (unsigned int k = 0; k < num_threads; k++) 
-				if (k != info->index)
-					pthread_mutex_unlock(&(thread_data[k].lock));
+		for (unsigned int i = start_row; i < end_row; i++)
+			displayRows[i] = dst[i];
+		self.generation.store(g + 1, std::memory_order_relaxed);
+
+		//	The first band sets the pace: no other band can get more than
+		//	a few generations ahead of it
+		if (index == 0)
+		{
+			generation++;
+			pacer.pace(1, stop);
 		}
-		else 
+	}
+}
+
+//	Blocks until band has published its edge rows for generation gen.
+//	Returns false if a stop was requested in the meantime.
+bool waitForBand(unsigned int band, unsigned int gen, std::stop_token stop)
+{
+	BandSync& other = bandSync[band];
+
+	//	fast path: no need to lock if the neighbor is already there
+	if (other.edgeGeneration.load(std::memory_order_acquire) >= gen)
+		return true;
+
+	std::unique_lock<std::mutex> lock(other.lock);
+	return other.published.wait(lock, stop, [&other, gen] {
+		return other.edgeGeneration.load(std::memory_order_acquire) >= gen;
+	});
+}
+
+//	Called with all workers stopped.  Finishes the generations needed to
+//	bring every band to the most advanced one, then makes that generation
+//	the current grid, so that the pool can be restarted (possibly with a
+//	different number of bands) from a consistent state.
+void realignBands(unsigned int count)
+{
+	unsigned int target = 0;
+	for (unsigned int k = 0; k < count; k++)
+		if (bandSync[k].generation > target)
+			target = bandSync[k].generation;
+	unsigned int lead = bandSync[0].generation;
+
+	//	The least advanced band always has neighbors whose edges are at least
+	//	as far as itself, so each sweep makes progress.
+	bool lagging = true;
+	while (lagging)
+	{
+		lagging = false;
+		for (unsigned int k = 0; k < count; k++)
 		{
-			pthread_mutex_unlock(&counter_lock);
+			unsigned int g = bandSync[k].generation;
+			if (g == target)
+				continue;
+			lagging = true;
+
+			unsigned int start_row, end_row;
+			bandRows(k, count, &start_row, &end_row);
+			unsigned int** src = wfGrid[g % 2];
+			unsigned int** dst = wfGrid[(g + 1) % 2];
+
+			//	Edges that were already published must not be recomputed: the
+			//	neighbors' halo rows they were computed from may be gone.
+			if (bandSync[k].edgeGeneration == g)
+			{
+				if ((k > 0 && bandSync[k-1].edgeGeneration < g) ||
+					(k < count - 1 && bandSync[k+1].edgeGeneration < g))
+					continue;
 
-			pthread_mutex_lock(&(info->lock));
+				computeRows(src, dst, start_row, start_row + 1, std::stop_token());
+				computeRows(src, dst, end_row - 1, end_row, std::stop_token());
+				bandSync[k].edgeGeneration = g + 1;
+			}
+			if (end_row - start_row > 2)
+				computeRows(src, dst, start_row + 1, end_row - 1, std::stop_token());
+			bandSync[k].generation = g + 1;
 		}
 	}
-	return nullptr;
+
+	//	the generation counter follows the first band
+	generation += target - lead;
+
+	currentGrid = wfGrid[target % 2];
+	nextGrid = wfGrid[(target + 1) % 2];
+	resetBands();
+}
+
+//	Restarts the wavefront from currentGrid, at generation 0
+void resetBands(void)
+{
+	wfGrid[0] = currentGrid;
+	wfGrid[1] = nextGrid;
+	for (unsigned int k = 0; k < MAX_NUM_THREADS; k++)
+	{
+		bandSync[k].generation = 0;
+		bandSync[k].edgeGeneration = 0;
+	}
+	for (unsigned int i = 0; i < num_rows; i++)
+		displayRows[i] = currentGrid[i];
 }
 
+//	Entry point to resize the pool at runtime.  The request is clamped to
+//	a valid count.  The generations after the one in flight are split in
+//	bands for the new number of threads.  The wavefront bands never all
+//	end a generation together: they are realigned and restarted.
+void requestThreadCount(unsigned int n)
+{
+	if (n < 1)
+		n = 1;
+	if (n > num_rows)
+		n = num_rows;
+	if (n > (unsigned int) MAX_NUM_THREADS)
+		n = MAX_NUM_THREADS;
+
+	num_threads = n;
+	#if SYNC_MODE == SYNC_WAVEFRONT
+		pool.stop();
+	#endif
+	pool.resize(n);
+}
+
+void moreThreads(void)
+{
+	requestThreadCount(num_threads + 1);
+}
+
+void fewerThreads(void)
+{
+	if (num_threads > 1)
+		requestThreadCount(num_threads - 1);
+}
+
+//	Speed changes are 10% of the target generation rate.  They have no
+//	effect while the simulation is unthrottled.
 void faster(void)
 {
-	if (speed > 11)
-	speed = 9 * speed / 10;
+	if (!pacer.isUnthrottled())
+		pacer.setRate(11 * pacer.rate() / 10);
 }
 void slower(void)
 {
-	speed = 11 * speed / 10;
+	if (!pacer.isUnthrottled())
+		pacer.setRate(9 * pacer.rate() / 10);
+}
+void toggleUnthrottled(void)
+{
+	pacer.toggleUnthrottled();
 }
 
 void resetGrid(void)
 {
+	//	The threads must not be computing while we overwrite the grid
+	bool wasRunning = pool.isRunning();
+	pool.stop();
+
 	for (unsigned int i=0; i<num_rows; i++)
 	{
 		for (unsigned int j=0; j<num_cols; j++)
@@ -361,6 +652,10 @@ void resetGrid(void)
 		}
 	}
 	swapGrids();
+	resetBands();
+
+	if (wasRunning)
+		pool.resize(num_threads);
 }
 
 //	This function swaps the current and next grids, as well as their
@@ -378,7 +673,7 @@ void swapGrids(void)
 //	of a slightly different algorithm, allowing for changes at the border
 //	All three variants are used for simulations in research applications.
 //	I also refer explicitly to the S/B elements of the "rule" in place.
-unsigned int cellNewState(unsigned int i, unsigned int j)
+unsigned int cellNewState(unsigned int** grid, unsigned int i, unsigned int j)
 {
 	//	First count the number of neighbors that are alive
 	//----------------------------------------------------
@@ -391,14 +686,14 @@ unsigned int cellNewState(unsigned int i, unsigned int j)
 	if (i>0 && i<num_rows-1 && j>0 && j<num_cols-1)
 	{
 		//	remember that in C, (x == val) is either 1 or 0
-		count = (currentGrid[i-1][j-1] != 0) +
-				(currentGrid[i-1][j] != 0) +
-				(currentGrid[i-1][j+1] != 0)  +
-				(currentGrid[i][j-1] != 0)  +
-				(currentGrid[i][j+1] != 0)  +
-				(currentGrid[i+1][j-1] != 0)  +
-				(currentGrid[i+1][j] != 0)  +
-				(currentGrid[i+1][j+1] != 0);
+		count = (grid[i-1][j-1] != 0) +
+				(grid[i-1][j] != 0) +
+				(grid[i-1][j+1] != 0)  +
+				(grid[i][j-1] != 0)  +
+				(grid[i][j+1] != 0)  +
+				(grid[i+1][j-1] != 0)  +
+				(grid[i+1][j] != 0)  +
+				(grid[i+1][j+1] != 0);
 	}
 	//	on the border of the frame...
 	else
@@ -416,26 +711,26 @@ unsigned int cellNewState(unsigned int i, unsigned int j)
 	
 			if (i>0)
 			{
-				if (j>0 && currentGrid[i-1][j-1] != 0)
+				if (j>0 && grid[i-1][j-1] != 0)
 					count++;
-				if (currentGrid[i-1][j] != 0)
+				if (grid[i-1][j] != 0)
 					count++;
-				if (j<num_cols-1 && currentGrid[i-1][j+1] != 0)
+				if (j<num_cols-1 && grid[i-1][j+1] != 0)
 					count++;
 			}
 
-			if (j>0 && currentGrid[i][j-1] != 0)
+			if (j>0 && grid[i][j-1] != 0)
 				count++;
-			if (j<num_cols-1 && currentGrid[i][j+1] != 0)
+			if (j<num_cols-1 && grid[i][j+1] != 0)
 				count++;
 
 			if (i<num_rows-1)
 			{
-				if (j>0 && currentGrid[i+1][j-1] != 0)
+				if (j>0 && grid[i+1][j-1] != 0)
 					count++;
-				if (currentGrid[i+1][j] != 0)
+				if (grid[i+1][j] != 0)
 					count++;
-				if (j<num_cols-1 && currentGrid[i+1][j+1] != 0)
+				if (j<num_cols-1 && grid[i+1][j+1] != 0)
 					count++;
 			}
 			
@@ -446,14 +741,14 @@ unsigned int cellNewState(unsigned int i, unsigned int j)
 							iP1 = (i+1)%num_rows,
 							jM1 = (j+num_cols-1)%num_cols,
 							jP1 = (j+1)%num_cols;
-			count = currentGrid[iM1][jM1] != 0 +
-					currentGrid[iM1][j] != 0 +
-					currentGrid[iM1][jP1] != 0  +
-					currentGrid[i][jM1] != 0  +
-					currentGrid[i][jP1] != 0  +
-					currentGrid[iP1][jM1] != 0  +
-					currentGrid[iP1][j] != 0  +
-					currentGrid[iP1][jP1] != 0 ;
+			count = grid[iM1][jM1] != 0 +
+					grid[iM1][j] != 0 +
+					grid[iM1][jP1] != 0  +
+					grid[i][jM1] != 0  +
+					grid[i][jP1] != 0  +
+					grid[iP1][jM1] != 0  +
+					grid[iP1][j] != 0  +
+					grid[iP1][jP1] != 0 ;
 
 		#else
 			#error undefined frame behavior
@@ -474,7 +769,7 @@ unsigned int cellNewState(unsigned int i, unsigned int j)
 		case GAME_OF_LIFE_RULE:
 
 			//	if the cell is currently occupied by a live cell, look at "Stay alive rule"
-			if (currentGrid[i][j] != 0)
+			if (grid[i][j] != 0)
 			{
 				if (count == 3 || count == 2)
 					newState = 1;
@@ -491,7 +786,7 @@ unsigned int cellNewState(unsigned int i, unsigned int j)
 		case CORAL_GROWTH_RULE:
 
 			//	if the cell is currently occupied by a live cell, look at "Stay alive rule"
-			if (currentGrid[i][j] != 0)
+			if (grid[i][j] != 0)
 			{
 				if (count > 3)
 					newState = 1;
@@ -508,7 +803,7 @@ unsigned int cellNewState(unsigned int i, unsigned int j)
 		case AMOEBA_RULE:
 
 			//	if the cell is currently occupied by a live cell, look at "Stay alive rule"
-			if (currentGrid[i][j] != 0)
+			if (grid[i][j] != 0)
 			{
 				if (count == 1 || count == 3 || count == 5 || count == 8)
 					newState = 1;
@@ -525,7 +820,7 @@ unsigned int cellNewState(unsigned int i, unsigned int j)
 		case MAZE_RULE:
 
 			//	if the cell is currently occupied by a live cell, look at "Stay alive rule"
-			if (currentGrid[i][j] != 0)
+			if (grid[i][j] != 0)
 			{
 				if (count >= 1 && count <= 5)
 					newState = 1;
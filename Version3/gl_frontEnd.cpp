@@ -29,6 +29,7 @@ void* threadFunc(void*);
 void cleanupAndQuit(void);
 void faster(void);
 void slower(void);
+void toggleUnthrottled(void);
 
 //---------------------------------------------------------------------------
 //  Defined in main.c --> don't touch
@@ -238,16 +239,27 @@ void displayTextualInfo(const char* infoStr, int xPos, int yPos, int isLarge)
 
 
 
-void drawState(unsigned int numLiveThreads)
+//	A targetRate of 0 means that the simulation is unthrottled
+void drawState(unsigned int numLiveThreads, double achievedRate, double targetRate, const char* rateUnit)
 {
 	const int H_PAD = STATE_PANE_WIDTH / 16;
 	const int TOP_LEVEL_TXT_Y = 4*STATE_PANE_HEIGHT / 5;
+	const int LINE_SPACING = STATE_PANE_HEIGHT / 20;
 
 	//	Build, then display text info for the red, green, and blue tanks
 	char infoStr[256];
 	//	display info about number of live threads
 	sprintf(infoStr, "Live Threads: %d", numLiveThreads);
 	displayTextualInfo(infoStr, H_PAD, TOP_LEVEL_TXT_Y, 1);
+
+	//	display the achieved and target simulation rates
+	sprintf(infoStr, "Rate: %.1f %s", achievedRate, rateUnit);
+	displayTextualInfo(infoStr, H_PAD, TOP_LEVEL_TXT_Y - LINE_SPACING, 0);
+	if (targetRate > 0.)
+		sprintf(infoStr, "Target: %.1f %s", targetRate, rateUnit);
+	else
+		sprintf(infoStr, "Target: unthrottled");
+	displayTextualInfo(infoStr, H_PAD, TOP_LEVEL_TXT_Y - 2*LINE_SPACING, 0);
 }
 
 
@@ -358,6 +370,11 @@ void myKeyboard(unsigned char c, int x, int y)
 			slower();
 			break;
 
+		//	'u' --> toggles on/off unthrottled simulation
+		case 'u':
+			toggleUnthrottled();
+			break;
+
 		//	'1' --> apply Rule 1 (Game of Life: B23/S3)
 		case '1':
 			rule = GAME_OF_LIFE_RULE;
@@ -461,7 +478,7 @@ void myMenuHandler(int choice)
 	{
 		//	Exit/Quit
 		case QUIT_MENU:
-			exit(0);
+			cleanupAndQuit();
 			break;
 		
 		//	Do something
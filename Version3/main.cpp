@@ -1,7 +1,11 @@
 //
 //  main.c
 //  Cellular Automaton
-// g++ -Wall -std=c++20 main.cpp gl_frontEnd.cpp -framework OpenGL -framework GLUT -o cell
+//
+// Headless (no window, unthrottled):  ./cell <num_cols> <num_rows> <num_threads> -g <generations>
+//                                     ./cell <num_cols> <num_rows> <num_threads> -t <seconds>
+//	(here a "generation" is num_cols*num_rows random cell updates)
+// g++ -Wall -std=c++20 main.cpp gl_frontEnd.cpp ../Engine/libcellengine.a -framework OpenGL -framework GLUT -o cell
 
  /*-------------------------------------------------------------------------+
  |	A graphic front end for a grid+state simulation.						|
@@ -26,6 +30,7 @@
  |																			|
  |		- '+' --> increase simulation speed									|
  |		- '-' --> reduce simulation speed									|
+ |		- 'u' --> toggle unthrottled simulation speed on/off				|
  |																			|
  |		- '1' --> apply Rule 1 (Conway's classical Game of Life: B3/S23)	|
  |		- '2' --> apply Rule 2 (Coral: B3/S45678)							|
@@ -41,17 +46,13 @@
 #include <iostream>
 #include <cstdlib>
 #include <random>
+#include <stop_token>
+#include <pthread.h>
 //
 #include "gl_frontEnd.h"
-
-//==================================================================================
-//	Custom data types
-//==================================================================================
-using ThreadInfo = struct
-{
-	pthread_t threadID;
-	unsigned int index;
-};
+#include "../Engine/workerPool.h"
+#include "../Engine/pacer.h"
+#include "../Engine/headless.h"
 
 //==================================================================================
 //	Function prototypes
@@ -59,7 +60,8 @@ using ThreadInfo = struct
 void displayGridPane(void);
 void displayStatePane(void);
 void initializeApplication(void);
-void* threadFunc(void*);
+void runHeadless(const HeadlessOptions& options);
+void threadFunc(unsigned int index, unsigned int count, std::stop_token stop);
 void swapGrids(void);
 unsigned int cellNewState(unsigned int i, unsigned int j);
 // void* read_from_pipe(void*);
@@ -104,17 +106,20 @@ pthread_mutex_t** cell_locks;
 unsigned int num_rows, num_cols;
 unsigned int num_threads;
 
-//	the number of live threads (that haven't terminated yet)
-unsigned int numLiveThreads = num_threads;
+//	The persistent compute threads.  In this version they never meet at
+//	the pool's barrier: each one keeps updating random cells until the
+//	pool is stopped.
+WorkerPool pool;
 
 unsigned int rule = GAME_OF_LIFE_RULE;
 
 unsigned int colorMode = 0;
 
-ThreadInfo* info;
-
-// global variable for sleep time between generations
-unsigned int stime = 100;
+//	Paces the simulation at a target number of cell updates per second,
+//	shared by all the threads.  The default rate is set in main(), for
+//	the number of threads.
+const double DEFAULT_UPDATE_RATE_PER_THREAD = 10000.;
+Pacer pacer;
 
 unsigned int done = 0;
 
@@ -158,7 +163,7 @@ void displayStatePane(void)
 	//	about the state of the simulation.
 	//
 	//---------------------------------------------------------
-	drawState(num_threads);
+	drawState(pool.liveCount(), pacer.measuredRate(), pacer.rate(), "updates/s");
 	
 	//	This is OpenGL/glut magic.  Don't touch
 	glutSwapBuffers();
@@ -171,11 +176,14 @@ void displayStatePane(void)
 
 int main(int argc, char** argv)
 {
-    // Verify that three arguments were passed
-    if (argc != 4) {
-        std::cerr << "Usage: " << argv[0] << " <num_cols> <num_rows> <num_threads>\n";
+    // Verify that three arguments (plus the optional headless ones) were passed
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <num_cols> <num_rows> <num_threads> " << HEADLESS_USAGE << "\n";
         return 1;
     }
+	HeadlessOptions headless;
+	if (!parseHeadlessOptions(argc, argv, 4, &headless))
+		return 1;
 
     // Parse arguments and check for validity
     num_cols = std::atoi(argv[1]);
@@ -191,6 +199,12 @@ int main(int argc, char** argv)
 	//	I allocate an array of ThreadInfo
 
 
+	if (headless.enabled)
+	{
+		runHeadless(headless);
+		return 0;
+	}
+
     // This takes care of initializing glut and the GUI.
     // You shouldn’t have to touch this
     initializeFrontEnd(argc, argv, displayGridPane, displayStatePane);
@@ -202,26 +216,8 @@ int main(int argc, char** argv)
 	// pthread_create(&ReaderID, NULL, &read_from_pipe, NULL);
 
     // Now would be the place & time to create mutex locks and threads
-	info = (ThreadInfo*) calloc(num_threads, sizeof(ThreadInfo)); 
-
-	for (unsigned int i = 0; i < num_threads; i++) 
-	{
-		info[i].index = i;
-	}
-	for (unsigned int k = 0; k < num_threads; k++) 
-	{	
-		int code = pthread_create(&info[k].threadID, NULL, threadFunc, info+k);
-		
-		if (code < 0)
-			std::cerr << "Thread creation failed " << code << std::endl;
-
-	}
-	#if VERSION == MULTI_THREADED
-
-		for (unsigned int i = 0; i < num_rows; i++)
-			for (unsigned int j = 0; j < num_cols; j++) pthread_mutex_destroy(&cell_locks[i][j]);
-		
-	#endif
+	pacer.setRate(DEFAULT_UPDATE_RATE_PER_THREAD * num_threads);
+	pool.start(num_threads, threadFunc);
 
     // Now we enter the main loop of the program and to a large extent
     // "lose control" over its execution. The callback functions that
@@ -245,24 +241,70 @@ void cleanupAndQuit(void)
 	//	Free allocated resource before leaving (not absolutely needed, but
 	//	just nicer.  Also, if you crash there, you know something is wrong
 	//	in your code.
-    for (unsigned int i=1; i<num_rows; i++)
+	//	Stop and join the compute threads before their locks and grid go away
+	pool.stop();
+
+    for (unsigned int i=0; i<num_rows; i++)
     {
+		#if VERSION == MULTI_THREADED
+			for (unsigned int j = 0; j < num_cols; j++)
+				pthread_mutex_destroy(&cell_locks[i][j]);
+		#endif
+		delete []cell_locks[i];
         delete []grid[i];
     }
+	delete []cell_locks;
 	delete []grid;
 
 	exit(0);
 }
 
 
+//	Speed changes are 10% of the target update rate.  They have no
+//	effect while the simulation is unthrottled.
 void faster(void) {
-	if (stime > 11)
-		stime = 9 * stime / 10;
+	if (!pacer.isUnthrottled())
+		pacer.setRate(11 * pacer.rate() / 10);
 }
 
 
 void slower(void) {
-	stime = 11 * stime / 10;
+	if (!pacer.isUnthrottled())
+		pacer.setRate(9 * pacer.rate() / 10);
+}
+
+
+void toggleUnthrottled(void) {
+	pacer.toggleUnthrottled();
+}
+
+
+//	Runs the simulation without any window and as fast as possible, for
+//	a number of "generations" (num_rows*num_cols cell updates each) or a
+//	duration, then reports the throughput.
+void runHeadless(const HeadlessOptions& options)
+{
+	initializeApplication();
+	pacer.setRate(0.);
+
+	double cells = (double) num_rows * num_cols;
+	double startTime = headlessClock();
+	pool.start(num_threads, threadFunc);
+
+	if (options.generations > 0)
+	{
+		while (pacer.eventCount() < options.generations * cells)
+			usleep(1000);
+	}
+	else
+	{
+		while (headlessClock() - startTime < options.seconds)
+			usleep(1000);
+	}
+	pool.stop();
+	double wallTime = headlessClock() - startTime;
+
+	printHeadlessReport(num_cols, num_rows, num_threads, pacer.eventCount() / cells, wallTime);
 }
 
 
@@ -313,10 +355,14 @@ void freeLocks(unsigned int row, unsigned int col) {
 //	Implement this function
 //---------------------------------------------------------------------
 
-void* threadFunc(void* arg)
+//	Keeps updating randomly picked cells until a stop is requested.
+//	There is no notion of generation here, so the task never returns on
+//	its own.
+void threadFunc(unsigned int index, unsigned int count, std::stop_token stop)
 {
-	(void)arg;
-	while (true)
+	(void) index;
+	(void) count;
+	while (!stop.stop_requested())
 	{
 		// Use a thread-local random number generator
 		static thread_local std::mt19937 generator(std::random_device{}());
@@ -347,9 +393,10 @@ void* threadFunc(void* arg)
 		}
 			
 		freeLocks(i, j);
-		usleep(stime);
+
+		//	Only actually sleeps when we are far enough ahead of the schedule
+		pacer.pace(1, stop);
 	}
-	return NULL;
 }
 
 